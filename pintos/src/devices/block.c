@@ -1,9 +1,12 @@
 #include "devices/block.h"
+#include <kstats.h>
 #include <list.h>
 #include <string.h>
 #include <stdio.h>
 #include "devices/ide.h"
+#include "devices/timer.h"
 #include "threads/malloc.h"
+#include "threads/thread.h"
 
 /* A block device. */
 struct block
@@ -19,6 +22,8 @@ struct block
 
     unsigned long long read_cnt;        /* Number of sectors read. */
     unsigned long long write_cnt;       /* Number of sectors written. */
+    unsigned long long latency[KSTATS_LATENCY_BUCKETS];
+                                        /* Histogram of request times. */
   };
 
 /* List of all block devices. */
@@ -28,6 +33,8 @@ static struct list all_blocks = LIST_INITIALIZER (all_blocks);
 static struct block *block_by_role[BLOCK_ROLE_CNT];
 
 static struct block *list_elem_to_block (struct list_elem *);
+static void record_latency (struct block *, int64_t start, size_t cnt);
+static void account_io (struct block *, size_t cnt, bool write);
 
 /* Returns a human-readable name for the given block device
    TYPE. */
@@ -120,10 +127,13 @@ check_sector (struct block *block, block_sector_t sector)
 void
 block_read (struct block *block, block_sector_t sector, void *buffer)
 {
+  int64_t start;
+
   check_sector (block, sector);
+  start = timer_usecs ();
   block->ops->read (block->aux, sector, buffer);
-  
-  block->read_cnt++;
+  record_latency (block, start, 1);
+  account_io (block, 1, false);
 }
 
 /* Write sector SECTOR to BLOCK from BUFFER, which must contain
@@ -134,10 +144,109 @@ block_read (struct block *block, block_sector_t sector, void *buffer)
 void
 block_write (struct block *block, block_sector_t sector, const void *buffer)
 {
+  int64_t start;
+
   check_sector (block, sector);
   ASSERT (block->type != BLOCK_FOREIGN);
+  start = timer_usecs ();
   block->ops->write (block->aux, sector, buffer);
-  block->write_cnt++;
+  record_latency (block, start, 1);
+  account_io (block, 1, true);
+}
+
+/* Reads CNT consecutive sectors starting at SECTOR from BLOCK
+   into BUFFER, which must have room for CNT * BLOCK_SECTOR_SIZE
+   bytes.  If the device supports it, the sectors are read with
+   a few large requests instead of one request per sector.
+   Internally synchronizes accesses to block devices, so external
+   per-block device locking is unneeded. */
+void
+block_read_multiple (struct block *block, block_sector_t sector, size_t cnt,
+                     void *buffer)
+{
+  int64_t start;
+  size_t i;
+
+  if (cnt == 0)
+    return;
+  check_sector (block, sector);
+  check_sector (block, sector + cnt - 1);
+  start = timer_usecs ();
+  if (block->ops->read_multiple != NULL)
+    block->ops->read_multiple (block->aux, sector, cnt, buffer);
+  else
+    for (i = 0; i < cnt; i++)
+      block->ops->read (block->aux, sector + i,
+                        (uint8_t *) buffer + i * BLOCK_SECTOR_SIZE);
+  record_latency (block, start, cnt);
+  account_io (block, cnt, false);
+}
+
+/* Writes CNT consecutive sectors starting at SECTOR to BLOCK
+   from BUFFER, which must contain CNT * BLOCK_SECTOR_SIZE bytes,
+   as block_read_multiple() does for reads.  Returns after the
+   block device has acknowledged receiving all the data. */
+void
+block_write_multiple (struct block *block, block_sector_t sector, size_t cnt,
+                      const void *buffer)
+{
+  int64_t start;
+  size_t i;
+
+  if (cnt == 0)
+    return;
+  check_sector (block, sector);
+  check_sector (block, sector + cnt - 1);
+  ASSERT (block->type != BLOCK_FOREIGN);
+  start = timer_usecs ();
+  if (block->ops->write_multiple != NULL)
+    block->ops->write_multiple (block->aux, sector, cnt, buffer);
+  else
+    for (i = 0; i < cnt; i++)
+      block->ops->write (block->aux, sector + i,
+                         (const uint8_t *) buffer + i * BLOCK_SECTOR_SIZE);
+  record_latency (block, start, cnt);
+  account_io (block, cnt, true);
+}
+
+/* Counts CNT sectors read from or, if WRITE, written to BLOCK,
+   for the device and for the running thread's getrusage().
+   Partitions pass their I/O on to a raw disk, which the thread
+   is not charged for again.  Swap is not charged either: a page
+   evicted to swap belongs to some other process as often as
+   not, and swap-ins have their own counter. */
+static void
+account_io (struct block *block, size_t cnt, bool write) 
+{
+  struct thread *t = thread_current ();
+
+  if (write)
+    block->write_cnt += cnt;
+  else
+    block->read_cnt += cnt;
+  if (block->type == BLOCK_RAW || block->type == BLOCK_SWAP)
+    return;
+  if (write)
+    t->ru.blocks_written += cnt;
+  else
+    t->ru.blocks_read += cnt;
+}
+
+/* Adds a request for CNT sectors to BLOCK that began at START, as
+   returned by timer_usecs(), to BLOCK's latency histogram.  Each
+   sector counts once, at the request's time per sector. */
+static void
+record_latency (struct block *block, int64_t start, size_t cnt) 
+{
+  int64_t usecs = (timer_usecs () - start) / cnt;
+  int bucket = 0;
+
+  while (usecs > 0 && bucket < KSTATS_LATENCY_BUCKETS - 1)
+    {
+      usecs >>= 1;
+      bucket++;
+    }
+  block->latency[bucket] += cnt;
 }
 
 /* Returns the number of sectors in BLOCK. */
@@ -179,6 +288,29 @@ block_print_stats (void)
     }
 }
 
+/* Copies the counters of each block device used for a Pintos
+   role into ST. */
+void
+block_get_stats (struct kstats *st) 
+{
+  int i;
+
+  for (i = 0; i < BLOCK_ROLE_CNT && i < KSTATS_BLOCK_MAX; i++)
+    {
+      struct block *block = block_by_role[i];
+      struct kstats_block *kb = &st->blocks[i];
+
+      memset (kb, 0, sizeof *kb);
+      if (block != NULL)
+        {
+          strlcpy (kb->name, block->name, sizeof kb->name);
+          kb->read_cnt = block->read_cnt;
+          kb->write_cnt = block->write_cnt;
+          memcpy (kb->latency, block->latency, sizeof kb->latency);
+        }
+    }
+}
+
 /* Registers a new block device with the given NAME.  If
    EXTRA_INFO is non-null, it is printed as part of a user
    message.  The block device's SIZE in sectors and its TYPE must
@@ -201,6 +333,7 @@ block_register (const char *name, enum block_type type,
   block->aux = aux;
   block->read_cnt = 0;
   block->write_cnt = 0;
+  memset (block->latency, 0, sizeof block->latency);
 
   printf ("%s: %'"PRDSNu" sectors (", block->name, block->size);
   print_human_readable_size ((uint64_t) block->size * BLOCK_SECTOR_SIZE);
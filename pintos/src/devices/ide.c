@@ -50,6 +50,11 @@
 #define CMD_READ_SECTOR_RETRY 0x20      /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30     /* WRITE SECTOR with retries. */
 
+/* Most sectors a single READ SECTOR or WRITE SECTOR command can
+   transfer.  A sector count of 0 in the command means this
+   many. */
+#define MAX_SECTORS_PER_CMD 256
+
 /* An ATA device. */
 struct ata_disk
   {
@@ -81,11 +86,12 @@ static struct channel channels[CHANNEL_CNT];
 
 static struct block_operations ide_operations;
 
-static void reset_channel (struct channel *);
+static void start_reset (struct channel *, bool present[2]);
+static void finish_reset (struct channel *, const bool present[2]);
 static bool check_device_type (struct ata_disk *);
 static void identify_ata_device (struct ata_disk *);
 
-static void select_sector (struct ata_disk *, block_sector_t);
+static void select_sector (struct ata_disk *, block_sector_t, size_t cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -101,6 +107,7 @@ static void interrupt_handler (struct intr_frame *);
 void
 ide_init (void) 
 {
+  bool present[CHANNEL_CNT][2];
   size_t chan_no;
 
   for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++)
@@ -142,7 +149,19 @@ ide_init (void)
       intr_register_ext (c->irq, interrupt_handler, c->name);
 
       /* Reset hardware. */
-      reset_channel (c);
+      start_reset (c, present[chan_no]);
+    }
+
+  /* Both channels reset at once, so one settling delay covers
+     them both. */
+  timer_msleep (150);
+
+  for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++)
+    {
+      struct channel *c = &channels[chan_no];
+      int dev_no;
+
+      finish_reset (c, present[chan_no]);
 
       /* Distinguish ATA hard disks from other devices. */
       if (check_device_type (&c->devices[0]))
@@ -159,12 +178,13 @@ ide_init (void)
 
 static char *descramble_ata_string (char *, int size);
 
-/* Resets an ATA channel and waits for any devices present on it
-   to finish the reset. */
+/* Detects which devices are present on ATA channel C, storing
+   the results in PRESENT[], and starts a reset of the channel.
+   The caller must wait at least 150 ms and then call
+   finish_reset(). */
 static void
-reset_channel (struct channel *c) 
+start_reset (struct channel *c, bool present[2]) 
 {
-  bool present[2];
   int dev_no;
 
   /* The ATA reset sequence depends on which devices are present,
@@ -195,9 +215,13 @@ reset_channel (struct channel *c)
   outb (reg_ctl (c), CTL_SRST);
   timer_usleep (10);
   outb (reg_ctl (c), 0);
+}
 
-  timer_msleep (150);
-
+/* Waits for the devices PRESENT on channel C to finish the reset
+   begun by start_reset(). */
+static void
+finish_reset (struct channel *c, const bool present[2]) 
+{
   /* Wait for device 0 to clear BSY. */
   if (present[0]) 
     {
@@ -337,63 +361,118 @@ descramble_ata_string (char *string, int size)
   return string;
 }
 
-/* Reads sector SEC_NO from disk D into BUFFER, which must have
-   room for BLOCK_SECTOR_SIZE bytes.
+/* Reads CNT sectors starting at SEC_NO from disk D into BUFFER,
+   which must have room for CNT * BLOCK_SECTOR_SIZE bytes.  Each
+   command transfers up to MAX_SECTORS_PER_CMD sectors, with an
+   interrupt as each one becomes ready.
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 static void
-ide_read (void *d_, block_sector_t sec_no, void *buffer)
+ide_read_multiple (void *d_, block_sector_t sec_no, size_t cnt, void *buffer)
 {
   struct ata_disk *d = d_;
   struct channel *c = d->channel;
+  uint8_t *p = buffer;
+
   lock_acquire (&c->lock);
-  select_sector (d, sec_no);
-  issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-  sema_down (&c->completion_wait);
-  if (!wait_while_busy (d))
-    PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-  input_sector (c, buffer);
+  while (cnt > 0)
+    {
+      size_t n = cnt < MAX_SECTORS_PER_CMD ? cnt : MAX_SECTORS_PER_CMD;
+      size_t i;
+
+      select_sector (d, sec_no, n);
+      issue_pio_command (c, CMD_READ_SECTOR_RETRY);
+      for (i = 0; i < n; i++)
+        {
+          sema_down (&c->completion_wait);
+          if (!wait_while_busy (d))
+            PANIC ("%s: disk read failed, sector=%"PRDSNu,
+                   d->name, sec_no + i);
+          input_sector (c, p);
+          p += BLOCK_SECTOR_SIZE;
+        }
+      sec_no += n;
+      cnt -= n;
+    }
   lock_release (&c->lock);
 }
 
-/* Write sector SEC_NO to disk D from BUFFER, which must contain
-   BLOCK_SECTOR_SIZE bytes.  Returns after the disk has
-   acknowledged receiving the data.
+/* Writes CNT sectors starting at SEC_NO to disk D from BUFFER,
+   which must contain CNT * BLOCK_SECTOR_SIZE bytes, as
+   ide_read_multiple() does for reads.  Returns after the disk
+   has acknowledged receiving all the data.
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 static void
-ide_write (void *d_, block_sector_t sec_no, const void *buffer)
+ide_write_multiple (void *d_, block_sector_t sec_no, size_t cnt,
+                    const void *buffer)
 {
   struct ata_disk *d = d_;
   struct channel *c = d->channel;
+  const uint8_t *p = buffer;
+
   lock_acquire (&c->lock);
-  select_sector (d, sec_no);
-  issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-  if (!wait_while_busy (d))
-    PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-  output_sector (c, buffer);
-  sema_down (&c->completion_wait);
+  while (cnt > 0)
+    {
+      size_t n = cnt < MAX_SECTORS_PER_CMD ? cnt : MAX_SECTORS_PER_CMD;
+      size_t i;
+
+      select_sector (d, sec_no, n);
+      issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
+      for (i = 0; i < n; i++)
+        {
+          if (!wait_while_busy (d))
+            PANIC ("%s: disk write failed, sector=%"PRDSNu,
+                   d->name, sec_no + i);
+          output_sector (c, p);
+          p += BLOCK_SECTOR_SIZE;
+          sema_down (&c->completion_wait);
+        }
+      sec_no += n;
+      cnt -= n;
+    }
   lock_release (&c->lock);
 }
 
+/* Reads sector SEC_NO from disk D into BUFFER, which must have
+   room for BLOCK_SECTOR_SIZE bytes. */
+static void
+ide_read (void *d, block_sector_t sec_no, void *buffer)
+{
+  ide_read_multiple (d, sec_no, 1, buffer);
+}
+
+/* Write sector SEC_NO to disk D from BUFFER, which must contain
+   BLOCK_SECTOR_SIZE bytes.  Returns after the disk has
+   acknowledged receiving the data. */
+static void
+ide_write (void *d, block_sector_t sec_no, const void *buffer)
+{
+  ide_write_multiple (d, sec_no, 1, buffer);
+}
+
 static struct block_operations ide_operations =
   {
     ide_read,
-    ide_write
+    ide_write,
+    ide_read_multiple,
+    ide_write_multiple
   };
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and the count CNT, which must be between 1 and
+   MAX_SECTORS_PER_CMD, to the disk's sector selection
+   registers.  (We use LBA mode.) */
 static void
-select_sector (struct ata_disk *d, block_sector_t sec_no)
+select_sector (struct ata_disk *d, block_sector_t sec_no, size_t cnt)
 {
   struct channel *c = d->channel;
 
   ASSERT (sec_no < (1UL << 28));
+  ASSERT (cnt >= 1 && cnt <= MAX_SECTORS_PER_CMD);
   
   select_device_wait (d);
-  outb (reg_nsect (c), 1);
+  outb (reg_nsect (c), cnt % MAX_SECTORS_PER_CMD);
   outb (reg_lbal (c), sec_no);
   outb (reg_lbam (c), sec_no >> 8);
   outb (reg_lbah (c), (sec_no >> 16));
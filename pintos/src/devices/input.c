@@ -41,6 +41,61 @@ input_getc (void)
   return key;
 }
 
+/* Reads up to SIZE bytes from the input buffer into BUF, which
+   must be in kernel memory, and returns the number read.  Waits
+   for the first byte.  After that, if LINE is true, keeps
+   waiting until a new-line or carriage return has been read or
+   BUF is full; otherwise, takes only the bytes already there. */
+size_t
+input_read (uint8_t *buf, size_t size, bool line) 
+{
+  enum intr_level old_level;
+  size_t n = 0;
+
+  if (size == 0)
+    return 0;
+
+  old_level = intr_disable ();
+  if (line)
+    {
+      uint8_t key;
+
+      do
+        {
+          /* The serial port stops receiving while the buffer is
+             full, so make sure it has resumed before waiting. */
+          if (intq_empty (&buffer))
+            serial_notify ();
+          key = buf[n++] = intq_getc (&buffer);
+        }
+      while (n < size && key != '\n' && key != '\r');
+    }
+  else
+    {
+      buf[n++] = intq_getc (&buffer);
+      n += intq_getn (&buffer, buf + n, size - n);
+    }
+  serial_notify ();
+  intr_set_level (old_level);
+
+  return n;
+}
+
+/* Returns the number of bytes in the input buffer, which is how
+   many input_read() can return without waiting in raw mode. */
+size_t
+input_poll (void) 
+{
+  enum intr_level old_level;
+  size_t n;
+
+  old_level = intr_disable ();
+  n = intq_count (&buffer);
+  intr_set_level (old_level);
+
+  return n;
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
@@ -31,6 +31,14 @@ intq_full (const struct intq *q)
   return next (q->head) == q->tail;
 }
 
+/* Returns the number of bytes in Q. */
+size_t
+intq_count (const struct intq *q) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  return (q->head - q->tail + INTQ_BUFSIZE) % INTQ_BUFSIZE;
+}
+
 /* Removes a byte from Q and returns it.
    If Q is empty, sleeps until a byte is added.
    When called from an interrupt handler, Q must not be empty. */
@@ -54,6 +62,24 @@ intq_getc (struct intq *q)
   return byte;
 }
 
+/* Removes up to SIZE bytes from Q into BUF and returns the
+   number removed, which is 0 if Q is empty.  Never sleeps. */
+size_t
+intq_getn (struct intq *q, uint8_t *buf, size_t size) 
+{
+  size_t n = 0;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  while (n < size && !intq_empty (q)) 
+    {
+      buf[n++] = q->buf[q->tail];
+      q->tail = next (q->tail);
+    }
+  if (n > 0)
+    signal (q, &q->not_full);
+  return n;
+}
+
 /* Adds BYTE to the end of Q.
    If Q is full, sleeps until a byte is removed.
    When called from an interrupt handler, Q must not be full. */
@@ -18,7 +18,7 @@
    handlers. */
 
 /* Queue buffer size, in bytes. */
-#define INTQ_BUFSIZE 64
+#define INTQ_BUFSIZE 256
 
 /* A circular queue of bytes. */
 struct intq
@@ -37,7 +37,9 @@ struct intq
 void intq_init (struct intq *);
 bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
+size_t intq_count (const struct intq *);
 uint8_t intq_getc (struct intq *);
+size_t intq_getn (struct intq *, uint8_t *, size_t);
 void intq_putc (struct intq *, uint8_t);
 
 #endif /* devices/intq.h */
@@ -11,9 +11,6 @@
 #define PIT_PORT_CONTROL          0x43                /* Control port. */
 #define PIT_PORT_COUNTER(CHANNEL) (0x40 + (CHANNEL))  /* Counter port. */
 
-/* PIT cycles per second. */
-#define PIT_HZ 1193180
-
 /* Configure the given CHANNEL in the PIT.  In a PC, the PIT's
    three output channels are hooked up like this:
 
@@ -81,3 +78,45 @@ pit_configure_channel (int channel, int mode, int frequency)
   outb (PIT_PORT_COUNTER (channel), count >> 8);
   intr_set_level (old_level);
 }
+
+/* Starts CHANNEL counting down from COUNT in mode 0, "interrupt
+   on terminal count": the channel's output goes low now and
+   rises, once, COUNT PIT cycles later.  A COUNT of 0 is treated
+   as 65536.  Unlike the periodic modes, the counter does not
+   reload when it reaches 0; it keeps counting down from 65535,
+   so pit_read_channel() can still tell how long ago that was. */
+void
+pit_start_countdown (int channel, uint16_t count)
+{
+  enum intr_level old_level;
+
+  ASSERT (channel == 0 || channel == 2);
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, (channel << 6) | 0x30);
+  outb (PIT_PORT_COUNTER (channel), count);
+  outb (PIT_PORT_COUNTER (channel), count >> 8);
+  intr_set_level (old_level);
+}
+
+/* Latches CHANNEL's current count and status with the
+   read-back command, stores the count into *COUNT, and returns
+   the level of the channel's output. */
+bool
+pit_read_channel (int channel, uint16_t *count)
+{
+  enum intr_level old_level;
+  uint8_t status, lo, hi;
+
+  ASSERT (channel == 0 || channel == 2);
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, 0xc0 | (2 << channel));
+  status = inb (PIT_PORT_COUNTER (channel));
+  lo = inb (PIT_PORT_COUNTER (channel));
+  hi = inb (PIT_PORT_COUNTER (channel));
+  intr_set_level (old_level);
+
+  *count = lo | (hi << 8);
+  return (status & 0x80) != 0;
+}
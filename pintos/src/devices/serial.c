@@ -1,7 +1,6 @@
 #include "devices/serial.h"
 #include <debug.h>
 #include "devices/input.h"
-#include "devices/intq.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
@@ -37,6 +36,13 @@
 #define IER_RECV 0x01           /* Interrupt when data received. */
 #define IER_XMIT 0x02           /* Interrupt when transmit finishes. */
 
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01         /* Enable receive and transmit FIFOs. */
+#define FCR_CLEAR 0x06          /* Clear both FIFOs. */
+
+/* Bytes the transmit FIFO accepts each time THR becomes empty. */
+#define TX_FIFO_SIZE 16
+
 /* Line Control Register bits. */
 #define LCR_N81 0x03            /* No parity, 8 data bits, 1 stop bit. */
 #define LCR_DLAB 0x80           /* Divisor Latch Access Bit (DLAB). */
@@ -51,11 +57,30 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/* Data to be transmitted, a circular buffer drained by
+   serial_interrupt().  Only touched with interrupts off.  Much
+   larger than the UART's FIFO so that writers can hand over a
+   whole burst of output and carry on without waiting. */
+#define TXQ_SIZE 4096
+static uint8_t txq[TXQ_SIZE];
+static size_t txq_head;         /* Next byte is written here. */
+static size_t txq_tail;         /* Next byte is sent from here. */
+
+/* Writers that found the transmit queue full sleep on TXQ_ROOM
+   until serial_interrupt() has drained it down to TXQ_LOW_WATER
+   bytes, so that each wakeup makes room for a good-sized chunk. */
+#define TXQ_LOW_WATER (TXQ_SIZE / 2)
+static struct semaphore txq_room;
+static int txq_waiters;         /* Number of threads sleeping on it. */
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
+static bool txq_empty (void);
+static bool txq_full (void);
+static size_t txq_count (void);
+static void txq_putc (uint8_t);
+static uint8_t txq_getc (void);
+static void txq_wake (void);
 static void write_ier (void);
 static intr_handler_func serial_interrupt;
 
@@ -71,7 +96,6 @@ init_poll (void)
   outb (FCR_REG, 0);                    /* Disable FIFO. */
   set_serial (9600);                    /* 9.6 kbps, N-8-1. */
   outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-  intq_init (&txq);
   mode = POLL;
 } 
 
@@ -87,7 +111,9 @@ serial_init_queue (void)
     init_poll ();
   ASSERT (mode == POLL);
 
+  sema_init (&txq_room, 0);
   intr_register_ext (0x20 + 4, serial_interrupt, "serial");
+  outb (FCR_REG, FCR_ENABLE | FCR_CLEAR);
   mode = QUEUE;
   old_level = intr_disable ();
   write_ier ();
@@ -97,32 +123,55 @@ serial_init_queue (void)
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) 
+{
+  serial_write (&byte, 1);
+}
+
+/* Sends the SIZE bytes in BUFFER to the serial port.  In queued
+   mode the bytes are added to the transmit queue and the caller
+   returns while the UART sends them.  If the queue fills up, the
+   caller sleeps until the UART has drained it, unless interrupts
+   were off on entry, in which case bytes are sent by polling. */
+void
+serial_write (const uint8_t *buffer, size_t size) 
 {
   enum intr_level old_level = intr_disable ();
 
   if (mode != QUEUE)
     {
       /* If we're not set up for interrupt-driven I/O yet,
-         use dumb polling to transmit a byte. */
+         use dumb polling to transmit. */
       if (mode == UNINIT)
         init_poll ();
-      putc_poll (byte); 
+      while (size-- > 0)
+        putc_poll (*buffer++); 
     }
   else 
     {
-      /* Otherwise, queue a byte and update the interrupt enable
-         register. */
-      if (old_level == INTR_OFF && intq_full (&txq)) 
+      /* Otherwise, queue the bytes and update the interrupt
+         enable register. */
+      while (size-- > 0) 
         {
-          /* Interrupts are off and the transmit queue is full.
-             If we wanted to wait for the queue to empty,
-             we'd have to reenable interrupts.
-             That's impolite, so we'll send a character via
-             polling instead. */
-          putc_poll (intq_getc (&txq)); 
+          while (txq_full ()) 
+            {
+              if (old_level == INTR_OFF) 
+                {
+                  /* Interrupts were off on entry, so the queue
+                     cannot drain while we wait and we may not
+                     sleep.  Send a byte by polling instead. */
+                  putc_poll (txq_getc ()); 
+                }
+              else 
+                {
+                  /* Sleep until serial_interrupt() makes room.
+                     Interrupts are on while we sleep. */
+                  write_ier ();
+                  txq_waiters++;
+                  sema_down (&txq_room);
+                }
+            }
+          txq_putc (*buffer++);
         }
-
-      intq_putc (&txq, byte); 
       write_ier ();
     }
   
@@ -135,8 +184,25 @@ void
 serial_flush (void) 
 {
   enum intr_level old_level = intr_disable ();
-  while (!intq_empty (&txq))
-    putc_poll (intq_getc (&txq));
+  while (!txq_empty ())
+    putc_poll (txq_getc ());
+  txq_wake ();
+  intr_set_level (old_level);
+}
+
+/* Flushes the serial buffer and transmits synchronously, by
+   polling, from then on.  For use when the kernel panics, since
+   interrupts may never be turned back on to drain the queue. */
+void
+serial_sync (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  if (mode == QUEUE) 
+    {
+      serial_flush ();
+      outb (IER_REG, 0);
+      mode = POLL;
+    }
   intr_set_level (old_level);
 }
 
@@ -182,7 +248,7 @@ write_ier (void)
 
   /* Enable transmit interrupt if we have any characters to
      transmit. */
-  if (!intq_empty (&txq))
+  if (!txq_empty ())
     ier |= IER_XMIT;
 
   /* Enable receive interrupt if we have room to store any
@@ -205,6 +271,61 @@ putc_poll (uint8_t byte)
   outb (THR_REG, byte);
 }
 
+/* Returns true if the transmit queue is empty. */
+static bool
+txq_empty (void) 
+{
+  return txq_head == txq_tail;
+}
+
+/* Returns true if the transmit queue is full. */
+static bool
+txq_full (void) 
+{
+  return (txq_head + 1) % TXQ_SIZE == txq_tail;
+}
+
+/* Returns the number of bytes in the transmit queue. */
+static size_t
+txq_count (void) 
+{
+  return (txq_head - txq_tail + TXQ_SIZE) % TXQ_SIZE;
+}
+
+/* Adds BYTE to the transmit queue, which must not be full. */
+static void
+txq_putc (uint8_t byte) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  txq[txq_head] = byte;
+  txq_head = (txq_head + 1) % TXQ_SIZE;
+}
+
+/* Removes and returns the oldest byte in the transmit queue,
+   which must not be empty. */
+static uint8_t
+txq_getc (void) 
+{
+  uint8_t byte;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (!txq_empty ());
+  byte = txq[txq_tail];
+  txq_tail = (txq_tail + 1) % TXQ_SIZE;
+  return byte;
+}
+
+/* Wakes the writers waiting for room in the transmit queue, if
+   it has drained down to TXQ_LOW_WATER bytes. */
+static void
+txq_wake (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  if (txq_waiters > 0 && txq_count () <= TXQ_LOW_WATER)
+    for (; txq_waiters > 0; txq_waiters--)
+      sema_up (&txq_room);
+}
+
 /* Serial interrupt handler. */
 static void
 serial_interrupt (struct intr_frame *f UNUSED) 
@@ -218,10 +339,16 @@ serial_interrupt (struct intr_frame *f UNUSED)
   while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
     input_putc (inb (RBR_REG));
 
-  /* As long as we have a byte to transmit, and the hardware is
-     ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
-    outb (THR_REG, intq_getc (&txq));
+  /* Once the transmitter is empty, refill its whole FIFO from
+     the transmit queue without checking the status between
+     bytes. */
+  if ((inb (LSR_REG) & LSR_THRE) != 0) 
+    {
+      int i;
+      for (i = 0; i < TX_FIFO_SIZE && !txq_empty (); i++)
+        outb (THR_REG, txq_getc ());
+    }
+  txq_wake ();
 
   /* Update interrupt enable register based on queue status. */
   write_ier ();
@@ -1,11 +1,14 @@
 #ifndef DEVICES_SERIAL_H
 #define DEVICES_SERIAL_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 void serial_init_queue (void);
 void serial_putc (uint8_t);
+void serial_write (const uint8_t *, size_t);
 void serial_flush (void);
+void serial_sync (void);
 void serial_notify (void);
 
 #endif /* devices/serial.h */
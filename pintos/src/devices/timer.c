@@ -1,10 +1,12 @@
 #include "devices/timer.h"
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stdio.h>
 #include "devices/pit.h"
 #include "threads/interrupt.h"
+#include "threads/smp.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
   
@@ -17,9 +19,49 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* The PIT runs in one-shot mode, reprogrammed at each interrupt
+   for the next event: normally the next tick, but when the CPU
+   is idle, the earliest sleeping thread's wakeup time, so that an
+   idle system takes no interrupts in between.  Time is kept in
+   PIT cycles ("counts") so that sleeps shorter than a tick can
+   be timed too. */
+
+/* PIT cycles per timer tick. */
+#define COUNTS_PER_TICK ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Longest interval the 16-bit PIT counter can time. */
+#define MAX_COUNTS 0xffff
+
+/* Sleeps shorter than this many PIT cycles (about 100 us)
+   busy-wait, since blocking would take longer. */
+#define MIN_SLEEP_COUNTS (PIT_HZ / 10000)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* PIT cycles since boot at which ticks next increments. */
+static int64_t next_tick_counts;
+
+/* Current countdown: started ARMED_AT counts after boot,
+   ARMED counts long. */
+static int64_t armed_at;
+static unsigned armed;
+
+/* Number of timer interrupts taken. */
+static int64_t interrupt_cnt;
+
+/* A thread in timer_usleep() or timer_nsleep() for less than a
+   tick. */
+struct short_sleeper
+  {
+    struct list_elem elem;      /* Element in short_sleepers. */
+    int64_t deadline;           /* Wake-up time, in PIT counts. */
+    struct semaphore sema;      /* Up'd at the deadline. */
+  };
+
+/* Short sleepers, ordered by deadline. */
+static struct list short_sleepers;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
@@ -29,13 +71,18 @@ static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
 static void real_time_delay (int64_t num, int32_t denom);
+static int64_t counts_now (void);
+static int64_t next_deadline (bool idle);
+static void arm (int64_t now, int64_t deadline);
 
 /* Sets up the timer to interrupt TIMER_FREQ times per second,
    and registers the corresponding interrupt. */
 void
 timer_init (void) 
 {
-  pit_configure_channel (0, 2, TIMER_FREQ);
+  list_init (&short_sleepers);
+  next_tick_counts = COUNTS_PER_TICK;
+  arm (0, next_tick_counts);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -66,6 +113,18 @@ timer_calibrate (void)
   printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
 }
 
+/* Sets loops_per_tick to LOOPS, as measured by timer_calibrate()
+   on an earlier boot, skipping the calibration loop. */
+void
+timer_set_loops_per_tick (unsigned loops) 
+{
+  ASSERT (loops != 0);
+
+  loops_per_tick = loops;
+  printf ("%'"PRIu64" loops/s (preset).\n",
+          (uint64_t) loops_per_tick * TIMER_FREQ);
+}
+
 /* Returns the number of timer ticks since the OS booted. */
 int64_t
 timer_ticks (void) 
@@ -76,6 +135,17 @@ timer_ticks (void)
   return t;
 }
 
+/* Returns the number of microseconds since the OS booted,
+   accurate to about a microsecond. */
+int64_t
+timer_usecs (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  int64_t counts = counts_now ();
+  intr_set_level (old_level);
+  return counts * 1000000 / PIT_HZ;
+}
+
 /* Returns the number of timer ticks elapsed since THEN, which
    should be a value once returned by timer_ticks(). */
 int64_t
@@ -160,19 +230,174 @@ timer_ndelay (int64_t ns)
 void
 timer_print_stats (void) 
 {
-  printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+  printf ("Timer: %"PRId64" ticks, %"PRId64" interrupts\n",
+          timer_ticks (), interrupt_cnt);
 }
 
+/* Called by the BSP's idle thread, with interrupts off, just
+   before it halts the CPU, if every other CPU is idle too.
+   Pushes the next timer interrupt out to the next wakeup time
+   instead of the next tick. */
+void
+timer_idle_enter (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  arm (counts_now (), next_deadline (true));
+}
+
+/* Called by the BSP's idle thread once some interrupt has woken
+   the CPU.  Another thread may be about to run, so go back to
+   interrupting every tick. */
+void
+timer_idle_exit (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  arm (counts_now (), next_deadline (false));
+  intr_set_level (old_level);
+}
+
 /* Timer interrupt handler. */
 static void
-timer_interrupt (struct intr_frame *args UNUSED)
+timer_interrupt (struct intr_frame *args)
 {
-  ticks++;
-  thread_tick ();
+  int64_t now = counts_now ();
+  int64_t old_ticks = ticks;
+  /* A code selector with privilege level 3 is user code. */
+  bool user = (args->cs & 3) == 3;
+
+  interrupt_cnt++;
+
+  /* Catch up on every tick that has passed, which is more than
+     one if the CPU was idle. */
+  while (now >= next_tick_counts)
+    {
+      ticks++;
+      next_tick_counts += COUNTS_PER_TICK;
+      thread_tick (user);
+    }
+
+  /* Only this CPU, the BSP, takes timer interrupts. */
+  if (ticks != old_ticks)
+    smp_tick ();
   
   /* wakeup_tick의 최소값(=global_tick)보다 현재의 tick이 크다. -> wake up 해야할 thread가 sleep_list에 존재한다! */
   if (return_global_tick () <= ticks)
     thread_wakeup (ticks);
+
+  while (!list_empty (&short_sleepers))
+    {
+      struct short_sleeper *s = list_entry (list_front (&short_sleepers),
+                                            struct short_sleeper, elem);
+      if (s->deadline > now)
+        break;
+      list_pop_front (&short_sleepers);
+      sema_up (&s->sema);
+    }
+
+  arm (now, next_deadline (false));
+}
+
+/* Returns the number of PIT cycles since boot.  Interrupts must
+   be off. */
+static int64_t
+counts_now (void) 
+{
+  uint16_t count;
+  unsigned elapsed;
+
+  if (pit_read_channel (0, &count))
+    {
+      /* Reached 0, then kept counting down from 65535. */
+      elapsed = armed + (uint16_t) -count;
+    }
+  else
+    {
+      /* The count may not be loaded yet just after arm(). */
+      elapsed = count <= armed ? armed - count : 0;
+    }
+  return armed_at + elapsed;
+}
+
+/* Returns the time, in PIT cycles since boot, at which the next
+   timer interrupt is needed.  That is the next tick unless IDLE,
+   in which case it is the earliest wakeup time of a sleeping
+   thread. */
+static int64_t
+next_deadline (bool idle) 
+{
+  int64_t deadline = INT64_MAX;
+
+  if (!idle)
+    deadline = next_tick_counts;
+  else
+    {
+      int64_t wakeup_tick = return_global_tick ();
+      if (wakeup_tick != INT64_MAX)
+        deadline = wakeup_tick <= ticks ? next_tick_counts
+                                        : wakeup_tick * COUNTS_PER_TICK;
+    }
+
+  if (!list_empty (&short_sleepers))
+    {
+      struct short_sleeper *s = list_entry (list_front (&short_sleepers),
+                                            struct short_sleeper, elem);
+      if (s->deadline < deadline)
+        deadline = s->deadline;
+    }
+  return deadline;
+}
+
+/* Programs the PIT to interrupt at DEADLINE, or as close to it
+   as the PIT can reach, given that it is NOW.  Both times are in
+   PIT cycles since boot.  Interrupts must be off. */
+static void
+arm (int64_t now, int64_t deadline) 
+{
+  int64_t counts = deadline - now;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (counts < 2)
+    counts = 2;
+  else if (counts > MAX_COUNTS)
+    counts = MAX_COUNTS;
+
+  armed_at = now;
+  armed = counts;
+  pit_start_countdown (0, counts);
+}
+
+/* Returns true if short sleeper A's deadline precedes B's. */
+static bool
+short_sleeper_less (const struct list_elem *a_, const struct list_elem *b_,
+                    void *aux UNUSED) 
+{
+  const struct short_sleeper *a = list_entry (a_, struct short_sleeper, elem);
+  const struct short_sleeper *b = list_entry (b_, struct short_sleeper, elem);
+  
+  return a->deadline < b->deadline;
+}
+
+/* Blocks the current thread for COUNTS PIT cycles, less than a
+   tick, without busy-waiting. */
+static void
+short_sleep (int64_t counts) 
+{
+  struct short_sleeper s;
+  enum intr_level old_level;
+  int64_t now;
+
+  sema_init (&s.sema, 0);
+
+  old_level = intr_disable ();
+  now = counts_now ();
+  s.deadline = now + counts;
+  list_insert_ordered (&short_sleepers, &s.elem, short_sleeper_less, NULL);
+  if (list_front (&short_sleepers) == &s.elem)
+    arm (now, next_deadline (false));
+  intr_set_level (old_level);
+
+  sema_down (&s.sema);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -229,9 +454,14 @@ real_time_sleep (int64_t num, int32_t denom)
     }
   else 
     {
-      /* Otherwise, use a busy-wait loop for more accurate
-         sub-tick timing. */
-      real_time_delay (num, denom); 
+      /* Otherwise, block until a timer interrupt scheduled for
+         the exact time, unless that is so soon that a busy-wait
+         loop is cheaper. */
+      int64_t counts = num * PIT_HZ / denom;
+      if (counts >= MIN_SLEEP_COUNTS)
+        short_sleep (counts);
+      else
+        real_time_delay (num, denom); 
     }
 }
 
@@ -9,9 +9,11 @@
 
 void timer_init (void);
 void timer_calibrate (void);
+void timer_set_loops_per_tick (unsigned);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+int64_t timer_usecs (void);
 
 /* Sleep and yield the CPU to other threads. */
 void timer_sleep (int64_t ticks);
@@ -26,4 +28,8 @@ void timer_ndelay (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+/* Tickless idle. */
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
 #endif /* devices/timer.h */
@@ -0,0 +1,157 @@
+/* aiostream.c
+
+   Reads FILE from start to end twice and reports the timer ticks
+   each pass took, using stats():
+
+     - sync: read() into one buffer, summing each chunk before
+       asking for the next;
+     - aio: DEPTH reads kept in flight through an aio_ring,
+       summing each chunk as it completes while the kernel works
+       on the rest.
+
+   Both passes print the sum of the bytes, which must match.
+   DEPTH is 8 by default. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+#define CHUNK_SIZE 4096
+#define MAX_DEPTH 32
+#define RING_ADDR ((void *) 0x10000000)
+
+static char buffers[MAX_DEPTH][CHUNK_SIZE];
+
+/* Returns the current tick count. */
+static long long
+now (void)
+{
+  struct kstats st;
+
+  if (!stats (&st))
+    exit (1);
+  return st.ticks;
+}
+
+/* Returns the sum of the SIZE bytes in BUF. */
+static unsigned
+sum (const char *buf, int size)
+{
+  const unsigned char *p = (const unsigned char *) buf;
+  unsigned s = 0;
+
+  while (size-- > 0)
+    s += *p++;
+  return s;
+}
+
+static unsigned
+by_read (int fd)
+{
+  unsigned s = 0;
+  int n;
+
+  while ((n = read (fd, buffers[0], CHUNK_SIZE)) > 0)
+    s += sum (buffers[0], n);
+  return s;
+}
+
+/* Queues a read of chunk SLOT's buffer from offset OFS in FD. */
+static void
+submit (struct aio_ring *ring, int fd, int slot, unsigned ofs)
+{
+  struct aio_sqe *sqe = &ring->sq[ring->sq_tail % AIO_ENTRIES];
+
+  sqe->opcode = AIO_READ;
+  sqe->fd = fd;
+  sqe->buf = buffers[slot];
+  sqe->len = CHUNK_SIZE;
+  sqe->offset = ofs;
+  sqe->user_data = slot;
+  ring->sq_tail++;
+}
+
+static unsigned
+by_aio (struct aio_ring *ring, int fd, int depth, unsigned size)
+{
+  unsigned s = 0, next = 0;
+  int inflight = 0, slot;
+
+  for (slot = 0; slot < depth && next < size; slot++, next += CHUNK_SIZE)
+    {
+      submit (ring, fd, slot, next);
+      inflight++;
+    }
+  while (inflight > 0)
+    {
+      struct aio_cqe *cqe;
+
+      /* Hand over new requests, and wait for one to finish. */
+      aio_enter (ring->sq_tail - ring->sq_head, 1);
+      while (ring->cq_head != ring->cq_tail)
+        {
+          cqe = &ring->cq[ring->cq_head++ % AIO_ENTRIES];
+          inflight--;
+          if (cqe->res < 0)
+            {
+              printf ("aiostream: read failed\n");
+              exit (1);
+            }
+
+          /* Start the next read before using this one's data. */
+          slot = cqe->user_data;
+          s += sum (buffers[slot], cqe->res);
+          if (next < size)
+            {
+              submit (ring, fd, slot, next);
+              next += CHUNK_SIZE;
+              inflight++;
+            }
+        }
+    }
+  return s;
+}
+
+int
+main (int argc, char *argv[])
+{
+  struct aio_ring *ring;
+  long long start;
+  unsigned size, s;
+  int depth, fd;
+
+  if (argc < 2)
+    {
+      printf ("usage: aiostream FILE [DEPTH]\n");
+      return EXIT_FAILURE;
+    }
+  depth = argc > 2 ? atoi (argv[2]) : 8;
+  if (depth < 1 || depth > MAX_DEPTH)
+    depth = 8;
+  fd = open (argv[1]);
+  if (fd < 0)
+    {
+      printf ("aiostream: %s: open failed\n", argv[1]);
+      return EXIT_FAILURE;
+    }
+  ring = aio_setup (RING_ADDR);
+  if (ring == NULL)
+    {
+      printf ("aiostream: aio_setup failed\n");
+      return EXIT_FAILURE;
+    }
+  size = filesize (fd);
+  printf ("aiostream: %u bytes, %d reads in flight\n", size, depth);
+
+  start = now ();
+  s = by_read (fd);
+  printf ("sync: sum %u, %lld ticks\n", s, now () - start);
+
+  start = now ();
+  s = by_aio (ring, fd, depth, size);
+  printf ("aio: sum %u, %lld ticks\n", s, now () - start);
+
+  close (fd);
+  return EXIT_SUCCESS;
+}
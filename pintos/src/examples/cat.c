@@ -20,14 +20,8 @@ main (int argc, char *argv[])
           success = false;
           continue;
         }
-      for (;;) 
-        {
-          char buffer[1024];
-          int bytes_read = read (fd, buffer, sizeof buffer);
-          if (bytes_read == 0)
-            break;
-          write (STDOUT_FILENO, buffer, bytes_read);
-        }
+      while (sendfile (STDOUT_FILENO, fd, filesize (fd)) > 0)
+        continue;
       close (fd);
     }
   return success ? EXIT_SUCCESS : EXIT_FAILURE;
@@ -0,0 +1,223 @@
+/* ipcbench.c
+
+   Moves SIZE kB (256 by default) from this process to a child
+   three ways and reports the timer ticks each one took, using
+   stats():
+
+     - file: written to a file 4 kB at a time, then read back by
+       the child;
+     - pipe: written 4 kB at a time to a pipe that the child
+       inherits and reads as the data arrives;
+     - shm: copied 4 kB at a time through a ring of slots in a
+       shared memory segment, with counters in the segment for
+       flow control and sched_yield() for waiting.
+
+   The same program runs as the child, with "child", the mode,
+   and the chunk count as arguments.  The child adds up the
+   bytes it receives and exits with the sum, which the parent
+   checks. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+#define CHUNK_SIZE 4096
+#define FILE_NAME "ipcbench.tmp"
+
+/* Shared memory segment: a header page, then SLOT_CNT slots. */
+#define SHM_KEY 0x1bc
+#define SLOT_CNT 8
+#define SHM_ADDR ((struct ring *) 0x10000000)
+
+struct ring
+  {
+    volatile unsigned head;     /* Chunks written. */
+    volatile unsigned tail;     /* Chunks read. */
+    char pad[CHUNK_SIZE - 2 * sizeof (unsigned)];
+    char slots[SLOT_CNT][CHUNK_SIZE];
+  };
+
+static char chunk[CHUNK_SIZE];
+
+/* Returns the current tick count. */
+static long long
+now (void)
+{
+  struct kstats st;
+
+  if (!stats (&st))
+    exit (1);
+  return st.ticks;
+}
+
+/* Fills CHUNK with the data for chunk I and returns its sum. */
+static int
+fill (int i)
+{
+  memset (chunk, i, sizeof chunk);
+  return (i & 0xff) * CHUNK_SIZE;
+}
+
+/* Returns the sum of the SIZE bytes in BUF. */
+static int
+sum (const char *buf, int size)
+{
+  const unsigned char *p = (const unsigned char *) buf;
+  int s = 0;
+
+  while (size-- > 0)
+    s += *p++;
+  return s;
+}
+
+/* Runs the child side of MODE for CHUNK_CNT chunks and returns
+   the sum of the bytes received.  ARGV holds any further
+   arguments. */
+static int
+child (const char *mode, int chunk_cnt, char *argv[])
+{
+  int s = 0, n, i;
+
+  if (!strcmp (mode, "file"))
+    {
+      int fd = open (FILE_NAME);
+      if (fd < 0)
+        exit (-1);
+      while ((n = read (fd, chunk, sizeof chunk)) > 0)
+        s += sum (chunk, n);
+      close (fd);
+    }
+  else if (!strcmp (mode, "pipe"))
+    {
+      int fd = atoi (argv[0]);
+      close (atoi (argv[1]));
+      while ((n = read (fd, chunk, sizeof chunk)) > 0)
+        s += sum (chunk, n);
+    }
+  else if (!strcmp (mode, "shm"))
+    {
+      struct ring *r = shm_map (SHM_KEY, SHM_ADDR, sizeof *r);
+      if (r == NULL)
+        exit (-1);
+      for (i = 0; i < chunk_cnt; i++)
+        {
+          while (r->tail == r->head)
+            sched_yield ();
+          memcpy (chunk, r->slots[r->tail % SLOT_CNT], CHUNK_SIZE);
+          r->tail++;
+          s += sum (chunk, CHUNK_SIZE);
+        }
+    }
+  return s;
+}
+
+/* Starts the child side of MODE for CHUNK_CNT chunks, with EXTRA
+   appended to its command line, and returns its pid. */
+static pid_t
+start_child (const char *mode, int chunk_cnt, const char *extra)
+{
+  char cmd[64];
+  pid_t pid;
+
+  snprintf (cmd, sizeof cmd, "ipcbench child %s %d %s",
+            mode, chunk_cnt, extra);
+  pid = exec (cmd);
+  if (pid == PID_ERROR)
+    {
+      printf ("ipcbench: exec \"%s\" failed\n", cmd);
+      exit (1);
+    }
+  return pid;
+}
+
+static int
+by_file (int chunk_cnt)
+{
+  int fd, s = 0, i;
+
+  if (!create (FILE_NAME, 0) || (fd = open (FILE_NAME)) < 0)
+    exit (1);
+  for (i = 0; i < chunk_cnt; i++)
+    {
+      s += fill (i);
+      if (write (fd, chunk, CHUNK_SIZE) != CHUNK_SIZE)
+        exit (1);
+    }
+  close (fd);
+  if (wait (start_child ("file", chunk_cnt, "")) != s)
+    printf ("ipcbench: file: child got the wrong data\n");
+  remove (FILE_NAME);
+  return s;
+}
+
+static int
+by_pipe (int chunk_cnt)
+{
+  char fds_arg[32];
+  int fds[2], s = 0, i;
+  pid_t pid;
+
+  if (!pipe (fds))
+    exit (1);
+  snprintf (fds_arg, sizeof fds_arg, "%d %d", fds[0], fds[1]);
+  pid = start_child ("pipe", chunk_cnt, fds_arg);
+  close (fds[0]);
+  for (i = 0; i < chunk_cnt; i++)
+    {
+      s += fill (i);
+      if (write (fds[1], chunk, CHUNK_SIZE) != CHUNK_SIZE)
+        exit (1);
+    }
+  close (fds[1]);
+  if (wait (pid) != s)
+    printf ("ipcbench: pipe: child got the wrong data\n");
+  return s;
+}
+
+static int
+by_shm (int chunk_cnt)
+{
+  struct ring *r = shm_map (SHM_KEY, SHM_ADDR, sizeof *r);
+  int s = 0, i;
+  pid_t pid;
+
+  if (r == NULL)
+    exit (1);
+  r->head = r->tail = 0;
+  pid = start_child ("shm", chunk_cnt, "");
+  for (i = 0; i < chunk_cnt; i++)
+    {
+      s += fill (i);
+      while (r->head - r->tail == SLOT_CNT)
+        sched_yield ();
+      memcpy (r->slots[r->head % SLOT_CNT], chunk, CHUNK_SIZE);
+      r->head++;
+    }
+  if (wait (pid) != s)
+    printf ("ipcbench: shm: child got the wrong data\n");
+  shm_unmap (r);
+  return s;
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const char *modes[] = {"file", "pipe", "shm"};
+  static int (*const funcs[]) (int) = {by_file, by_pipe, by_shm};
+  int kb, chunk_cnt, i;
+
+  if (argc >= 4 && !strcmp (argv[1], "child"))
+    return child (argv[2], atoi (argv[3]), argv + 4);
+
+  kb = argc > 1 ? atoi (argv[1]) : 256;
+  chunk_cnt = kb * 1024 / CHUNK_SIZE;
+  printf ("ipcbench: %d kB in %d-byte chunks\n", kb, CHUNK_SIZE);
+  for (i = 0; i < 3; i++)
+    {
+      long long start = now ();
+      funcs[i] (chunk_cnt);
+      printf ("%s: %lld ticks\n", modes[i], now () - start);
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/* mallocbench.c
+
+   Measures the user-space allocator in lib/user/malloc.c.  Runs
+   N rounds (100 by default) of three workloads and reports the
+   timer ticks each one took, using stats():
+
+     - churn: malloc() and free() pairs of random small sizes,
+       with up to SLOT_CNT blocks live at once;
+     - bulk: SLOT_CNT small blocks allocated, then released
+       with one free_bulk() call;
+     - big: blocks of several pages, allocated and freed.
+
+   Each block is written to, so the heap pages are really
+   touched. */
+
+#include <random.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Blocks live at once. */
+#define SLOT_CNT 512
+
+static void *slots[SLOT_CNT];
+
+/* Returns the current tick count. */
+static long long
+now (void)
+{
+  struct kstats st;
+
+  if (!stats (&st))
+    exit (1);
+  return st.ticks;
+}
+
+/* Returns a random size for a small block. */
+static size_t
+small_size (void)
+{
+  return 1 + random_ulong () % 512;
+}
+
+static void
+churn (void)
+{
+  int i;
+
+  for (i = 0; i < SLOT_CNT * 4; i++)
+    {
+      int slot = random_ulong () % SLOT_CNT;
+      size_t size = small_size ();
+
+      free (slots[slot]);
+      slots[slot] = malloc (size);
+      if (slots[slot] == NULL)
+        exit (1);
+      memset (slots[slot], i, size);
+    }
+}
+
+static void
+bulk (void)
+{
+  int i;
+
+  for (i = 0; i < SLOT_CNT; i++)
+    {
+      size_t size = small_size ();
+
+      slots[i] = malloc (size);
+      if (slots[i] == NULL)
+        exit (1);
+      memset (slots[i], i, size);
+    }
+  free_bulk (slots, SLOT_CNT);
+  memset (slots, 0, sizeof slots);
+}
+
+static void
+big (void)
+{
+  int i;
+
+  for (i = 0; i < 16; i++)
+    {
+      size_t size = 4096 * (1 + random_ulong () % 8);
+      char *p = malloc (size);
+
+      if (p == NULL)
+        exit (1);
+      memset (p, i, size);
+      free (p);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  int round_cnt = argc > 1 ? atoi (argv[1]) : 100;
+  long long churn_ticks = 0, bulk_ticks = 0, big_ticks = 0;
+  int i;
+
+  random_init (0);
+  for (i = 0; i < round_cnt; i++)
+    {
+      long long start = now ();
+      churn ();
+      churn_ticks += now () - start;
+
+      free_bulk (slots, SLOT_CNT);
+      memset (slots, 0, sizeof slots);
+
+      start = now ();
+      bulk ();
+      bulk_ticks += now () - start;
+
+      start = now ();
+      big ();
+      big_ticks += now () - start;
+    }
+
+  printf ("mallocbench: %d rounds\n", round_cnt);
+  printf ("churn: %d ops per round, %lld ticks\n", SLOT_CNT * 4, churn_ticks);
+  printf ("bulk: %d ops per round, %lld ticks\n", SLOT_CNT + 1, bulk_ticks);
+  printf ("big: %d ops per round, %lld ticks\n", 32, big_ticks);
+  return EXIT_SUCCESS;
+}
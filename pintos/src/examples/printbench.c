@@ -0,0 +1,22 @@
+/* printbench.c
+
+   Prints N lines (1000 by default) to the console, one printf()
+   per line, to measure console throughput.  Lines per second is
+   N divided by the run time from the "Timer: N ticks" line
+   printed at shutdown, at TIMER_FREQ ticks per second. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+int
+main (int argc, char *argv[]) 
+{
+  int line_cnt = argc > 1 ? atoi (argv[1]) : 1000;
+  int i;
+
+  for (i = 0; i < line_cnt; i++)
+    printf ("printbench: line %d of %d, some text to pad it out\n",
+            i + 1, line_cnt);
+  return EXIT_SUCCESS;
+}
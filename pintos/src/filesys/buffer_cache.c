@@ -1,6 +1,11 @@
 #include "buffer_cache.h"
+#include <debug.h>
+#include <kstats.h>
+#include <string.h>
 #include "filesys/inode.h"
 #include "filesys/filesys.h"
+#include "filesys/journal.h"
+#include "lib/kernel/ihash.h"
 
 #define BUFFER_CACHE_ENTRY_NB 64
 
@@ -14,12 +19,18 @@ int entry;
 
 int clock_hand, period;
 
+/* Maps each cached sector to its buffer_head. */
+static struct ihash bc_map;
+
+/* Counters reported by bc_get_stats(). */
+static uint64_t hit_cnt, miss_cnt, evict_cnt;
+
 
 void write_behind(void){
     int i;
     for(i=0;i<64;i++){
-        if(buffers[i].used && buffers[i].dirty){
-        block_write(fs_device, buffers[i].sector, buffers[i].data);
+        if(buffers[i].used && buffers[i].dirty && !buffers[i].journaled){
+        bc_flush_entry(&buffers[i]);
         }
     }
     period = 0;
@@ -44,14 +55,18 @@ for(i=0;i<64;i++){
 //buffers[i].used = false;
 buffers[i].sector = -1;
 buffers[i].used = false;
+buffers[i].journaled = false;
 }
 current_p = p_buffer_cache;
+if(!ihash_init(&bc_map, BUFFER_CACHE_ENTRY_NB))
+  PANIC("bc_init: out of memory");
 sema_init(&bh_sema, 1);
 }
 
 void bc_term(void){
     bc_flush_all_entries();
     free(p_buffer_cache);
+    ihash_destroy(&bc_map);
 }
 
 bool bc_read(block_sector_t sector_idx, void *buffer, off_t bytes_read, int chunk_size, int sector_ofs){
@@ -61,12 +76,15 @@ bool bc_read(block_sector_t sector_idx, void *buffer, off_t bytes_read, int chun
  //printf("this is read and empty_entry is %d\n", entry);
   bh = bc_lookup(sector_idx);
   int index;
-  if(bh == NULL){
+  if(bh != NULL)
+    hit_cnt++;
+  else{
+    miss_cnt++;
    if(entry != BUFFER_CACHE_ENTRY_NB){
        index = buffer_idx();
        bh = &buffers[index];
        bh->sector = sector_idx;
-       bh->inode = inode_open(sector_idx);
+       ihash_insert(&bc_map, sector_idx, bh);
        bh->data = p_buffer_cache + index * 512;
        bh->clock_bit = 1;
        bh->dirty = false;
@@ -77,7 +95,7 @@ bool bc_read(block_sector_t sector_idx, void *buffer, off_t bytes_read, int chun
    else{
       bh = bc_select_victim();
       bh->sector = sector_idx;
-      bh->inode = inode_open(sector_idx);
+      ihash_insert(&bc_map, sector_idx, bh);
       bh->dirty = false;
       bh->clock_bit = 1;
       lock_init(&bh->lock);
@@ -96,19 +114,22 @@ bool bc_read(block_sector_t sector_idx, void *buffer, off_t bytes_read, int chun
 
 
 
-bool bc_write(block_sector_t sector_idx, void *buffer, off_t bytes_written, int chunk_size, int sector_ofs){
+bool bc_write(block_sector_t sector_idx, const void *buffer, off_t bytes_written, int chunk_size, int sector_ofs){
     if(period >= 400)
 write_behind();
 int index;
     bool success = false;
     struct buffer_head *bh;
     bh = bc_lookup(sector_idx);
-    if(bh == NULL){
+    if(bh != NULL)
+      hit_cnt++;
+    else{
+      miss_cnt++;
    if(entry != BUFFER_CACHE_ENTRY_NB){
        index = buffer_idx();
        bh = &buffers[index];
        bh->sector = sector_idx;
-       bh->inode = inode_open(sector_idx);
+       ihash_insert(&bc_map, sector_idx, bh);
        bh->data = p_buffer_cache + index * 512;
        bh->clock_bit = 1;
        lock_init(&bh->lock);
@@ -118,13 +139,17 @@ int index;
    else{
       bh = bc_select_victim();
       bh->sector = sector_idx;
-      bh->inode = inode_open(sector_idx);
+      ihash_insert(&bc_map, sector_idx, bh);
       bh->clock_bit = 1;
       lock_init(&bh->lock);
       entry--;
    }
     
      entry++;
+     /* A partial write must not leave the rest of the buffer
+        holding the sector it last cached. */
+     if(chunk_size < BLOCK_SECTOR_SIZE)
+       block_read(fs_device, sector_idx, bh->data);
   }
   //block_write(fs_device, sector_idx, buffer);
   memcpy(bh->data + sector_ofs, buffer + bytes_written, chunk_size);
@@ -133,46 +158,83 @@ int index;
   bh->clock_bit = 1;
     return true;
 }
+
+/* Like bc_write(), but for file system metadata.  The sector
+   joins the running journal transaction, and its buffer is
+   written in place only when the transaction commits. */
+bool bc_write_meta(block_sector_t sector_idx, const void *buffer, off_t bytes_written, int chunk_size, int sector_ofs){
+    struct buffer_head *bh;
+    bh = bc_lookup(sector_idx);
+    if(bh == NULL || !bh->journaled)
+      journal_reserve();
+    bc_write(sector_idx, buffer, bytes_written, chunk_size, sector_ofs);
+    bh = bc_lookup(sector_idx);
+    if(!bh->journaled){
+      bh->journaled = true;
+      journal_add(sector_idx);
+    }
+    return true;
+}
+
+/* Writes CNT whole sectors starting at SECTOR_IDX from BUFFER
+   straight to disk in one request, bypassing the cache so that a
+   large write does not evict everything else.  Cached copies of
+   the sectors are updated to match and left clean. */
+void bc_write_direct(block_sector_t sector_idx, const void *buffer, size_t cnt){
+    size_t i;
+    block_write_multiple(fs_device, sector_idx, cnt, buffer);
+    for(i=0;i<cnt;i++){
+      struct buffer_head *bh = bc_lookup(sector_idx + i);
+      if(bh != NULL){
+        memcpy(bh->data, (const uint8_t *) buffer + i * BLOCK_SECTOR_SIZE, BLOCK_SECTOR_SIZE);
+        if(!bh->journaled)
+          bh->dirty = false;
+      }
+    }
+}
+
 struct buffer_head* bc_select_victim(void){
     struct buffer_head *bh;
 while(1){
     if(clock_hand >= 64)
     clock_hand = 0;
-    if(!buffers[clock_hand].clock_bit && buffers[clock_hand].sector != 0)
+    if(!buffers[clock_hand].clock_bit && buffers[clock_hand].sector != 0
+       && !buffers[clock_hand].journaled)
     break;
     buffers[clock_hand++].clock_bit = 0;
 }
 bh = &buffers[clock_hand];
+evict_cnt++;
+ihash_delete(&bc_map, bh->sector);
 if(bh->dirty){
 bc_flush_entry(bh);
 }
-inode_close(bh->inode);
-bh->inode = NULL;
 period++;
 return bh;
 }
 
 struct buffer_head* bc_lookup(block_sector_t sector){
-int i;
-for(i=0;i<64;i++){
-    //printf("buffer sector[%d] : %d\n",i,buffers[i].sector);
-if(buffers[i].sector == sector)
-return &buffers[i];
-}
-
-return NULL;
+return ihash_find(&bc_map, sector);
 }
 
 void bc_flush_entry(struct buffer_head *p_flush_entry){
 block_write(fs_device, p_flush_entry->sector, p_flush_entry->data);
+p_flush_entry->dirty = false;
 }
 
+/* Writes back every dirty buffer except those pinned by the
+   journal, which only journal_commit() may write in place. */
 void bc_flush_all_entries(void){
  int i;
  for(i=0;i<64;i++){
-     if(buffers[i].dirty && buffers[i].sector != 0)
+     if(buffers[i].dirty && buffers[i].sector != 0 && !buffers[i].journaled)
      bc_flush_entry(&buffers[i]);
-     if(buffers[i].used)
-     inode_close(buffers[i].inode);
  }
-}
\ No newline at end of file
+}
+
+/* Copies the buffer cache counters into ST. */
+void bc_get_stats(struct kstats *st){
+  st->bc_hits = hit_cnt;
+  st->bc_misses = miss_cnt;
+  st->bc_evictions = evict_cnt;
+}
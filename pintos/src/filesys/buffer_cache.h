@@ -1,3 +1,6 @@
+#ifndef FILESYS_BUFFER_CACHE_H
+#define FILESYS_BUFFER_CACHE_H
+
 #include "devices/block.h"
 #include <stdbool.h>
 #include "threads/synch.h"
@@ -6,9 +9,9 @@
 struct semaphore bh_sema;
 
 struct buffer_head{
-    struct inode* inode;
     bool dirty;
     bool used;
+    bool journaled;     /* In the running journal transaction. */
     struct lock lock;
     block_sector_t sector;
     int clock_bit;
@@ -18,7 +21,9 @@ struct buffer_head{
 
 void write_behind(void);
 bool bc_read(block_sector_t sector_idx, void *buffer, off_t bytes_read, int chunk_size, int sector_ofs);
-bool bc_write(block_sector_t sector_idx, void *buffer, off_t bytes_written, int chunk_size, int sector_ofs);
+bool bc_write(block_sector_t sector_idx, const void *buffer, off_t bytes_written, int chunk_size, int sector_ofs);
+bool bc_write_meta(block_sector_t sector_idx, const void *buffer, off_t bytes_written, int chunk_size, int sector_ofs);
+void bc_write_direct(block_sector_t sector_idx, const void *buffer, size_t cnt);
 void bc_init(void);
 void bc_term(void);
 struct buffer_head* bc_select_victim(void);
@@ -27,4 +32,9 @@ struct buffer_head* bc_lookup(block_sector_t sector);
 
 void bc_flush_entry(struct buffer_head *p_flush_entry);
 
-void bc_flush_all_entries(void);
\ No newline at end of file
+void bc_flush_all_entries(void);
+
+struct kstats;
+void bc_get_stats(struct kstats *st);
+
+#endif /* filesys/buffer_cache.h */
@@ -1,4 +1,8 @@
 #include "filesys/dentry_cache.h"
+#include <kstats.h>
+
+/* Lookup counters reported by dc_get_stats(). */
+static uint64_t hit_cnt, miss_cnt;
 
 static unsigned 
 dc_hash_func (const struct hash_elem *e, void *aux)
@@ -52,26 +56,35 @@ delete_dce (struct hash *dc, struct dc_entry *dce)
 
 struct dc_entry *
 find_dce (char *path)
-{   int i;
-struct list_elem *bucket_e;
-    for (i = 0; i < dentry_cache.bucket_cnt; i++) 
-    {
-        /* hash value에 대응되는 bucket에서 path를 member로 가진 dc_entry가 있는지 찾는다. */
-        struct list *target_bucket = &dentry_cache.buckets[i];
+{
+    struct hash_iterator i;
 
-        for (bucket_e = list_begin (target_bucket); bucket_e != list_end (target_bucket); bucket_e = list_next (bucket_e)) 
+    /* Check every entry: dc_less_func() compares path pointers,
+       not strings, so hash_find() cannot look a path up. */
+    hash_first (&i, &dentry_cache);
+    while (hash_next (&i))
+    {
+        struct dc_entry *dce = hash_entry (hash_cur (&i), struct dc_entry, elem);
+        
+        if (strcmp (dce->absolute_path, path) == 0)
         {
-            struct hash_elem *hash_e = list_entry (bucket_e, struct hash_elem, list_elem);
-            struct dc_entry *dce = hash_entry (hash_e, struct dc_entry, elem);
-            
-            if (strcmp (dce->absolute_path, path) == 0)
-                return dce;
+            hit_cnt++;
+            return dce;
         }
     }
 
+    miss_cnt++;
     return NULL;
 }
 
+/* Copies the lookup counters into ST. */
+void
+dc_get_stats (struct kstats *st)
+{
+    st->dc_hits = hit_cnt;
+    st->dc_misses = miss_cnt;
+}
+
 static void 
 dc_destroy_func (struct hash_elem *e, void *aux)
 {
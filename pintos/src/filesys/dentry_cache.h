@@ -18,4 +18,7 @@ bool insert_dce (struct hash *dc, struct dc_entry *dce);
 bool delete_dce (struct hash *dc, struct dc_entry *dce);
 struct dc_entry *find_dce (char *path);
 static void dc_destroy_func (struct hash_elem *e, void *aux);
-void dc_destroy (struct hash *dc);
\ No newline at end of file
+void dc_destroy (struct hash *dc);
+
+struct kstats;
+void dc_get_stats (struct kstats *st);
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <list.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
 #include "threads/malloc.h"
 
 /* A directory. */
@@ -19,6 +20,7 @@ struct dir_entry
     block_sector_t inode_sector;        /* Sector number of header. */
     char name[NAME_MAX + 1];            /* Null terminated file name. */
     bool in_use;                        /* In use or free? */
+    bool is_dir;                        /* Names a directory? */
   };
 
 
@@ -134,12 +136,13 @@ dir_lookup (const struct dir *dir, const char *name,
 
 /* Adds a file named NAME to DIR, which must not already contain a
    file by that name.  The file's inode is in sector
-   INODE_SECTOR.
+   INODE_SECTOR, and IS_DIR tells whether it is a directory.
    Returns true if successful, false on failure.
    Fails if NAME is invalid (i.e. too long) or a disk or memory
    error occurs. */
 bool
-dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
+dir_add (struct dir *dir, const char *name, block_sector_t inode_sector,
+         bool is_dir)
 {
   struct dir_entry e;
   off_t ofs;
@@ -171,6 +174,7 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
   e.in_use = true;
   strlcpy (e.name, name, sizeof e.name);
   e.inode_sector = inode_sector;
+  e.is_dir = is_dir;
   success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 
  done:
@@ -193,6 +197,9 @@ dir_remove (struct dir *dir, const char *name)
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
+  /* Erasing the entry and freeing the inode commit together. */
+  journal_begin ();
+
   /* Find directory entry. */
   if (!lookup (dir, name, &e, &ofs))
     goto done;
@@ -213,6 +220,7 @@ dir_remove (struct dir *dir, const char *name)
 
  done:
   inode_close (inode);
+  journal_end ();
   return success;
 }
 
@@ -238,3 +246,40 @@ dir_readdir (struct dir *dir, char name[NAME_MAX + 1])
    
   return false;
 }
+
+/* Stores up to CNT entries of DIR, other than "." and "..", into
+   ENTS, continuing where the last dir_readdir() or
+   dir_getdents() left off.  Reads the directory a sector's worth
+   of entries at a time.  Returns the number of entries stored,
+   which is 0 at the end of the directory. */
+size_t
+dir_getdents (struct dir *dir, struct dirent *ents, size_t cnt)
+{
+  struct dir_entry batch[BLOCK_SECTOR_SIZE / sizeof (struct dir_entry)];
+  off_t pos = inode_pos (dir->inode);
+  size_t n = 0;
+
+  while (n < cnt)
+    {
+      size_t read_cnt = inode_read_at (dir->inode, batch, sizeof batch, pos)
+                        / sizeof *batch;
+      size_t i;
+
+      if (read_cnt == 0)
+        break;
+      for (i = 0; i < read_cnt && n < cnt; i++)
+        {
+          struct dir_entry *e = &batch[i];
+          if (e->in_use && strcmp (e->name, ".") && strcmp (e->name, ".."))
+            {
+              ents[n].inumber = e->inode_sector;
+              ents[n].is_dir = e->is_dir;
+              strlcpy (ents[n].name, e->name, sizeof ents[n].name);
+              n++;
+            }
+        }
+      pos += i * sizeof *batch;
+    }
+  inode_set_pos (dir->inode, pos);
+  return n;
+}
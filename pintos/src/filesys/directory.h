@@ -1,6 +1,7 @@
 #ifndef FILESYS_DIRECTORY_H
 #define FILESYS_DIRECTORY_H
 
+#include <dirent.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include "devices/block.h"
@@ -23,7 +24,8 @@ struct inode *dir_get_inode (struct dir *);
 
 /* Reading and writing. */
 bool dir_lookup (const struct dir *, const char *name, struct inode **);
-bool dir_add (struct dir *, const char *name, block_sector_t);
+bool dir_add (struct dir *, const char *name, block_sector_t, bool is_dir);
 bool dir_remove (struct dir *, const char *name);
 bool dir_readdir (struct dir *, char name[NAME_MAX + 1]);
+size_t dir_getdents (struct dir *, struct dirent *, size_t cnt);
 #endif /* filesys/directory.h */
@@ -1,14 +1,21 @@
 #include "filesys/file.h"
 #include <debug.h>
 #include "filesys/inode.h"
+#include "filesys/pipe.h"
 #include "threads/malloc.h"
 
-/* An open file. */
+/* An open file.  A file is either an inode or one end of a pipe,
+   in which case INODE is null and only reading or writing, as
+   WRITER says, is allowed. */
 struct file 
   {
     struct inode *inode;        /* File's inode. */
     off_t pos;                  /* Current position. */
     bool deny_write;            /* Has file_deny_write() been called? */
+    int open_cnt;               /* Number of file_close() calls to free. */
+    struct pipe *pipe;          /* Pipe, if this is a pipe end. */
+    bool writer;                /* Write end of PIPE? */
+    bool nonblock;              /* Fail pipe I/O that would wait? */
   };
 
 /* Opens a file for the given INODE, of which it takes ownership,
@@ -22,6 +29,7 @@ file_open (struct inode *inode) {
       file->inode = inode;
       file->pos = 0;
       file->deny_write = false;
+      file->open_cnt = 1;
       return file;
     }
   else
@@ -32,27 +40,77 @@ file_open (struct inode *inode) {
     }
 }
 
-/* Opens and returns a new file for the same inode as FILE.
+/* Opens a file for one end of PIPE, of which it takes
+   ownership: the write end if WRITER, otherwise the read end.
+   If NONBLOCK, reads and writes that would wait fail instead.
+   Returns the new file, or a null pointer if an allocation
+   fails. */
+struct file *
+file_open_pipe (struct pipe *pipe, bool writer, bool nonblock) 
+{
+  struct file *file = calloc (1, sizeof *file);
+  if (file == NULL)
+    {
+      pipe_close (pipe, writer);
+      return NULL;
+    }
+  file->pipe = pipe;
+  file->writer = writer;
+  file->nonblock = nonblock;
+  file->open_cnt = 1;
+  return file;
+}
+
+/* Returns true if FILE is one end of a pipe. */
+bool
+file_is_pipe (const struct file *file) 
+{
+  return file->pipe != NULL;
+}
+
+/* Opens and returns a new file for the same inode, or the same
+   end of the same pipe, as FILE.
    Returns a null pointer if unsuccessful. */
 struct file *
 file_reopen (struct file *file) 
 {
+  if (file->pipe != NULL)
+    {
+      pipe_reopen (file->pipe, file->writer);
+      return file_open_pipe (file->pipe, file->writer, file->nonblock);
+    }
   return file_open (inode_reopen (file->inode));
 }
 
-/* Closes FILE. */
+/* Returns FILE itself as a second reference that shares its
+   position.  Each reference must be closed separately. */
+struct file *
+file_dup (struct file *file) 
+{
+  file->open_cnt++;
+  return file;
+}
+
+/* Closes FILE.  The file is freed when its last reference from
+   file_open() or file_dup() is closed. */
 void
 file_close (struct file *file) 
 {
-  if (file != NULL)
+  if (file != NULL && --file->open_cnt == 0)
     {
-      file_allow_write (file);
-      inode_close (file->inode);
+      if (file->pipe != NULL)
+        pipe_close (file->pipe, file->writer);
+      else
+        {
+          file_allow_write (file);
+          inode_close (file->inode);
+        }
       free (file); 
     }
 }
 
-/* Returns the inode encapsulated by FILE. */
+/* Returns the inode encapsulated by FILE, or a null pointer if
+   FILE is a pipe end. */
 struct inode *
 file_get_inode (struct file *file) 
 {
@@ -63,11 +121,18 @@ file_get_inode (struct file *file)
    starting at the file's current position.
    Returns the number of bytes actually read,
    which may be less than SIZE if end of file is reached.
-   Advances FILE's position by the number of bytes read. */
+   Advances FILE's position by the number of bytes read.
+   A pipe's read end instead returns whatever data is in the
+   pipe, waiting for some if it is empty; see pipe_read(). */
 off_t
 file_read (struct file *file, void *buffer, off_t size) 
 {
-  off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
+  off_t bytes_read;
+
+  if (file->pipe != NULL)
+    return (!file->writer
+            ? pipe_read (file->pipe, buffer, size, file->nonblock) : -1);
+  bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
   file->pos += bytes_read;
   return bytes_read;
 }
@@ -89,11 +154,18 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs)
    which may be less than SIZE if end of file is reached.
    (Normally we'd grow the file in that case, but file growth is
    not yet implemented.)
-   Advances FILE's position by the number of bytes read. */
+   Advances FILE's position by the number of bytes read.
+   A pipe's write end instead writes to the pipe; see
+   pipe_write(). */
 off_t
 file_write (struct file *file, const void *buffer, off_t size) 
 {
-  off_t bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
+  off_t bytes_written;
+
+  if (file->pipe != NULL)
+    return (file->writer
+            ? pipe_write (file->pipe, buffer, size, file->nonblock) : -1);
+  bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
   file->pos += bytes_written;
   return bytes_written;
 }
@@ -1,16 +1,23 @@
 #ifndef FILESYS_FILE_H
 #define FILESYS_FILE_H
 
+#include <stdbool.h>
 #include "filesys/off_t.h"
 
 struct inode;
+struct pipe;
 
 /* Opening and closing files. */
 struct file *file_open (struct inode *);
 struct file *file_reopen (struct file *);
+struct file *file_dup (struct file *);
 void file_close (struct file *);
 struct inode *file_get_inode (struct file *);
 
+/* Pipes. */
+struct file *file_open_pipe (struct pipe *, bool writer, bool nonblock);
+bool file_is_pipe (const struct file *);
+
 /* Reading and writing. */
 off_t file_read (struct file *, void *, off_t);
 off_t file_read_at (struct file *, void *, off_t size, off_t start);
@@ -6,6 +6,7 @@
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#include "filesys/journal.h"
 #include "filesys/buffer_cache.h"
 #include "threads/thread.h"
 #include "filesys/dentry_cache.h"
@@ -24,6 +25,7 @@ filesys_init (bool format)
   if (fs_device == NULL)
     PANIC ("No file system device found, can't initialize file system.");
   bc_init();
+  journal_init (format);
   dc_init();
   inode_init ();
   free_map_init ();
@@ -38,6 +40,7 @@ filesys_init (bool format)
 void
 filesys_done (void) 
 {
+  journal_done ();
   bc_term();
   dc_destroy (&dentry_cache);
   dir_close(thread_current()->dir);
@@ -126,12 +129,14 @@ filesys_create (const char *name, off_t initial_size)
   }
   //printf("abc:%s\n", cp_name);
   //printf("dir:%s, %d\n", file_name, inode_is_dir(dir_get_inode(dir)));
+  journal_begin ();
   bool success = (dir != NULL
                   && free_map_allocate (1, &inode_sector)
                   && inode_create (inode_sector, initial_size, 0)
-                  && dir_add (dir, file_name, inode_sector));               
+                  && dir_add (dir, file_name, inode_sector, false));               
   if (!success && inode_sector != 0) 
     free_map_release (inode_sector, 1);
+  journal_end ();
 
   /* dentry cache에 create한 file에 대한 정보를 insert. */
   if (name[0] == '/')
@@ -450,8 +455,8 @@ bool filesys_create_dir(const char *name){
     success = (dir_create (ROOT_DIR_SECTOR, 16)
     && (inode = inode_open(ROOT_DIR_SECTOR)) != NULL
     && (dir = dir_open(inode)) != NULL
-    && dir_add (dir, ".", ROOT_DIR_SECTOR)
-    && dir_add (dir, "..", ROOT_DIR_SECTOR));
+    && dir_add (dir, ".", ROOT_DIR_SECTOR, true)
+    && dir_add (dir, "..", ROOT_DIR_SECTOR, true));
     dir_close(dir);
 
     return success;
@@ -528,17 +533,19 @@ bool filesys_create_dir(const char *name){
     return false;
     }
   }
+  journal_begin ();
        success = (dir != NULL
                   && free_map_allocate (1, &inode_sector)
-                  && dir_add (dir, file_name, inode_sector)
+                  && dir_add (dir, file_name, inode_sector, true)
                   && dir_create (inode_sector, 16)
                   && (inode = inode_open(inode_sector)) != NULL
                   && (sub = dir_open(inode)) != NULL
-                  && dir_add (sub, ".", inode_sector)
-                  && dir_add (sub, "..", inode_get_inumber(dir_get_inode(dir))));       
+                  && dir_add (sub, ".", inode_sector, true)
+                  && dir_add (sub, "..", inode_get_inumber(dir_get_inode(dir)), true));       
 
   if (!success && inode_sector != 0) 
     free_map_release (inode_sector, 1);
+  journal_end ();
 
     /* dentry cache에 create한 file에 대한 정보를 insert. */
   if (name[0] == '/')
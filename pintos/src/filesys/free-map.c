@@ -4,10 +4,20 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
+#include "threads/synch.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per sector. */
 
+/* The free map is read from disk the first time it is needed,
+   not at mount, so that runs that never allocate or free a
+   sector never read it. */
+static bool free_map_loaded;         /* Bitmap matches disk? */
+static struct lock free_map_load_lock;
+
+static void free_map_load (void);
+
 /* Initializes the free map. */
 void
 free_map_init (void) 
@@ -17,6 +27,25 @@ free_map_init (void)
     PANIC ("bitmap creation failed--file system device is too large");
   bitmap_mark (free_map, FREE_MAP_SECTOR);
   bitmap_mark (free_map, ROOT_DIR_SECTOR);
+  bitmap_set_multiple (free_map, JOURNAL_SECTOR, JOURNAL_SLOTS + 1, true);
+  lock_init (&free_map_load_lock);
+}
+
+/* Reads the free map from disk, if it hasn't been already. */
+static void
+free_map_load (void) 
+{
+  if (free_map_loaded)
+    return;
+
+  lock_acquire (&free_map_load_lock);
+  if (!free_map_loaded)
+    {
+      if (!bitmap_read (free_map, free_map_file))
+        PANIC ("can't read free map");
+      free_map_loaded = true;
+    }
+  lock_release (&free_map_load_lock);
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
@@ -27,7 +56,10 @@ free_map_init (void)
 bool
 free_map_allocate (size_t cnt, block_sector_t *sectorp)
 {
-  block_sector_t sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
+  block_sector_t sector;
+
+  free_map_load ();
+  sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
   if (sector != BITMAP_ERROR
       && free_map_file != NULL
       && !bitmap_write (free_map, free_map_file))
@@ -44,20 +76,20 @@ free_map_allocate (size_t cnt, block_sector_t *sectorp)
 void
 free_map_release (block_sector_t sector, size_t cnt)
 {
+  free_map_load ();
   ASSERT (bitmap_all (free_map, sector, cnt));
   bitmap_set_multiple (free_map, sector, cnt, false);
   bitmap_write (free_map, free_map_file);
 }
 
-/* Opens the free map file and reads it from disk. */
+/* Opens the free map file.  Its contents are read on first use. */
 void
 free_map_open (void) 
 {
   free_map_file = file_open (inode_open (FREE_MAP_SECTOR));
   if (free_map_file == NULL)
     PANIC ("can't open free map");
-  if (!bitmap_read (free_map, free_map_file))
-    PANIC ("can't read free map");
+  free_map_loaded = false;
 }
 
 /* Writes the free map to disk and closes the free map file. */
@@ -82,4 +114,5 @@ free_map_create (void)
     PANIC ("can't open free map");
   if (!bitmap_write (free_map, free_map_file))
     PANIC ("can't write free map");
+  free_map_loaded = true;
 }
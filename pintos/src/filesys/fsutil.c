@@ -1,5 +1,6 @@
 #include "filesys/fsutil.h"
 #include <debug.h>
+#include <round.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,10 +8,19 @@
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
 
+/* Sectors moved per request between the scratch device and the
+   file system by `extract' and `append'. */
+#define BATCH_SECTORS 64
+
+/* Extracted files bigger than this many bytes bypass the buffer
+   cache, which they would otherwise flush out entirely. */
+#define DIRECT_MIN (32 * BLOCK_SECTOR_SIZE)
+
 /* List files in the root directory. */
 void
 fsutil_ls (char **argv UNUSED) 
@@ -68,7 +78,13 @@ fsutil_rm (char **argv)
 }
 
 /* Extracts a ustar-format tar archive from the scratch block
-   device into the Pintos file system. */
+   device into the Pintos file system.
+
+   Each file's sectors are allocated up front, contiguously if
+   possible, and its data is moved BATCH_SECTORS at a time with
+   multi-sector requests.  Files bigger than DIRECT_MIN are
+   written to disk directly instead of through the buffer
+   cache. */
 void
 fsutil_extract (char **argv UNUSED) 
 {
@@ -79,7 +95,7 @@ fsutil_extract (char **argv UNUSED)
 
   /* Allocate buffers. */
   header = malloc (BLOCK_SECTOR_SIZE);
-  data = malloc (BLOCK_SECTOR_SIZE);
+  data = malloc (BATCH_SECTORS * BLOCK_SECTOR_SIZE);
   if (header == NULL || data == NULL)
     PANIC ("couldn't allocate buffers");
 
@@ -114,26 +130,40 @@ fsutil_extract (char **argv UNUSED)
       else if (type == USTAR_REGULAR)
         {
           struct file *dst;
+          struct inode *inode;
+          bool direct = size > DIRECT_MIN;
+          int ofs, chunk_size;
 
           printf ("Putting '%s' into the file system...\n", file_name);
-          /* Create destination file. */
-          if (!filesys_create (file_name, size))
+          /* Create destination file, with all of its sectors. */
+          if (!filesys_create (file_name, 0))
             PANIC ("%s: create failed", file_name);
           dst = filesys_open (file_name);
           if (dst == NULL)
             PANIC ("%s: open failed", file_name);
+          inode = file_get_inode (dst);
+          if (!inode_allocate (inode, size))
+            PANIC ("%s: out of space", file_name);
 
           /* Do copy. */
-          while (size > 0)
+          for (ofs = 0; ofs < size; ofs += chunk_size)
             {
-              int chunk_size = (size > BLOCK_SECTOR_SIZE
-                                ? BLOCK_SECTOR_SIZE
-                                : size);
-              block_read (src, sector++, data);
-              if (file_write (dst, data, chunk_size) != chunk_size)
+              size_t cnt = DIV_ROUND_UP (size - ofs, BLOCK_SECTOR_SIZE);
+              off_t written;
+
+              if (cnt > BATCH_SECTORS)
+                cnt = BATCH_SECTORS;
+              chunk_size = size - ofs;
+              if (chunk_size > (int) cnt * BLOCK_SECTOR_SIZE)
+                chunk_size = cnt * BLOCK_SECTOR_SIZE;
+              block_read_multiple (src, sector, cnt, data);
+              sector += cnt;
+              written = (direct
+                         ? inode_write_at_direct (inode, data, chunk_size, ofs)
+                         : inode_write_at (inode, data, chunk_size, ofs));
+              if (written != chunk_size)
                 PANIC ("%s: write failed with %d bytes unwritten",
-                       file_name, size);
-              size -= chunk_size;
+                       file_name, size - ofs);
             }
 
           /* Finish up. */
@@ -145,9 +175,8 @@ fsutil_extract (char **argv UNUSED)
      two blocks because two blocks of zeros are the ustar
      end-of-archive marker. */
   printf ("Erasing ustar archive...\n");
-  memset (header, 0, BLOCK_SECTOR_SIZE);
-  block_write (src, 0, header);
-  block_write (src, 1, header);
+  memset (data, 0, 2 * BLOCK_SECTOR_SIZE);
+  block_write_multiple (src, 0, 2, data);
 
   free (data);
   free (header);
@@ -175,7 +204,7 @@ fsutil_append (char **argv)
   printf ("Appending '%s' to ustar archive on scratch device...\n", file_name);
 
   /* Allocate buffer. */
-  buffer = malloc (BLOCK_SECTOR_SIZE);
+  buffer = malloc (BATCH_SECTORS * BLOCK_SECTOR_SIZE);
   if (buffer == NULL)
     PANIC ("couldn't allocate buffer");
 
@@ -195,25 +224,27 @@ fsutil_append (char **argv)
     PANIC ("%s: name too long for ustar format", file_name);
   block_write (dst, sector++, buffer);
 
-  /* Do copy. */
+  /* Do copy, BATCH_SECTORS at a time. */
   while (size > 0) 
     {
-      int chunk_size = size > BLOCK_SECTOR_SIZE ? BLOCK_SECTOR_SIZE : size;
-      if (sector >= block_size (dst))
+      off_t max = BATCH_SECTORS * BLOCK_SECTOR_SIZE;
+      off_t chunk_size = size > max ? max : size;
+      size_t cnt = DIV_ROUND_UP (chunk_size, BLOCK_SECTOR_SIZE);
+      if (sector + cnt > block_size (dst))
         PANIC ("%s: out of space on scratch device", file_name);
       if (file_read (src, buffer, chunk_size) != chunk_size)
         PANIC ("%s: read failed with %"PROTd" bytes unread", file_name, size);
-      memset (buffer + chunk_size, 0, BLOCK_SECTOR_SIZE - chunk_size);
-      block_write (dst, sector++, buffer);
+      memset (buffer + chunk_size, 0, cnt * BLOCK_SECTOR_SIZE - chunk_size);
+      block_write_multiple (dst, sector, cnt, buffer);
+      sector += cnt;
       size -= chunk_size;
     }
 
   /* Write ustar end-of-archive marker, which is two consecutive
      sectors full of zeros.  Don't advance our position past
      them, though, in case we have more files to append. */
-  memset (buffer, 0, BLOCK_SECTOR_SIZE);
-  block_write (dst, sector, buffer);
-  block_write (dst, sector + 1, buffer);
+  memset (buffer, 0, 2 * BLOCK_SECTOR_SIZE);
+  block_write_multiple (dst, sector, 2, buffer);
 
   /* Finish up. */
   file_close (src);
@@ -1,29 +1,36 @@
 #include "filesys/inode.h"
-#include <list.h>
+#include <hash.h>
 #include <debug.h>
 #include <round.h>
 #include <string.h>
+#include "filesys/buffer_cache.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "filesys/journal.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
-#define DIRECT_BLOCK_ENTRIES 123
+#define DIRECT_BLOCK_ENTRIES 122
 #define INDIRECT_BLOCK_ENTRIES 128
 
+/* Levels of index blocks between the inode and a data sector. */
 enum direct_t{
 NORMAL_DIRECT=0,
 INDIRECT=1,
 DOUBLE_INDIRECT=2,
-OUT_LIMIT=3
+TRIPLE_INDIRECT=3,
+OUT_LIMIT=4
 };
 
+/* Where the number of a file's data sector is kept.  For
+   NORMAL_DIRECT, INDEX[0] is its entry in the direct map;
+   otherwise INDEX[I] is the entry to follow in the index block
+   I levels below the inode. */
 struct sector_location{
  enum direct_t directness;
-  off_t index1;
-  off_t index2;
+  off_t index[3];
 };
 
 struct inode_indirect_block{
@@ -31,7 +38,12 @@ struct inode_indirect_block{
 };
 
 /* On-disk inode.
-   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+   Must be exactly BLOCK_SECTOR_SIZE bytes long.
+
+   Files may be sparse.  A map or index block entry of 0 is a
+   hole, which reads as zeroes and gets a sector only when it is
+   written.  Sector 0 holds the free map, so it is never file
+   data. */
 struct inode_disk
   {
     off_t length;                       /* File size in bytes. */
@@ -39,14 +51,18 @@ struct inode_disk
     block_sector_t direct_map_table[DIRECT_BLOCK_ENTRIES];
     block_sector_t indirect_block_sec;
     block_sector_t double_indirect_block_sec;
+    block_sector_t triple_indirect_block_sec;
     int is_dir;
   };
 
 static bool get_disk_inode(const struct inode *inode, struct inode_disk *inode_disk);
 static void locate_byte(off_t pos, struct sector_location *sec_loc);
+static block_sector_t lookup_sector(const struct inode_disk *inode_disk, const struct sector_location *sec_loc);
 static bool register_sector(struct inode_disk *inode_disk, block_sector_t new_sector, struct sector_location sec_loc);
 static void free_inode_sectors(struct inode_disk *inode_disk);
-bool inode_update_file_length(struct inode_disk *inode_disk, off_t start_pos, off_t end_pos);
+bool inode_update_file_length(struct inode_disk *inode_disk, off_t start_pos, off_t end_pos, bool zero);
+static off_t write_at (struct inode *, const void *, off_t size, off_t offset,
+                       bool direct);
 static inline off_t map_table_offset(int index){
 return (off_t) index * 4;
 }
@@ -62,70 +78,66 @@ bytes_to_sectors (off_t size)
 /* In-memory inode. */
 struct inode 
   {
-    struct list_elem elem;              /* Element in inode list. */
+    struct hash_elem elem;              /* Element in open_inodes. */
     block_sector_t sector;              /* Sector number of disk location. */
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
     struct lock extend_lock;
     off_t pos;
+    unsigned write_cnt;                 /* Number of inode_write_at() calls. */
   };
 
 /* Returns the block device sector that contains byte offset POS
    within INODE.
-   Returns -1 if INODE does not contain data for a byte at offset
-   POS. */
+   Returns 0 if POS is in a hole, or -1 if INODE does not contain
+   data for a byte at offset POS. */
 static block_sector_t
 byte_to_sector (const struct inode_disk *inode_disk, off_t pos) 
 { 
-  block_sector_t result_sec; 
-  if (pos < inode_disk->length){
-    struct inode_indirect_block *ind_block;
-    struct sector_location sec_loc;
-    locate_byte(pos, &sec_loc);
-    //printf("sec_loc directness:%d\n", sec_loc.directness); 
-    switch(sec_loc.directness){
-      case NORMAL_DIRECT:
-      //printf("sec_loc index1:%d, pos:%d, length:%d\n", sec_loc.index1, pos, inode_disk->length);
-      result_sec = inode_disk->direct_map_table[sec_loc.index1];
-      break;
-      case INDIRECT:
-      ind_block = malloc(BLOCK_SECTOR_SIZE);
-      bc_read(inode_disk->indirect_block_sec, ind_block, 0, BLOCK_SECTOR_SIZE, 0);
-      result_sec = ind_block->map_table[sec_loc.index1];
-      free(ind_block);
-      break;
-      case DOUBLE_INDIRECT:
-      ind_block = malloc(BLOCK_SECTOR_SIZE);
-      bc_read(inode_disk->double_indirect_block_sec, ind_block, 0, BLOCK_SECTOR_SIZE, 0);
-      bc_read(ind_block->map_table[sec_loc.index1], ind_block, 0, BLOCK_SECTOR_SIZE, 0);
-      result_sec = ind_block->map_table[sec_loc.index2];
-      free(ind_block);
-      break;
-      case OUT_LIMIT:
-      result_sec = 0;
-      break;
-    }
-    return result_sec;
-  }
-  else
+  struct sector_location sec_loc;
+
+  if (pos >= inode_disk->length)
     return -1;
+  locate_byte(pos, &sec_loc);
+  return lookup_sector(inode_disk, &sec_loc);
+}
+
+/* Open inodes, keyed by sector, so that opening a single inode
+   twice returns the same `struct inode'. */
+static struct hash open_inodes;
+
+/* Protects open_inodes and each open inode's open_cnt. */
+static struct lock open_inodes_lock;
+
+static unsigned
+inode_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_int (hash_entry (e, struct inode, elem)->sector);
 }
 
-/* List of open inodes, so that opening a single inode twice
-   returns the same `struct inode'. */
-static struct list open_inodes;
+static bool
+inode_less (const struct hash_elem *a, const struct hash_elem *b,
+            void *aux UNUSED)
+{
+  return (hash_entry (a, struct inode, elem)->sector
+          < hash_entry (b, struct inode, elem)->sector);
+}
 
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
-  list_init (&open_inodes);
+  if (!hash_init (&open_inodes, inode_hash, inode_less, NULL))
+    PANIC ("inode_init: out of memory");
+  lock_init (&open_inodes_lock);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
    writes the new inode to sector SECTOR on the file system
-   device.
+   device.  The data starts out as one big hole, except for the
+   free map's: filling a hole in the free map file would allocate
+   from the free map while it is being written.
    Returns true if successful.
    Returns false if memory or disk allocation fails. */
 bool
@@ -142,22 +154,20 @@ inode_create (block_sector_t sector, off_t length, uint32_t is_dir)
   disk_inode = calloc (1, sizeof *disk_inode);
   if (disk_inode != NULL)
     {
-    
+      journal_begin ();
       disk_inode->length = length;
       disk_inode->magic = INODE_MAGIC;
       disk_inode->indirect_block_sec = 0;
       disk_inode->double_indirect_block_sec = 0;
+      disk_inode->triple_indirect_block_sec = 0;
       disk_inode->is_dir = is_dir;
-      if (length > 0) 
-        {
-         // lock_acquire(&inode->extend_lock);
-          inode_update_file_length(disk_inode, 0, length - 1);
-          bc_write (sector, disk_inode, 0, BLOCK_SECTOR_SIZE, 0); 
-          // lock_release(&inode->extend_lock);
-         //  inode_close(inode);
-        } 
+      success = true;
+      if (length > 0 && sector == FREE_MAP_SECTOR)
+        success = inode_update_file_length (disk_inode, 0, length - 1, true);
+      if (success)
+        bc_write_meta (sector, disk_inode, 0, BLOCK_SECTOR_SIZE, 0); 
+      journal_end ();
       free (disk_inode);
-      success = true; 
     }
   return success;
 }
@@ -168,31 +178,38 @@ inode_create (block_sector_t sector, off_t length, uint32_t is_dir)
 struct inode *
 inode_open (block_sector_t sector)
 {
-  struct list_elem *e;
+  struct inode probe;
+  struct hash_elem *e;
   struct inode *inode;
+
   /* Check whether this inode is already open. */
-  for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-       e = list_next (e)) 
+  lock_acquire (&open_inodes_lock);
+  probe.sector = sector;
+  e = hash_find (&open_inodes, &probe.elem);
+  if (e != NULL) 
     {
-      inode = list_entry (e, struct inode, elem);
-      if (inode->sector == sector) 
-        {
-          inode_reopen (inode);
-          return inode; 
-        }
+      inode = hash_entry (e, struct inode, elem);
+      inode->open_cnt++;
+      lock_release (&open_inodes_lock);
+      return inode; 
     }
   /* Allocate memory. */
   inode = malloc (sizeof *inode);
   if (inode == NULL)
-    return NULL;
+    {
+      lock_release (&open_inodes_lock);
+      return NULL;
+    }
   /* Initialize. */
-  list_push_front (&open_inodes, &inode->elem);
   inode->sector = sector;
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
   inode->removed = false;
   inode->pos = 0;
+  inode->write_cnt = 0;
   lock_init(&inode->extend_lock);
+  hash_insert (&open_inodes, &inode->elem);
+  lock_release (&open_inodes_lock);
   return inode;
 }
 
@@ -201,7 +218,11 @@ struct inode *
 inode_reopen (struct inode *inode)
 {
   if (inode != NULL)
-    inode->open_cnt++;
+    {
+      lock_acquire (&open_inodes_lock);
+      inode->open_cnt++;
+      lock_release (&open_inodes_lock);
+    }
   return inode;
 }
 
@@ -231,24 +252,30 @@ inode_close (struct inode *inode)
     return;
   /* Release resources if this was the last opener. */
   //printf("count:%d\n", inode->open_cnt);
-  if (--inode->open_cnt == 0)
+  lock_acquire (&open_inodes_lock);
+  if (--inode->open_cnt > 0)
     {
-      /* Remove from inode list and release lock. */
-      list_remove (&inode->elem);
-      /* Deallocate blocks if removed. */
-      if (inode->removed) 
-        { 
-    
-          struct inode_disk *disk_inode = malloc(BLOCK_SECTOR_SIZE);
-          get_disk_inode(inode, disk_inode);
-                    free_map_release (inode->sector, 1);
-          free_inode_sectors(disk_inode);
-
-          free(disk_inode);
-        }
-
-      free (inode); 
+      lock_release (&open_inodes_lock);
+      return;
+    }
+  /* Remove from open inode table and release lock. */
+  hash_delete (&open_inodes, &inode->elem);
+  lock_release (&open_inodes_lock);
+
+  /* Deallocate blocks if removed. */
+  if (inode->removed) 
+    { 
+      struct inode_disk *disk_inode = malloc(BLOCK_SECTOR_SIZE);
+      journal_begin ();
+      get_disk_inode(inode, disk_inode);
+      free_map_release (inode->sector, 1);
+      free_inode_sectors(disk_inode);
+      journal_end ();
+
+      free(disk_inode);
     }
+
+  free (inode); 
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -289,6 +316,9 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       int chunk_size = size < min_left ? size : min_left;
       if (chunk_size <= 0)
         break;
+      if (sector_idx == 0)
+        memset (buffer + bytes_read, 0, chunk_size);
+      else
           bc_read (sector_idx, buffer, bytes_read, chunk_size, sector_ofs);
           
         
@@ -309,13 +339,74 @@ lock_release(&inode->extend_lock);
    (Normally a write at end of file would extend the inode, but
    growth is not yet implemented.) */
 off_t
-inode_write_at (struct inode *inode, const void *buffer_, off_t size,
+inode_write_at (struct inode *inode, const void *buffer, off_t size,
                 off_t offset) 
 {
+  return write_at (inode, buffer, size, offset, false);
+}
+
+/* Like inode_write_at(), but whole sectors of file data bypass
+   the buffer cache and go to disk directly, with one request
+   for each run of sectors that is contiguous on disk.  Meant
+   for writes much larger than the cache. */
+off_t
+inode_write_at_direct (struct inode *inode, const void *buffer, off_t size,
+                       off_t offset) 
+{
+  return write_at (inode, buffer, size, offset, true);
+}
+
+/* Extends INODE to LENGTH bytes, taking the new sectors in one
+   contiguous run if the free map has one.  Unlike growth by
+   writing, the new sectors are not zeroed, except for the tail
+   of a partial last sector, so the caller must write all of
+   them.  Returns false if the disk is full. */
+bool
+inode_allocate (struct inode *inode, off_t length)
+{
+  struct inode_disk *disk_inode = malloc (BLOCK_SECTOR_SIZE);
+  bool success = true;
+
+  if (disk_inode == NULL)
+    return false;
+  journal_begin ();
+  lock_acquire (&inode->extend_lock);
+  bc_read (inode->sector, disk_inode, 0, BLOCK_SECTOR_SIZE, 0);
+  if (length > disk_inode->length)
+    {
+      off_t first_new = bytes_to_sectors (disk_inode->length);
+
+      success = inode_update_file_length (disk_inode, disk_inode->length,
+                                          length - 1, false);
+      if (success && length % BLOCK_SECTOR_SIZE != 0
+          && (length - 1) / BLOCK_SECTOR_SIZE >= first_new)
+        {
+          void *zeroes = calloc (1, BLOCK_SECTOR_SIZE);
+          if (zeroes != NULL)
+            bc_write (byte_to_sector (disk_inode, length - 1), zeroes, 0,
+                      BLOCK_SECTOR_SIZE, 0);
+          free (zeroes);
+          success = zeroes != NULL;
+        }
+      bc_write_meta (inode->sector, disk_inode, 0, BLOCK_SECTOR_SIZE, 0);
+    }
+  lock_release (&inode->extend_lock);
+  journal_end ();
+  free (disk_inode);
+  return success;
+}
+
+/* Does the work of inode_write_at() and, if DIRECT is true,
+   inode_write_at_direct(). */
+static off_t
+write_at (struct inode *inode, const void *buffer_, off_t size,
+          off_t offset, bool direct) 
+{
 
   const uint8_t *buffer = buffer_;
   off_t bytes_written = 0;
   uint8_t *bounce = NULL;
+  bool filled_hole = false;
   struct inode_disk *disk_inode = malloc(BLOCK_SECTOR_SIZE);
   if(disk_inode == NULL)
   return 0;
@@ -327,16 +418,21 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
     return -1;
   }
   
+  inode->write_cnt++;
   int old_length = disk_inode->length;
   int write_end = offset + size -1;
+  /* Directory and free map contents are metadata. */
+  bool meta = disk_inode->is_dir || inode->sector == FREE_MAP_SECTOR;
+  journal_begin ();
  lock_acquire(&inode->extend_lock);
   if(write_end > old_length - 1){
     //printf("length update, write_end:%d\n", write_end);
-inode_update_file_length(disk_inode, old_length, write_end);
+    /* Anything between the old end and OFFSET stays a hole. */
+inode_update_file_length(disk_inode, offset > old_length ? offset : old_length, write_end, true);
   }
     
 
-     bc_write(inode->sector, disk_inode, 0, BLOCK_SECTOR_SIZE, 0); 
+     bc_write_meta(inode->sector, disk_inode, 0, BLOCK_SECTOR_SIZE, 0); 
   while (size > 0) 
     {
       /* Sector to write, starting byte offset within sector. */
@@ -353,9 +449,33 @@ inode_update_file_length(disk_inode, old_length, write_end);
       int chunk_size = size < min_left ? size : min_left;
       if (chunk_size <= 0)
         break;
+      if (sector_idx == 0)
+        {
+          /* Writing into a hole gives it a sector. */
+          inode_update_file_length (disk_inode, offset, offset, true);
+          sector_idx = byte_to_sector (disk_inode, offset);
+          if (sector_idx == 0)
+            break;
+          filled_hole = true;
+        }
 
-
-          bc_write (sector_idx, buffer, bytes_written, chunk_size, sector_ofs);
+          if (meta)
+            bc_write_meta (sector_idx, buffer, bytes_written, chunk_size, sector_ofs);
+          else if (direct && chunk_size == BLOCK_SECTOR_SIZE)
+            {
+              /* Take along the following whole sectors that are
+                 also next to each other on disk. */
+              size_t cnt = 1;
+              while ((off_t) (cnt + 1) * BLOCK_SECTOR_SIZE <= size
+                     && byte_to_sector (disk_inode,
+                                        offset + cnt * BLOCK_SECTOR_SIZE)
+                        == sector_idx + cnt)
+                cnt++;
+              bc_write_direct (sector_idx, buffer + bytes_written, cnt);
+              chunk_size = cnt * BLOCK_SECTOR_SIZE;
+            }
+          else
+            bc_write (sector_idx, buffer, bytes_written, chunk_size, sector_ofs);
 
 
       /* Advance. */
@@ -363,10 +483,13 @@ inode_update_file_length(disk_inode, old_length, write_end);
       offset += chunk_size;
       bytes_written += chunk_size;
     }
+  if (filled_hole)
+    bc_write_meta (inode->sector, disk_inode, 0, BLOCK_SECTOR_SIZE, 0);
  
   free(disk_inode);
 
         lock_release(&inode->extend_lock);
+  journal_end ();
   return bytes_written;
 }
 
@@ -401,6 +524,15 @@ inode_length (const struct inode *inode)
   return length;
 }
 
+/* Returns the number of times INODE has been written since it
+   was opened.  Lets a caller that keeps INODE open tell whether
+   data it derived from the contents is still current. */
+unsigned
+inode_write_cnt (const struct inode *inode)
+{
+  return inode->write_cnt;
+}
+
 off_t inode_pos(const struct inode *inode){
   return inode->pos;
 } 
@@ -415,156 +547,205 @@ bc_read(inode->sector, inode_disk, 0, BLOCK_SECTOR_SIZE,0);
 return true;
 }
 
+/* Fills in SEC_LOC with the location of the data sector that
+   holds byte offset POS. */
 static void locate_byte(off_t pos, struct sector_location *sec_loc){
 off_t pos_sector = pos / BLOCK_SECTOR_SIZE;
+off_t span = 1;
+int level, i;
 if(pos_sector < DIRECT_BLOCK_ENTRIES){
 sec_loc->directness = NORMAL_DIRECT;
-sec_loc->index1 = pos_sector;
+sec_loc->index[0] = pos_sector;
+return;
 }
-else if(pos_sector < DIRECT_BLOCK_ENTRIES + INDIRECT_BLOCK_ENTRIES){
-sec_loc->directness = INDIRECT;
-sec_loc->index1 = pos_sector - DIRECT_BLOCK_ENTRIES;
-}
-else if(pos_sector < DIRECT_BLOCK_ENTRIES + INDIRECT_BLOCK_ENTRIES * (INDIRECT_BLOCK_ENTRIES + 1)){
-sec_loc->directness = DOUBLE_INDIRECT;
-sec_loc->index1 = (pos_sector - (DIRECT_BLOCK_ENTRIES + INDIRECT_BLOCK_ENTRIES)) / INDIRECT_BLOCK_ENTRIES;
-sec_loc->index2 = (pos_sector - (DIRECT_BLOCK_ENTRIES + INDIRECT_BLOCK_ENTRIES)) % INDIRECT_BLOCK_ENTRIES;
+pos_sector -= DIRECT_BLOCK_ENTRIES;
+/* An index block LEVEL levels up covers
+   INDIRECT_BLOCK_ENTRIES**LEVEL data sectors. */
+for(level = INDIRECT; level <= TRIPLE_INDIRECT; level++){
+  span *= INDIRECT_BLOCK_ENTRIES;
+  if(pos_sector < span){
+    sec_loc->directness = level;
+    for(i = level - 1; i >= 0; i--){
+      sec_loc->index[i] = pos_sector % INDIRECT_BLOCK_ENTRIES;
+      pos_sector /= INDIRECT_BLOCK_ENTRIES;
+    }
+    return;
+  }
+  pos_sector -= span;
 }
-else{
 sec_loc->directness = OUT_LIMIT;
 }
+
+/* Returns the inode member that SEC_LOC starts from: the direct
+   map entry itself, or the top index block's sector.  Returns a
+   null pointer for OUT_LIMIT. */
+static block_sector_t *map_root(struct inode_disk *inode_disk, const struct sector_location *sec_loc){
+  switch(sec_loc->directness){
+    case NORMAL_DIRECT:
+    return &inode_disk->direct_map_table[sec_loc->index[0]];
+    case INDIRECT:
+    return &inode_disk->indirect_block_sec;
+    case DOUBLE_INDIRECT:
+    return &inode_disk->double_indirect_block_sec;
+    case TRIPLE_INDIRECT:
+    return &inode_disk->triple_indirect_block_sec;
+    default:
+    return NULL;
+  }
 }
 
+/* Returns the data sector at SEC_LOC, or 0 if it is a hole.
+   Reads only the one map entry needed from each index block. */
+static block_sector_t lookup_sector(const struct inode_disk *inode_disk, const struct sector_location *sec_loc){
+  block_sector_t *root = map_root((struct inode_disk *) inode_disk, sec_loc);
+  block_sector_t sector;
+  int level;
+  if(root == NULL)
+    return 0;
+  sector = *root;
+  for(level = 0; level < (int) sec_loc->directness && sector != 0; level++)
+    bc_read(sector, &sector, 0, sizeof sector, map_table_offset(sec_loc->index[level]));
+  return sector;
+}
 
+/* Allocates an index block with every entry a hole and stores
+   its sector in *SECTOR. */
+static bool new_index_block(block_sector_t *sector){
+  static char zeroes[BLOCK_SECTOR_SIZE];
+  if(!free_map_allocate(1, sector))
+    return false;
+  bc_write_meta(*sector, zeroes, 0, BLOCK_SECTOR_SIZE, 0);
+  return true;
+}
+
+/* Makes NEW_SECTOR the data sector at SEC_LOC, allocating any
+   index blocks on the way that do not exist yet.  The caller
+   must write back INODE_DISK. */
 static bool register_sector(struct inode_disk *inode_disk, block_sector_t new_sector, struct sector_location sec_loc){
-  struct inode_indirect_block *new_block = NULL;
-  block_sector_t sector_idx, idx;
-  switch(sec_loc.directness){  
-    case NORMAL_DIRECT:
-    //printf("normal\n"); 
-    inode_disk->direct_map_table[sec_loc.index1] = new_sector;
-    break;
-    case INDIRECT:
-    if(inode_disk->indirect_block_sec == 0){
-      if(!free_map_allocate(1, &sector_idx))
-      return false;
-      inode_disk->indirect_block_sec = sector_idx;
-    }
-    new_block = malloc (BLOCK_SECTOR_SIZE);
-    bc_read(inode_disk->indirect_block_sec, new_block, 0, BLOCK_SECTOR_SIZE, 0);
-    new_block->map_table[sec_loc.index1] = new_sector;
-    bc_write(inode_disk->indirect_block_sec, new_block, 0, BLOCK_SECTOR_SIZE, 0);
-    break;
-    case DOUBLE_INDIRECT: 
-    new_block = malloc (BLOCK_SECTOR_SIZE);
-    if(inode_disk->double_indirect_block_sec == 0){
-      if(!free_map_allocate(1, &sector_idx))
-      return false;
-      inode_disk->double_indirect_block_sec = sector_idx;
-      int i;
-      for(i=0;i<INDIRECT_BLOCK_ENTRIES;i++){
-        if(!free_map_allocate(1, &idx)){
-        free_map_release(1, sector_idx);
-        inode_disk->double_indirect_block_sec = 0;
+  block_sector_t *root = map_root(inode_disk, &sec_loc);
+  block_sector_t sector, next;
+  int level;
+  if(root == NULL)
+    return false;
+  if(sec_loc.directness == NORMAL_DIRECT){
+    *root = new_sector;
+    return true;
+  }
+  if(*root == 0 && !new_index_block(root))
+    return false;
+  sector = *root;
+  for(level = 0; level < (int) sec_loc.directness - 1; level++){
+    off_t ofs = map_table_offset(sec_loc.index[level]);
+    bc_read(sector, &next, 0, sizeof next, ofs);
+    if(next == 0){
+      if(!new_index_block(&next))
         return false;
-        }
-        new_block->map_table[i] = idx;
-      }
-      bc_write(sector_idx, new_block, 0, BLOCK_SECTOR_SIZE, 0);
+      bc_write_meta(sector, &next, 0, sizeof next, ofs);
     }
-    bc_read(inode_disk->double_indirect_block_sec, new_block, 0, BLOCK_SECTOR_SIZE, 0);
-    sector_idx = new_block->map_table[sec_loc.index1];
-    bc_read(sector_idx, new_block, 0, BLOCK_SECTOR_SIZE, 0);
-    new_block->map_table[sec_loc.index2] = new_sector;
-    bc_write(sector_idx, new_block, 0, BLOCK_SECTOR_SIZE, 0);
-    break;
-    default:
-    return false;
+    sector = next;
   }
-  if(new_block != NULL)
-    free(new_block);
+  bc_write_meta(sector, &new_sector, 0, sizeof new_sector, map_table_offset(sec_loc.index[level]));
   return true;
 }
 
-bool inode_update_file_length(struct inode_disk *inode_disk, off_t start_pos, off_t end_pos){
+/* Returns true if file sector SECTOR_NO of INODE_DISK has a
+   data sector, false if it is a hole. */
+static bool sector_allocated(const struct inode_disk *inode_disk, size_t sector_no){
+  struct sector_location sec_loc;
+  locate_byte((off_t) sector_no * BLOCK_SECTOR_SIZE, &sec_loc);
+  return lookup_sector(inode_disk, &sec_loc) != 0;
+}
 
- // printf("%d %d %d\n", inode_disk->length, start_pos, end_pos);
-  off_t size, offset;
+/* Makes INODE_DISK at least END_POS + 1 bytes long and allocates
+   the sectors holding bytes START_POS through END_POS that are
+   still holes.  They are taken in one contiguous run when the
+   free map has one, which also costs a single free map update
+   instead of one per sector.  Any other sectors the new length
+   covers stay holes.  New sectors are zeroed if ZERO is true.
+   Returns false if the disk is full or the file would be too
+   big, with the length covering the sectors allocated so far. */
+bool inode_update_file_length(struct inode_disk *inode_disk, off_t start_pos, off_t end_pos, bool zero){
+  static char zeroes[BLOCK_SECTOR_SIZE];
+  size_t first = start_pos / BLOCK_SECTOR_SIZE;
+  size_t last = end_pos / BLOCK_SECTOR_SIZE;
+  /* Sectors past the old end are known to be holes. */
+  size_t old_cnt = bytes_to_sectors(inode_disk->length);
+  size_t new_cnt = 0, s;
+  block_sector_t run = 0;
+  size_t run_left = 0;
   struct sector_location sec_loc;
-  size = end_pos - start_pos + 1;
-  offset = start_pos;
-  void *zeroes = malloc(BLOCK_SECTOR_SIZE);
-  memset(zeroes, 0, BLOCK_SECTOR_SIZE);
-  while (size > 0) 
-    {
-      block_sector_t sector_idx;
-      int sector_ofs = offset % BLOCK_SECTOR_SIZE;
-      off_t inode_left = end_pos + 1 - offset;
-      int sector_left = BLOCK_SECTOR_SIZE - sector_ofs;
-      int min_left = inode_left < sector_left ? inode_left : sector_left;
-      int chunk_size = size < min_left ? size : min_left;
-      if(sector_ofs > 0){
 
-      }
-      else{
-        if(free_map_allocate(1, &sector_idx)){
-          locate_byte(offset, &sec_loc);
-        register_sector(inode_disk, sector_idx, sec_loc);
-        }
-        else{
-          free(zeroes);
-          return false;
-        }
-        bc_write(sector_idx, zeroes, 0, BLOCK_SECTOR_SIZE, 0);
-      }
-            
-      /* Advance. */
-      size -= chunk_size;
-      offset += chunk_size;
-      inode_disk->length = offset;
+  for(s = first; s <= last; s++)
+    if(s >= old_cnt || !sector_allocated(inode_disk, s))
+      new_cnt++;
+  if(new_cnt > 1 && free_map_allocate(new_cnt, &run))
+    run_left = new_cnt;
+  for(s = first; s <= last; s++){
+    block_sector_t sector_idx;
+    off_t end;
+    if(s < old_cnt && sector_allocated(inode_disk, s))
+      continue;
+    if(run_left > 0){
+      sector_idx = run++;
+      run_left--;
     }
-  free (zeroes);
-    //printf("%d %d %d\n", inode_disk->length, start_pos, end_pos);
+    else if(!free_map_allocate(1, &sector_idx))
+      return false;
+    locate_byte((off_t) s * BLOCK_SECTOR_SIZE, &sec_loc);
+    if(!register_sector(inode_disk, sector_idx, sec_loc)){
+      free_map_release(sector_idx, 1);
+      if(run_left > 0)
+        free_map_release(run, run_left);
+      return false;
+    }
+    /* A new file block is ordered data; a new directory
+       block is metadata. */
+    if(zero && inode_disk->is_dir)
+      bc_write_meta(sector_idx, zeroes, 0, BLOCK_SECTOR_SIZE, 0);
+    else if(zero)
+      bc_write(sector_idx, zeroes, 0, BLOCK_SECTOR_SIZE, 0);
+    end = s == last ? end_pos + 1 : (off_t) (s + 1) * BLOCK_SECTOR_SIZE;
+    if(inode_disk->length < end)
+      inode_disk->length = end;
+  }
+  if(inode_disk->length < end_pos + 1)
+    inode_disk->length = end_pos + 1;
   return true;
-
-
 }
 
-static void free_inode_sectors(struct inode_disk *inode_disk){
-  //printf("free\n");
-  int i, j; 
-  struct inode_indirect_block *ind_block_1, *ind_block_2;
-  if(inode_disk->double_indirect_block_sec > 0){
-   bc_read(inode_disk->double_indirect_block_sec, ind_block_1, 0, BLOCK_SECTOR_SIZE, 0);
-   i = 0;
-   while(ind_block_1->map_table[i] > 0){
-     bc_read(ind_block_1->map_table[i], ind_block_2, 0, BLOCK_SECTOR_SIZE, 0);
-     j = 0;
-     while(ind_block_2->map_table[j] > 0){
-       free_map_release(ind_block_2->map_table[j], 1);
-       j++;
-     }
-     free_map_release(ind_block_1->map_table[i],1);
-     i++;
-   }
-   free_map_release(inode_disk->double_indirect_block_sec,1);
-  }
-
-  if(inode_disk->indirect_block_sec > 0){
-    bc_read(inode_disk->indirect_block_sec, ind_block_1, 0, BLOCK_SECTOR_SIZE, 0);
-    i = 0;
-    while(ind_block_1->map_table[i] > 0){
-     free_map_release(ind_block_1->map_table[i], 1);
-     i++;
-   }
-   free_map_release(inode_disk->indirect_block_sec, 1);
+/* Releases index block SECTOR, which is LEVEL levels above the
+   data, and every sector below it. */
+static void free_index_block(block_sector_t sector, int level){
+  struct inode_indirect_block *ind_block = malloc(BLOCK_SECTOR_SIZE);
+  int i;
+  if(ind_block != NULL){
+    bc_read(sector, ind_block, 0, BLOCK_SECTOR_SIZE, 0);
+    for(i=0;i<INDIRECT_BLOCK_ENTRIES;i++){
+      if(ind_block->map_table[i] == 0)
+        continue;
+      if(level > 1)
+        free_index_block(ind_block->map_table[i], level - 1);
+      else
+        free_map_release(ind_block->map_table[i], 1);
+    }
+    free(ind_block);
   }
+  free_map_release(sector, 1);
+}
 
-  i = 0;
-  while(inode_disk->direct_map_table[i] > 0){
-    free_map_release(inode_disk->direct_map_table[i], 1);
-    i++;
-  }
+/* Releases every sector of INODE_DISK's data and index blocks,
+   skipping holes. */
+static void free_inode_sectors(struct inode_disk *inode_disk){
+  int i;
+  for(i=0;i<DIRECT_BLOCK_ENTRIES;i++)
+    if(inode_disk->direct_map_table[i] != 0)
+      free_map_release(inode_disk->direct_map_table[i], 1);
+  if(inode_disk->indirect_block_sec != 0)
+    free_index_block(inode_disk->indirect_block_sec, INDIRECT);
+  if(inode_disk->double_indirect_block_sec != 0)
+    free_index_block(inode_disk->double_indirect_block_sec, DOUBLE_INDIRECT);
+  if(inode_disk->triple_indirect_block_sec != 0)
+    free_index_block(inode_disk->triple_indirect_block_sec, TRIPLE_INDIRECT);
 }
 
 
@@ -0,0 +1,268 @@
+#include "filesys/journal.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/buffer_cache.h"
+#include "filesys/filesys.h"
+#include "devices/timer.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* A write-ahead journal for file system metadata.
+
+   Inode sectors, indirect blocks, directory contents, and the
+   free map are written through bc_write_meta(), which adds the
+   sector to the running transaction and pins its buffer in the
+   cache.  Pinned buffers are never evicted or written back in
+   place, so no metadata reaches its home location before the
+   transaction that changed it has committed.
+
+   File system operations are bracketed by journal_begin() and
+   journal_end().  A transaction is not committed when each
+   operation ends but only when the last one in progress ends and
+   the transaction is large or old, so that many creates,
+   removes, and writes share a single journal flush.  fsync() and
+   shutdown commit right away.
+
+   A commit works in ordered mode: dirty file data goes to disk
+   first, so committed metadata never points to blocks whose
+   contents were not written.  Then the metadata sectors go into
+   the journal slots, the header that names them is written, the
+   sectors are written in place, and the header is cleared.  At
+   mount, a header that still names sectors belongs to a commit
+   interrupted after its header was written, and replaying it
+   takes at most JOURNAL_SLOTS sector copies. */
+
+/* Identifies a journal header. */
+#define JOURNAL_MAGIC 0x4a524e4c
+
+/* A transaction this big is committed when its last operation
+   ends. */
+#define COMMIT_SECTORS (JOURNAL_SLOTS * 3 / 4)
+
+/* A transaction this old, in timer ticks, is committed when its
+   last operation ends. */
+#define COMMIT_TICKS (5 * TIMER_FREQ)
+
+/* On-disk journal header, at JOURNAL_SECTOR.
+   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+struct journal_header
+  {
+    unsigned magic;                     /* JOURNAL_MAGIC. */
+    uint32_t seq;                       /* Commit sequence number. */
+    uint32_t cnt;                       /* Sectors in slots, 0 if none. */
+    block_sector_t sectors[JOURNAL_SLOTS]; /* Home of each slot. */
+    uint8_t unused[BLOCK_SECTOR_SIZE - 12 - 4 * JOURNAL_SLOTS];
+  };
+
+/* The running transaction. */
+static block_sector_t sectors[JOURNAL_SLOTS]; /* Sectors it changed. */
+static size_t sector_cnt;               /* Number of SECTORS. */
+static int outstanding;                 /* Operations in progress. */
+static int64_t start_ticks;             /* When the last commit ended. */
+static uint32_t seq;                    /* Sequence number of last commit. */
+
+/* If true, journal_done() stops after writing the commit, as if
+   the power failed before its sectors reached their homes. */
+bool journal_crash;
+
+/* Protects the members above and serializes commits. */
+static struct lock journal_lock;
+
+static void commit (void);
+static bool write_commit (void);
+static void checkpoint (void);
+static void clear_header (void);
+
+/* Initializes the journal.  If FORMAT is true, writes an empty
+   journal; otherwise, replays a commit interrupted by a crash. */
+void
+journal_init (bool format)
+{
+  struct journal_header h;
+  uint8_t *data;
+  size_t i;
+
+  ASSERT (sizeof h == BLOCK_SECTOR_SIZE);
+  lock_init (&journal_lock);
+  sector_cnt = outstanding = 0;
+  start_ticks = timer_ticks ();
+
+  if (format)
+    {
+      seq = 0;
+      clear_header ();
+      return;
+    }
+
+  block_read (fs_device, JOURNAL_SECTOR, &h);
+  if (h.magic != JOURNAL_MAGIC)
+    PANIC ("no journal on file system device--reformat it");
+  seq = h.seq;
+  if (h.cnt == 0)
+    return;
+  if (h.cnt > JOURNAL_SLOTS)
+    PANIC ("corrupt journal header");
+
+  data = malloc (BLOCK_SECTOR_SIZE);
+  if (data == NULL)
+    PANIC ("journal_init: out of memory");
+  for (i = 0; i < h.cnt; i++)
+    {
+      block_read (fs_device, JOURNAL_SECTOR + 1 + i, data);
+      block_write (fs_device, h.sectors[i], data);
+    }
+  free (data);
+  clear_header ();
+  printf ("journal: replayed %"PRIu32" sectors from commit %"PRIu32".\n",
+          h.cnt, h.seq);
+}
+
+/* Begins a file system operation.  Operations may nest. */
+void
+journal_begin (void)
+{
+  lock_acquire (&journal_lock);
+  outstanding++;
+  lock_release (&journal_lock);
+}
+
+/* Ends a file system operation.  If no other operation is in
+   progress, commits the running transaction when it is big or
+   old enough. */
+void
+journal_end (void)
+{
+  lock_acquire (&journal_lock);
+  ASSERT (outstanding > 0);
+  if (--outstanding == 0
+      && sector_cnt > 0
+      && (sector_cnt >= COMMIT_SECTORS
+          || timer_elapsed (start_ticks) >= COMMIT_TICKS))
+    commit ();
+  lock_release (&journal_lock);
+}
+
+/* Makes room for one more sector in the running transaction.
+   An operation that changes more metadata than fits in the
+   journal is split across transactions here. */
+void
+journal_reserve (void)
+{
+  lock_acquire (&journal_lock);
+  if (sector_cnt == JOURNAL_SLOTS)
+    commit ();
+  lock_release (&journal_lock);
+}
+
+/* Adds SECTOR, whose buffer bc_write_meta() has just pinned, to
+   the running transaction.  journal_reserve() must have been
+   called first. */
+void
+journal_add (block_sector_t sector)
+{
+  lock_acquire (&journal_lock);
+  ASSERT (sector_cnt < JOURNAL_SLOTS);
+  sectors[sector_cnt++] = sector;
+  lock_release (&journal_lock);
+}
+
+/* Commits the running transaction and writes all cached file
+   data to disk. */
+void
+journal_commit (void)
+{
+  lock_acquire (&journal_lock);
+  commit ();
+  lock_release (&journal_lock);
+}
+
+/* Commits the running transaction at shutdown.  With -jcrash,
+   the sectors it names are left for journal_init() to replay at
+   the next mount, so that recovery can be tested. */
+void
+journal_done (void)
+{
+  lock_acquire (&journal_lock);
+  if (!journal_crash)
+    commit ();
+  else if (write_commit ())
+    printf ("journal: leaving commit %"PRIu32" unapplied (-jcrash).\n",
+            seq);
+  lock_release (&journal_lock);
+}
+
+/* Commits the running transaction.  Must be called with
+   journal_lock held. */
+static void
+commit (void)
+{
+  if (write_commit ())
+    checkpoint ();
+}
+
+/* Writes all cached file data, then the running transaction's
+   sectors and the header that commits them, to the journal.
+   Returns false, having written only the file data, if the
+   transaction is empty.  Must be called with journal_lock
+   held. */
+static bool
+write_commit (void)
+{
+  struct journal_header h;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&journal_lock));
+
+  /* Ordered mode: data before the metadata that refers to it. */
+  bc_flush_all_entries ();
+  if (sector_cnt == 0)
+    return false;
+
+  for (i = 0; i < sector_cnt; i++)
+    {
+      struct buffer_head *bh = bc_lookup (sectors[i]);
+      ASSERT (bh != NULL && bh->journaled);
+      block_write (fs_device, JOURNAL_SECTOR + 1 + i, bh->data);
+    }
+  memset (&h, 0, sizeof h);
+  h.magic = JOURNAL_MAGIC;
+  h.seq = ++seq;
+  h.cnt = sector_cnt;
+  memcpy (h.sectors, sectors, sector_cnt * sizeof *sectors);
+  block_write (fs_device, JOURNAL_SECTOR, &h);
+  return true;
+}
+
+/* Writes the sectors of the transaction just committed in place
+   and retires it.  Must be called with journal_lock held. */
+static void
+checkpoint (void)
+{
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&journal_lock));
+
+  for (i = 0; i < sector_cnt; i++)
+    {
+      struct buffer_head *bh = bc_lookup (sectors[i]);
+      bc_flush_entry (bh);
+      bh->journaled = false;
+    }
+  clear_header ();
+  sector_cnt = 0;
+  start_ticks = timer_ticks ();
+}
+
+/* Writes a journal header that names no sectors. */
+static void
+clear_header (void)
+{
+  struct journal_header h;
+
+  memset (&h, 0, sizeof h);
+  h.magic = JOURNAL_MAGIC;
+  h.seq = seq;
+  block_write (fs_device, JOURNAL_SECTOR, &h);
+}
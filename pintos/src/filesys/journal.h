@@ -0,0 +1,24 @@
+#ifndef FILESYS_JOURNAL_H
+#define FILESYS_JOURNAL_H
+
+#include <stdbool.h>
+#include "devices/block.h"
+
+/* Metadata sectors one transaction can hold.  The journal takes
+   up this many sectors plus a header, starting at
+   JOURNAL_SECTOR. */
+#define JOURNAL_SLOTS 32
+
+/* If true, shutdown leaves its commit in the journal for the
+   next mount to replay.  Set by the -jcrash option. */
+extern bool journal_crash;
+
+void journal_init (bool format);
+void journal_begin (void);
+void journal_end (void);
+void journal_reserve (void);
+void journal_add (block_sector_t);
+void journal_commit (void);
+void journal_done (void);
+
+#endif /* filesys/journal.h */
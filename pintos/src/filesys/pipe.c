@@ -0,0 +1,178 @@
+#include "filesys/pipe.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Bytes of data a pipe can hold. */
+#define PIPE_SIZE PGSIZE
+
+/* A pipe: a ring buffer shared by the files open on its two
+   ends.  Data never passes through the file system, so pipes are
+   used without filesys_lock. */
+struct pipe
+  {
+    struct lock lock;           /* Protects all the members below. */
+    struct condition not_empty; /* Signaled when data arrives. */
+    struct condition not_full;  /* Signaled when space frees up. */
+    uint8_t *buffer;            /* PIPE_SIZE bytes of data. */
+    size_t head;                /* Offset of the oldest byte. */
+    size_t cnt;                 /* Number of bytes in BUFFER. */
+    int readers;                /* Open read ends. */
+    int writers;                /* Open write ends. */
+  };
+
+/* Creates and returns an empty pipe with one open read end and
+   one open write end, or returns a null pointer if memory is
+   exhausted. */
+struct pipe *
+pipe_create (void)
+{
+  struct pipe *pipe = malloc (sizeof *pipe);
+
+  if (pipe == NULL)
+    return NULL;
+  pipe->buffer = palloc_get_page (0);
+  if (pipe->buffer == NULL)
+    {
+      free (pipe);
+      return NULL;
+    }
+  lock_init (&pipe->lock);
+  cond_init (&pipe->not_empty);
+  cond_init (&pipe->not_full);
+  pipe->head = 0;
+  pipe->cnt = 0;
+  pipe->readers = 1;
+  pipe->writers = 1;
+  return pipe;
+}
+
+/* Opens another end of PIPE, a write end if WRITER, otherwise a
+   read end. */
+void
+pipe_reopen (struct pipe *pipe, bool writer)
+{
+  lock_acquire (&pipe->lock);
+  if (writer)
+    pipe->writers++;
+  else
+    pipe->readers++;
+  lock_release (&pipe->lock);
+}
+
+/* Closes an end of PIPE, a write end if WRITER, otherwise a read
+   end.  Closing the last write end lets readers see end of file;
+   closing the last read end makes writes fail.  The pipe is freed
+   when both kinds of end are gone. */
+void
+pipe_close (struct pipe *pipe, bool writer)
+{
+  bool last;
+
+  lock_acquire (&pipe->lock);
+  if (writer)
+    {
+      ASSERT (pipe->writers > 0);
+      if (--pipe->writers == 0)
+        cond_broadcast (&pipe->not_empty, &pipe->lock);
+    }
+  else
+    {
+      ASSERT (pipe->readers > 0);
+      if (--pipe->readers == 0)
+        cond_broadcast (&pipe->not_full, &pipe->lock);
+    }
+  last = pipe->readers == 0 && pipe->writers == 0;
+  lock_release (&pipe->lock);
+
+  if (last)
+    {
+      palloc_free_page (pipe->buffer);
+      free (pipe);
+    }
+}
+
+/* Reads up to SIZE bytes from PIPE into BUFFER.  If PIPE is
+   empty, waits for data to arrive, unless NONBLOCK is true, in
+   which case returns -1 at once.  Returns the number of bytes
+   read, which is 0 only at end of file: PIPE is empty and has no
+   write ends left. */
+off_t
+pipe_read (struct pipe *pipe, void *buffer, off_t size, bool nonblock)
+{
+  size_t n, first;
+
+  if (size <= 0)
+    return 0;
+
+  lock_acquire (&pipe->lock);
+  while (pipe->cnt == 0 && pipe->writers > 0)
+    {
+      if (nonblock)
+        {
+          lock_release (&pipe->lock);
+          return -1;
+        }
+      cond_wait (&pipe->not_empty, &pipe->lock);
+    }
+
+  /* Copy out at most two pieces, either side of the wrap. */
+  n = (size_t) size < pipe->cnt ? (size_t) size : pipe->cnt;
+  first = n < PIPE_SIZE - pipe->head ? n : PIPE_SIZE - pipe->head;
+  memcpy (buffer, pipe->buffer + pipe->head, first);
+  memcpy ((uint8_t *) buffer + first, pipe->buffer, n - first);
+  pipe->head = (pipe->head + n) % PIPE_SIZE;
+  pipe->cnt -= n;
+  if (n > 0)
+    cond_broadcast (&pipe->not_full, &pipe->lock);
+  lock_release (&pipe->lock);
+
+  return n;
+}
+
+/* Writes SIZE bytes from BUFFER into PIPE, waiting for readers
+   to make room as needed.  If NONBLOCK is true, writes only what
+   fits without waiting.  Returns the number of bytes written, or
+   -1 if PIPE has no read ends or if NONBLOCK is true and PIPE is
+   full. */
+off_t
+pipe_write (struct pipe *pipe, const void *buffer_, off_t size,
+            bool nonblock)
+{
+  const uint8_t *buffer = buffer_;
+  off_t written = 0;
+
+  lock_acquire (&pipe->lock);
+  while (written < size)
+    {
+      size_t tail, n, first;
+
+      if (pipe->readers == 0)
+        break;
+      if (pipe->cnt == PIPE_SIZE)
+        {
+          if (nonblock)
+            break;
+          cond_wait (&pipe->not_full, &pipe->lock);
+          continue;
+        }
+
+      /* Copy in at most two pieces, either side of the wrap. */
+      tail = (pipe->head + pipe->cnt) % PIPE_SIZE;
+      n = PIPE_SIZE - pipe->cnt;
+      if ((size_t) (size - written) < n)
+        n = size - written;
+      first = n < PIPE_SIZE - tail ? n : PIPE_SIZE - tail;
+      memcpy (pipe->buffer + tail, buffer + written, first);
+      memcpy (pipe->buffer, buffer + written + first, n - first);
+      pipe->cnt += n;
+      written += n;
+      cond_broadcast (&pipe->not_empty, &pipe->lock);
+    }
+  lock_release (&pipe->lock);
+
+  return written > 0 || size == 0 ? written : -1;
+}
@@ -0,0 +1,57 @@
+#ifndef __LIB_AIO_H
+#define __LIB_AIO_H
+
+#include <stdint.h>
+
+/* Operations in an aio_sqe. */
+#define AIO_READ 1              /* Like pread(). */
+#define AIO_WRITE 2             /* Like pwrite(). */
+#define AIO_FSYNC 3             /* Like fsync(). */
+
+/* Entries in each queue of an aio_ring. */
+#define AIO_ENTRIES 64
+
+/* Largest LEN in an aio_sqe. */
+#define AIO_MAX_LEN 16384
+
+/* Most bytes of read and write data a process's requests in
+   flight may hold in the kernel at once.  A request that would
+   go past this completes at once with a result of -1. */
+#define AIO_MAX_BUFFERED (4 * AIO_MAX_LEN)
+
+/* Submission queue entry: one request. */
+struct aio_sqe
+  {
+    uint32_t opcode;            /* AIO_READ, AIO_WRITE, or AIO_FSYNC. */
+    int32_t fd;                 /* File descriptor. */
+    void *buf;                  /* Data buffer. */
+    uint32_t len;               /* Bytes to transfer. */
+    uint32_t offset;            /* File offset. */
+    uint32_t user_data;         /* Copied to the completion. */
+  };
+
+/* Completion queue entry: the result of one request. */
+struct aio_cqe
+  {
+    uint32_t user_data;         /* From the request. */
+    int32_t res;                /* Bytes transferred, or -1. */
+  };
+
+/* A process's asynchronous I/O queues, one page mapped into its
+   address space by aio_setup() and shared with the kernel.
+
+   The process adds requests to SQ at SQ_TAIL and takes
+   completions from CQ at CQ_HEAD; the kernel takes requests at
+   SQ_HEAD and adds completions at CQ_TAIL.  The indexes only
+   count up, and entry I of a queue is at I % AIO_ENTRIES.  A
+   queue is empty when its head equals its tail and full when
+   they are AIO_ENTRIES apart. */
+struct aio_ring
+  {
+    volatile uint32_t sq_head, sq_tail;
+    volatile uint32_t cq_head, cq_tail;
+    struct aio_sqe sq[AIO_ENTRIES];
+    struct aio_cqe cq[AIO_ENTRIES];
+  };
+
+#endif /* lib/aio.h */
@@ -0,0 +1,22 @@
+#ifndef __LIB_DIRENT_H
+#define __LIB_DIRENT_H
+
+#include <stdbool.h>
+
+/* Maximum length of a file name in a directory entry, not
+   counting the null terminator.  Same as NAME_MAX in
+   filesys/directory.h. */
+#define DIRENT_NAME_MAX 14
+
+/* One directory entry, as returned by getdents(). */
+struct dirent
+  {
+    int inumber;                /* Inode number. */
+    bool is_dir;                /* True if a directory. */
+    char name[DIRENT_NAME_MAX + 1]; /* Null-terminated file name. */
+  };
+
+/* Maximum number of entries returned by a single getdents(). */
+#define GETDENTS_MAX 64
+
+#endif /* lib/dirent.h */
@@ -0,0 +1,17 @@
+#ifndef __LIB_IOVEC_H
+#define __LIB_IOVEC_H
+
+#include <stddef.h>
+
+/* One buffer of a vectored I/O request, as passed to readv() and
+   writev(). */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    size_t iov_len;             /* Size of buffer in bytes. */
+  };
+
+/* Maximum number of buffers in a single readv() or writev(). */
+#define IOV_MAX 32
+
+#endif /* lib/iovec.h */
@@ -0,0 +1,17 @@
+#ifndef __LIB_IPC_H
+#define __LIB_IPC_H
+
+/* Flags for pipe2(). */
+#define PIPE_NONBLOCK 1         /* Fail instead of waiting. */
+#define PIPE_CLOEXEC 2          /* Do not pass the ends on to exec. */
+
+/* Largest shared memory segment accepted by shm_map(), in
+   pages. */
+#define SHM_MAX_PAGES 256
+
+/* Most pages that all shared memory segments together may hold.
+   Segment pages are never evicted, so this bounds how much of
+   the user pool shared memory can pin. */
+#define SHM_TOTAL_PAGES 256
+
+#endif /* lib/ipc.h */
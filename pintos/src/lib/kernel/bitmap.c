@@ -60,6 +60,58 @@ byte_cnt (size_t bit_cnt)
   return sizeof (elem_type) * elem_cnt (bit_cnt);
 }
 
+/* Returns the index of the first bit in B between START and
+   END, exclusive, that is set to VALUE, or END if there is none.
+   Elements holding no such bit are skipped whole, and the bit
+   within an element is found with a single BSF instruction. */
+static size_t
+find_bit (const struct bitmap *b, size_t start, size_t end, bool value) 
+{
+  elem_type flip = value ? 0 : (elem_type) -1;
+  size_t idx, last_idx;
+  elem_type e;
+
+  if (start >= end)
+    return end;
+  idx = elem_idx (start);
+  last_idx = elem_idx (end - 1);
+  e = (b->bits[idx] ^ flip) & ~(bit_mask (start) - 1);
+  while (e == 0) 
+    {
+      if (++idx > last_idx)
+        return end;
+      e = b->bits[idx] ^ flip;
+    }
+  start = idx * ELEM_BITS + __builtin_ctzl (e);
+  return start < end ? start : end;
+}
+
+/* Returns the starting index of the first group of CNT
+   consecutive bits in B, lying entirely between START and END,
+   that are all set to VALUE, or BITMAP_ERROR if there is none.
+   Alternately skips to the next VALUE bit and to the next bit
+   that is not, so each element is examined only once or twice. */
+static size_t
+find_run (const struct bitmap *b, size_t start, size_t end, size_t cnt,
+          bool value) 
+{
+  if (cnt == 0)
+    return start;
+  while (start <= end && cnt <= end - start) 
+    {
+      size_t run_end;
+
+      start = find_bit (b, start, end, value);
+      if (cnt > end - start)
+        break;
+      run_end = find_bit (b, start, start + cnt, !value);
+      if (run_end == start + cnt)
+        return start;
+      start = run_end;
+    }
+  return BITMAP_ERROR;
+}
+
 /* Returns a bit mask in which the bits actually used in the last
    element of B's bits are set to 1 and the rest are set to 0. */
 static inline elem_type
@@ -250,16 +302,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
-  
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
-  return false;
+  return find_bit (b, start, start + cnt, value) != start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -298,15 +345,30 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
-  if (cnt <= b->bit_cnt) 
+  return find_run (b, start, b->bit_cnt, cnt, value);
+}
+
+/* Like bitmap_scan(), but if there is no suitable group at or
+   after START, looks again from the beginning of B.  Passing the
+   end of the previous allocation as START gives a next-fit
+   search, which keeps allocations from piling up at the front of
+   a busy bitmap. */
+size_t
+bitmap_scan_next_fit (const struct bitmap *b, size_t start, size_t cnt,
+                      bool value) 
+{
+  size_t idx;
+
+  ASSERT (b != NULL);
+  ASSERT (start <= b->bit_cnt);
+
+  idx = find_run (b, start, b->bit_cnt, cnt, value);
+  if (idx == BITMAP_ERROR && start > 0) 
     {
-      size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      size_t end = start + cnt - 1;
+      idx = find_run (b, 0, end < b->bit_cnt ? end : b->bit_cnt, cnt, value);
     }
-  return BITMAP_ERROR;
+  return idx;
 }
 
 /* Finds the first group of CNT consecutive bits in B at or after
@@ -74,6 +74,7 @@ void
 console_panic (void) 
 {
   use_console_lock = false;
+  serial_sync ();
 }
 
 /* Prints console statistics. */
@@ -148,13 +149,16 @@ puts (const char *s)
   return 0;
 }
 
-/* Writes the N characters in BUFFER to the console. */
+/* Writes the N characters in BUFFER to the console.  The serial
+   port gets them in one batch. */
 void
 putbuf (const char *buffer, size_t n) 
 {
   acquire_console ();
+  write_cnt += n;
+  serial_write ((const uint8_t *) buffer, n);
   while (n-- > 0)
-    putchar_have_lock (*buffer++);
+    vga_putc (*buffer++);
   release_console ();
 }
 
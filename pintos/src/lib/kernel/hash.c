@@ -18,6 +18,11 @@ static struct hash_elem *find_elem (struct hash *, struct list *,
 static void insert_elem (struct hash *, struct list *, struct hash_elem *);
 static void remove_elem (struct hash *, struct hash_elem *);
 static void rehash (struct hash *);
+static void migrate_bucket (struct hash *, struct list *);
+static void migrate_step (struct hash *);
+static void finish_migration (struct hash *);
+static void clear_buckets (struct hash *, struct list *, size_t,
+                           hash_action_func *);
 
 /* Initializes hash table H to compute hash values using HASH and
    compare hash elements using LESS, given auxiliary data AUX. */
@@ -28,6 +33,9 @@ hash_init (struct hash *h,
   h->elem_cnt = 0;
   h->bucket_cnt = 4;
   h->buckets = malloc (sizeof *h->buckets * h->bucket_cnt);
+  h->old_bucket_cnt = 0;
+  h->old_buckets = NULL;
+  h->migrate_idx = 0;
   h->hash = hash;
   h->less = less;
   h->aux = aux;
@@ -53,22 +61,13 @@ hash_init (struct hash *h,
 void
 hash_clear (struct hash *h, hash_action_func *destructor) 
 {
-  size_t i;
-
-  for (i = 0; i < h->bucket_cnt; i++) 
+  if (h->old_buckets != NULL) 
     {
-      struct list *bucket = &h->buckets[i];
-
-      if (destructor != NULL) 
-        while (!list_empty (bucket)) 
-          {
-            struct list_elem *list_elem = list_pop_front (bucket);
-            struct hash_elem *hash_elem = list_elem_to_hash_elem (list_elem);
-            destructor (hash_elem, h->aux);
-          }
-
-      list_init (bucket); 
-    }    
+      clear_buckets (h, h->old_buckets, h->old_bucket_cnt, destructor);
+      free (h->old_buckets);
+      h->old_buckets = NULL;
+    }
+  clear_buckets (h, h->buckets, h->bucket_cnt, destructor);
 
   h->elem_cnt = 0;
 }
@@ -89,6 +88,7 @@ hash_destroy (struct hash *h, hash_action_func *destructor)
   if (destructor != NULL)
     hash_clear (h, destructor);
   free (h->buckets);
+  free (h->old_buckets);
 }
 
 /* Inserts NEW into hash table H and returns a null pointer, if
@@ -98,8 +98,12 @@ hash_destroy (struct hash *h, hash_action_func *destructor)
 struct hash_elem *
 hash_insert (struct hash *h, struct hash_elem *new)
 {
-  struct list *bucket = find_bucket (h, new);
-  struct hash_elem *old = find_elem (h, bucket, new);
+  struct list *bucket;
+  struct hash_elem *old;
+
+  migrate_step (h);
+  bucket = find_bucket (h, new);
+  old = find_elem (h, bucket, new);
 
   if (old == NULL) 
     insert_elem (h, bucket, new);
@@ -114,8 +118,12 @@ hash_insert (struct hash *h, struct hash_elem *new)
 struct hash_elem *
 hash_replace (struct hash *h, struct hash_elem *new) 
 {
-  struct list *bucket = find_bucket (h, new);
-  struct hash_elem *old = find_elem (h, bucket, new);
+  struct list *bucket;
+  struct hash_elem *old;
+
+  migrate_step (h);
+  bucket = find_bucket (h, new);
+  old = find_elem (h, bucket, new);
 
   if (old != NULL)
     remove_elem (h, old);
@@ -131,6 +139,7 @@ hash_replace (struct hash *h, struct hash_elem *new)
 struct hash_elem *
 hash_find (struct hash *h, struct hash_elem *e) 
 {
+  migrate_step (h);
   return find_elem (h, find_bucket (h, e), e);
 }
 
@@ -144,7 +153,10 @@ hash_find (struct hash *h, struct hash_elem *e)
 struct hash_elem *
 hash_delete (struct hash *h, struct hash_elem *e)
 {
-  struct hash_elem *found = find_elem (h, find_bucket (h, e), e);
+  struct hash_elem *found;
+
+  migrate_step (h);
+  found = find_elem (h, find_bucket (h, e), e);
   if (found != NULL) 
     {
       remove_elem (h, found);
@@ -166,6 +178,7 @@ hash_apply (struct hash *h, hash_action_func *action)
   
   ASSERT (action != NULL);
 
+  finish_migration (h);
   for (i = 0; i < h->bucket_cnt; i++) 
     {
       struct list *bucket = &h->buckets[i];
@@ -202,6 +215,7 @@ hash_first (struct hash_iterator *i, struct hash *h)
   ASSERT (i != NULL);
   ASSERT (h != NULL);
 
+  finish_migration (h);
   i->hash = h;
   i->bucket = i->hash->buckets;
   i->elem = list_elem_to_hash_elem (list_head (i->bucket));
@@ -294,19 +308,50 @@ hash_string (const char *s_)
   return hash;
 }
 
-/* Returns a hash of integer I. */
+/* Returns a hash of integer I.
+
+   This is the 32-bit finalizer from MurmurHash3: a few shifts
+   and multiplies that make every bit of I affect every bit of
+   the result, so that the low-order bits used to pick a bucket
+   are well mixed even for keys like page addresses whose low
+   bits are all zero.  It is much cheaper than running
+   hash_bytes() over the 4 bytes of I. */
 unsigned
 hash_int (int i) 
 {
-  return hash_bytes (&i, sizeof i);
+  uint32_t x = i;
+
+  x ^= x >> 16;
+  x *= 0x85ebca6bu;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35u;
+  x ^= x >> 16;
+  return x;
+}
+
+/* Returns a hash of pointer P. */
+unsigned
+hash_ptr (const void *p) 
+{
+  return hash_int ((uintptr_t) p);
 }
 
-/* Returns the bucket in H that E belongs in. */
+/* Returns the bucket in H that E belongs in.  If H is being
+   migrated, first moves the old bucket that E would be in, so
+   that E (or an element equal to it) can only be in the bucket
+   returned. */
 static struct list *
 find_bucket (struct hash *h, struct hash_elem *e) 
 {
-  size_t bucket_idx = h->hash (e, h->aux) & (h->bucket_cnt - 1);
-  return &h->buckets[bucket_idx];
+  unsigned hash = h->hash (e, h->aux);
+
+  if (h->old_buckets != NULL)
+    {
+      size_t old_idx = hash & (h->old_bucket_cnt - 1);
+      if (old_idx >= h->migrate_idx)
+        migrate_bucket (h, &h->old_buckets[old_idx]);
+    }
+  return &h->buckets[hash & (h->bucket_cnt - 1)];
 }
 
 /* Searches BUCKET in H for a hash element equal to E.  Returns
@@ -344,35 +389,47 @@ is_power_of_2 (size_t x)
 #define BEST_ELEMS_PER_BUCKET 2 /* Ideal elems/bucket. */
 #define MAX_ELEMS_PER_BUCKET  4 /* Elems/bucket > 4: increase # of buckets. */
 
-/* Changes the number of buckets in hash table H to match the
-   ideal.  This function can fail because of an out-of-memory
-   condition, but that'll just make hash accesses less efficient;
-   we can still continue. */
+/* Old buckets migrated by each hash table operation, in addition
+   to the one the operation looks in.  A resized table starts out
+   at about BEST_ELEMS_PER_BUCKET, so this finishes a migration
+   well before the next resize is due. */
+#define MIGRATE_BUCKETS 2
+
+/* Starts changing the number of buckets in hash table H to match
+   the ideal, if it has drifted outside the range allowed by
+   MIN_ELEMS_PER_BUCKET and MAX_ELEMS_PER_BUCKET.  The elements
+   are moved to the new buckets a few at a time by later
+   operations; see migrate_step().  This function can fail
+   because of an out-of-memory condition, but that'll just make
+   hash accesses less efficient; we can still continue. */
 static void
 rehash (struct hash *h) 
 {
-  size_t old_bucket_cnt, new_bucket_cnt;
-  struct list *new_buckets, *old_buckets;
+  size_t new_bucket_cnt;
+  struct list *new_buckets;
   size_t i;
 
   ASSERT (h != NULL);
+  ASSERT (is_power_of_2 (h->bucket_cnt));
+
+  /* Let a migration in progress finish first. */
+  if (h->old_buckets != NULL)
+    return;
 
-  /* Save old bucket info for later use. */
-  old_buckets = h->buckets;
-  old_bucket_cnt = h->bucket_cnt;
+  /* Don't do anything while the load factor is in range. */
+  if (h->elem_cnt <= h->bucket_cnt * MAX_ELEMS_PER_BUCKET
+      && (h->elem_cnt >= h->bucket_cnt * MIN_ELEMS_PER_BUCKET
+          || h->bucket_cnt <= 4))
+    return;
 
   /* Calculate the number of buckets to use now.
      We want one bucket for about every BEST_ELEMS_PER_BUCKET.
      We must have at least four buckets, and the number of
      buckets must be a power of 2. */
-  new_bucket_cnt = h->elem_cnt / BEST_ELEMS_PER_BUCKET;
-  if (new_bucket_cnt < 4)
-    new_bucket_cnt = 4;
-  while (!is_power_of_2 (new_bucket_cnt))
-    new_bucket_cnt = turn_off_least_1bit (new_bucket_cnt);
-
-  /* Don't do anything if the bucket count wouldn't change. */
-  if (new_bucket_cnt == old_bucket_cnt)
+  new_bucket_cnt = 4;
+  while (new_bucket_cnt < h->elem_cnt / BEST_ELEMS_PER_BUCKET)
+    new_bucket_cnt *= 2;
+  if (new_bucket_cnt == h->bucket_cnt)
     return;
 
   /* Allocate new buckets and initialize them as empty. */
@@ -387,29 +444,79 @@ rehash (struct hash *h)
   for (i = 0; i < new_bucket_cnt; i++) 
     list_init (&new_buckets[i]);
 
-  /* Install new bucket info. */
+  /* Install new bucket info, keeping the old buckets around
+     until their elements have been migrated. */
+  h->old_buckets = h->buckets;
+  h->old_bucket_cnt = h->bucket_cnt;
+  h->migrate_idx = 0;
   h->buckets = new_buckets;
   h->bucket_cnt = new_bucket_cnt;
+}
 
-  /* Move each old element into the appropriate new bucket. */
-  for (i = 0; i < old_bucket_cnt; i++) 
+/* Moves each element in OLD_BUCKET, one of H's old buckets, into
+   the appropriate new bucket. */
+static void
+migrate_bucket (struct hash *h, struct list *old_bucket) 
+{
+  while (!list_empty (old_bucket)) 
     {
-      struct list *old_bucket;
-      struct list_elem *elem, *next;
+      struct list_elem *elem = list_pop_front (old_bucket);
+      unsigned hash = h->hash (list_elem_to_hash_elem (elem), h->aux);
+      list_push_front (&h->buckets[hash & (h->bucket_cnt - 1)], elem);
+    }
+}
+
+/* If H is being migrated, moves the next MIGRATE_BUCKETS old
+   buckets into the new ones, and frees the old buckets once they
+   have all been moved. */
+static void
+migrate_step (struct hash *h) 
+{
+  size_t i;
 
-      old_bucket = &old_buckets[i];
-      for (elem = list_begin (old_bucket);
-           elem != list_end (old_bucket); elem = next) 
+  for (i = 0; i < MIGRATE_BUCKETS && h->old_buckets != NULL; i++) 
+    {
+      migrate_bucket (h, &h->old_buckets[h->migrate_idx++]);
+      if (h->migrate_idx >= h->old_bucket_cnt) 
         {
-          struct list *new_bucket
-            = find_bucket (h, list_elem_to_hash_elem (elem));
-          next = list_next (elem);
-          list_remove (elem);
-          list_push_front (new_bucket, elem);
+          free (h->old_buckets);
+          h->old_buckets = NULL;
         }
     }
+}
+
+/* Moves any elements left in H's old buckets into the new ones,
+   so that every element is in H->BUCKETS. */
+static void
+finish_migration (struct hash *h) 
+{
+  while (h->old_buckets != NULL)
+    migrate_step (h);
+}
 
-  free (old_buckets);
+/* Removes all the elements from the BUCKET_CNT lists in BUCKETS,
+   which belong to hash table H, calling DESTRUCTOR on each of
+   them if it is non-null. */
+static void
+clear_buckets (struct hash *h, struct list *buckets, size_t bucket_cnt,
+               hash_action_func *destructor) 
+{
+  size_t i;
+
+  for (i = 0; i < bucket_cnt; i++) 
+    {
+      struct list *bucket = &buckets[i];
+
+      if (destructor != NULL) 
+        while (!list_empty (bucket)) 
+          {
+            struct list_elem *list_elem = list_pop_front (bucket);
+            struct hash_elem *hash_elem = list_elem_to_hash_elem (list_elem);
+            destructor (hash_elem, h->aux);
+          }
+
+      list_init (bucket); 
+    }    
 }
 
 /* Inserts E into BUCKET (in hash table H). */
@@ -18,7 +18,16 @@
    conversion from a struct hash_elem back to a structure object
    that contains it.  This is the same technique used in the
    linked list implementation.  Refer to lib/kernel/list.h for a
-   detailed explanation. */
+   detailed explanation.
+
+   Growing or shrinking the table does not move every element at
+   once.  Instead, a resize allocates the new bucket array and
+   keeps the old one around, and each later insertion, deletion,
+   or search migrates a couple of old buckets into the new array,
+   along with the old bucket that the element it is looking for
+   would be in.  This bounds the work done by any one operation,
+   at the cost of two bucket arrays while a migration is under
+   way. */
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -61,6 +70,9 @@ struct hash
     size_t elem_cnt;            /* Number of elements in table. */
     size_t bucket_cnt;          /* Number of buckets, a power of 2. */
     struct list *buckets;       /* Array of `bucket_cnt' lists. */
+    size_t old_bucket_cnt;      /* Number of buckets being migrated. */
+    struct list *old_buckets;   /* Buckets being migrated, or null. */
+    size_t migrate_idx;         /* Next old bucket to migrate. */
     hash_hash_func *hash;       /* Hash function. */
     hash_less_func *less;       /* Comparison function. */
     void *aux;                  /* Auxiliary data for `hash' and `less'. */
@@ -99,5 +111,6 @@ bool hash_empty (struct hash *);
 unsigned hash_bytes (const void *, size_t);
 unsigned hash_string (const char *);
 unsigned hash_int (int);
+unsigned hash_ptr (const void *);
 
 #endif /* lib/kernel/hash.h */
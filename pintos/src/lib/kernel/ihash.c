@@ -0,0 +1,131 @@
+/* Open-addressing hash table.
+
+   See ihash.h for basic information. */
+
+#include "ihash.h"
+#include "hash.h"
+#include "../debug.h"
+#include "threads/malloc.h"
+
+static size_t find_slot (const struct ihash *, uint32_t key);
+
+/* Initializes hash table H to hold up to MAX_CNT entries.
+   Returns true if successful, false if memory allocation
+   failed. */
+bool
+ihash_init (struct ihash *h, size_t max_cnt) 
+{
+  h->elem_cnt = 0;
+  h->max_cnt = max_cnt;
+  h->slot_cnt = 4;
+  while (h->slot_cnt < max_cnt * 2)
+    h->slot_cnt *= 2;
+  h->slots = malloc (sizeof *h->slots * h->slot_cnt);
+  if (h->slots == NULL)
+    return false;
+
+  ihash_clear (h);
+  return true;
+}
+
+/* Removes all the entries from H. */
+void
+ihash_clear (struct ihash *h) 
+{
+  size_t i;
+
+  for (i = 0; i < h->slot_cnt; i++)
+    h->slots[i].value = NULL;
+  h->elem_cnt = 0;
+}
+
+/* Destroys hash table H. */
+void
+ihash_destroy (struct ihash *h) 
+{
+  free (h->slots);
+  h->slots = NULL;
+}
+
+/* Returns the value associated with KEY in H, or a null pointer
+   if KEY is not in H. */
+void *
+ihash_find (const struct ihash *h, uint32_t key) 
+{
+  return h->slots[find_slot (h, key)].value;
+}
+
+/* Associates VALUE, which must not be null, with KEY in H.
+   Returns the value KEY was associated with before, or a null
+   pointer if KEY was not in H, in which case H must have fewer
+   entries than the maximum it was initialized with. */
+void *
+ihash_insert (struct ihash *h, uint32_t key, void *value) 
+{
+  struct ihash_slot *s = &h->slots[find_slot (h, key)];
+  void *old = s->value;
+
+  ASSERT (value != NULL);
+
+  if (old == NULL) 
+    {
+      ASSERT (h->elem_cnt < h->max_cnt);
+      h->elem_cnt++;
+      s->key = key;
+    }
+  s->value = value;
+  return old;
+}
+
+/* Removes KEY from H and returns the value it was associated
+   with, or a null pointer if KEY was not in H. */
+void *
+ihash_delete (struct ihash *h, uint32_t key) 
+{
+  size_t mask = h->slot_cnt - 1;
+  size_t i = find_slot (h, key);
+  size_t j;
+  void *old = h->slots[i].value;
+
+  if (old == NULL)
+    return NULL;
+  h->elem_cnt--;
+
+  /* Empty slot I, then move back each following entry that
+     would no longer be found with I empty: one whose home slot
+     is no further along its probe sequence than I is. */
+  h->slots[i].value = NULL;
+  for (j = (i + 1) & mask; h->slots[j].value != NULL; j = (j + 1) & mask) 
+    {
+      size_t home = hash_int (h->slots[j].key) & mask;
+      if (((j - home) & mask) >= ((j - i) & mask)) 
+        {
+          h->slots[i] = h->slots[j];
+          h->slots[j].value = NULL;
+          i = j;
+        }
+    }
+  return old;
+}
+
+/* Returns the number of entries in H. */
+size_t
+ihash_size (const struct ihash *h) 
+{
+  return h->elem_cnt;
+}
+
+/* Returns the index of the slot in H that holds KEY, or of the
+   empty slot where KEY would be inserted if KEY is not in H. */
+static size_t
+find_slot (const struct ihash *h, uint32_t key) 
+{
+  size_t mask = h->slot_cnt - 1;
+  size_t i;
+
+  for (i = hash_int (key) & mask; h->slots[i].value != NULL;
+       i = (i + 1) & mask)
+    if (h->slots[i].key == key)
+      break;
+  return i;
+}
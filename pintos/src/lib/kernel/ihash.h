@@ -0,0 +1,54 @@
+#ifndef __LIB_KERNEL_IHASH_H
+#define __LIB_KERNEL_IHASH_H
+
+/* Open-addressing hash table from 32-bit integer keys to
+   pointers.
+
+   For small tables keyed by something like a sector or page
+   number, this is smaller and faster than struct hash: the
+   entries live in a single array, there is no struct hash_elem
+   to embed and no chain to walk, and a lookup probes
+   consecutive slots (linear probing) until it finds the key or
+   an empty slot.  Deletion shifts later entries back instead
+   of leaving tombstones, so lookups never slow down as entries
+   come and go.
+
+   The number of entries the table can hold is fixed when it is
+   initialized, and the table is sized so that it is never more
+   than half full.  Values must be non-null, because a null
+   value marks an empty slot. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* One slot in an ihash. */
+struct ihash_slot 
+  {
+    uint32_t key;               /* Key, if VALUE is non-null. */
+    void *value;                /* Value, or null if the slot is empty. */
+  };
+
+/* Open-addressing hash table. */
+struct ihash 
+  {
+    size_t elem_cnt;            /* Number of entries in table. */
+    size_t max_cnt;             /* Maximum number of entries. */
+    size_t slot_cnt;            /* Number of slots, a power of 2. */
+    struct ihash_slot *slots;   /* Array of `slot_cnt' slots. */
+  };
+
+/* Basic life cycle. */
+bool ihash_init (struct ihash *, size_t max_cnt);
+void ihash_clear (struct ihash *);
+void ihash_destroy (struct ihash *);
+
+/* Search, insertion, deletion. */
+void *ihash_find (const struct ihash *, uint32_t key);
+void *ihash_insert (struct ihash *, uint32_t key, void *value);
+void *ihash_delete (struct ihash *, uint32_t key);
+
+/* Information. */
+size_t ihash_size (const struct ihash *);
+
+#endif /* lib/kernel/ihash.h */
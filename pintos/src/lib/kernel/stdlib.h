@@ -0,0 +1,7 @@
+#ifndef __LIB_KERNEL_STDLIB_H
+#define __LIB_KERNEL_STDLIB_H
+
+/* The kernel's malloc() and free() are declared in
+   threads/malloc.h. */
+
+#endif /* lib/kernel/stdlib.h */
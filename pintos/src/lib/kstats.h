@@ -0,0 +1,58 @@
+#ifndef __LIB_KSTATS_H
+#define __LIB_KSTATS_H
+
+#include <stdint.h>
+
+/* Kinds of page fault counted, one per vm_entry type: VM_BIN,
+   VM_FILE, VM_ANON, VM_STACK. */
+#define KSTATS_FAULT_TYPES 4
+
+/* Block devices reported: one per Pintos role (kernel, filesys,
+   scratch, swap). */
+#define KSTATS_BLOCK_MAX 4
+
+/* Buckets in a block device's latency histogram.  Bucket 0
+   counts requests that took under 1 us, bucket I (for I > 0)
+   those that took at least 2**(I-1) us but under 2**I us, and
+   the last bucket everything slower. */
+#define KSTATS_LATENCY_BUCKETS 16
+
+/* Counters for one block device. */
+struct kstats_block
+  {
+    char name[16];              /* Device name, e.g. "hda2", or "". */
+    uint64_t read_cnt;          /* Sectors read. */
+    uint64_t write_cnt;         /* Sectors written. */
+    uint64_t latency[KSTATS_LATENCY_BUCKETS]; /* Per-sector latency. */
+  };
+
+/* Kernel statistics, as returned by the stats() system call.
+   Every counter runs from boot. */
+struct kstats
+  {
+    /* Time, in timer ticks. */
+    int64_t ticks;              /* Since boot. */
+    int64_t idle_ticks;         /* Spent in the idle thread. */
+    int64_t kernel_ticks;       /* Spent in kernel threads. */
+    int64_t user_ticks;         /* Spent in user processes. */
+    int64_t thread_ticks;       /* Used by the calling thread. */
+
+    /* Buffer cache. */
+    uint64_t bc_hits;           /* Accesses to cached sectors. */
+    uint64_t bc_misses;         /* Accesses that had to load a sector. */
+    uint64_t bc_evictions;      /* Sectors evicted to make room. */
+
+    /* Directory entry cache. */
+    uint64_t dc_hits;           /* Path lookups found in the cache. */
+    uint64_t dc_misses;         /* Path lookups not in the cache. */
+
+    /* Virtual memory. */
+    uint64_t faults[KSTATS_FAULT_TYPES]; /* Page faults, by type. */
+    uint64_t swap_ins;          /* Pages read from swap. */
+    uint64_t swap_outs;         /* Pages written to swap. */
+
+    /* Block devices. */
+    struct kstats_block blocks[KSTATS_BLOCK_MAX];
+  };
+
+#endif /* lib/kstats.h */
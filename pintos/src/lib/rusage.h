@@ -0,0 +1,37 @@
+#ifndef __LIB_RUSAGE_H
+#define __LIB_RUSAGE_H
+
+#include <stdint.h>
+
+/* Whose resource use getrusage() reports. */
+#define RUSAGE_SELF 0           /* The calling process. */
+#define RUSAGE_CHILDREN 1       /* Its exited children, and theirs. */
+
+/* Resource use of a process, as returned by getrusage().  Every
+   counter runs from the start of the process. */
+struct rusage
+  {
+    /* Time, in timer ticks. */
+    int64_t user_ticks;         /* Running user code. */
+    int64_t kernel_ticks;       /* Running in the kernel. */
+
+    /* Virtual memory.  Faults on VM_BIN and VM_FILE pages, and on
+       VM_ANON pages in swap, are major; faults that just zero a
+       fresh VM_ANON or VM_STACK page are minor. */
+    uint64_t minor_faults;      /* Page faults served without I/O. */
+    uint64_t major_faults;      /* Page faults that read a file or swap. */
+    uint64_t swap_ins;          /* Pages read back from swap. */
+
+    /* Block devices.  Sectors moved to or from the file system
+       and scratch disks while the process was running, including
+       buffer cache write-back that it happened to set off.  Swap
+       I/O is not counted; see SWAP_INS. */
+    uint64_t blocks_read;       /* Sectors read. */
+    uint64_t blocks_written;    /* Sectors written. */
+
+    /* Scheduling. */
+    uint64_t voluntary_switches;   /* Gave up the CPU to wait. */
+    uint64_t involuntary_switches; /* Lost the CPU while still runnable. */
+  };
+
+#endif /* lib/rusage.h */
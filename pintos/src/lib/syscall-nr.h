@@ -31,7 +31,49 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Vectored and positional I/O. */
+    SYS_READV,                  /* Read into several buffers. */
+    SYS_WRITEV,                 /* Write from several buffers. */
+    SYS_PREAD,                  /* Read at a given file offset. */
+    SYS_PWRITE,                 /* Write at a given file offset. */
+    SYS_SENDFILE,               /* Copy between fds inside the kernel. */
+
+    /* File descriptor duplication. */
+    SYS_DUP,                    /* Duplicate a fd to the lowest free fd. */
+    SYS_DUP2,                   /* Duplicate a fd to a given fd. */
+
+    /* Kernel statistics. */
+    SYS_STATS,                  /* Read the kernel's counters. */
+
+    /* Memory. */
+    SYS_SBRK,                   /* Grow or shrink the heap. */
+
+    /* Interprocess communication. */
+    SYS_PIPE,                   /* Create a pipe. */
+    SYS_SHM_MAP,                /* Map a shared memory segment. */
+    SYS_SHM_UNMAP,              /* Unmap a shared memory segment. */
+
+    /* Asynchronous I/O. */
+    SYS_AIO_SETUP,              /* Map the request and completion queues. */
+    SYS_AIO_ENTER,              /* Submit requests, wait for completions. */
+
+    /* Durability. */
+    SYS_FSYNC,                  /* Write a file's changes to disk. */
+
+    /* Directory enumeration. */
+    SYS_GETDENTS,               /* Read several directory entries. */
+
+    /* Console input. */
+    SYS_TTYMODE,                /* Choose line or raw input. */
+    SYS_TTYPOLL,                /* Count input ready to read. */
+
+    /* Resource accounting. */
+    SYS_GETRUSAGE,              /* Get a process's resource use. */
+
+    /* Close-on-exec. */
+    SYS_CLOEXEC                 /* Set whether exec passes on a fd. */
   };
 
 #endif /* lib/syscall-nr.h */
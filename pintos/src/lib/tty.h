@@ -0,0 +1,9 @@
+#ifndef __LIB_TTY_H
+#define __LIB_TTY_H
+
+/* Console input modes for ttymode(), which decide what
+   read(STDIN_FILENO, ...) returns. */
+#define TTY_RAW 0               /* Input already typed, at least a byte. */
+#define TTY_LINE 1              /* A whole line, or as much as fits. */
+
+#endif /* lib/tty.h */
@@ -0,0 +1,391 @@
+#include <stdlib.h>
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "threads/vaddr.h"
+
+/* A simple user-space malloc().
+
+   This works like the kernel's allocator in threads/malloc.c.
+   Each request is rounded up to a power of 2 and served by the
+   "descriptor" for blocks of that size.  Blocks live in
+   one-page "arenas" that start with a header naming their
+   descriptor, so free() finds a block's size class by rounding
+   its address down to a page boundary.
+
+   Arenas come from the heap, which sbrk() grows in whole pages.
+   The kernel backs new heap pages with lazily zeroed anonymous
+   memory, so a page costs nothing until it is touched.  For the
+   same reason, a new arena is not threaded onto a free list up
+   front.  Its blocks are handed out in address order from a
+   "bump" pointer, and only freed blocks go on the free list.
+
+   User processes have a single thread, so there are no locks.
+   The common cases of malloc() and free() are a pop from or a
+   push onto a singly linked free list.
+
+   Requests too big for a descriptor get a run of whole pages
+   with the arena header at the start.  Freed runs are kept on a
+   list in address order, merged with free neighbors, and reused
+   first-fit.  A free run at the end of the heap is given back
+   with sbrk().  Small-block arenas are never given back, because
+   the heap can only shrink from its end. */
+
+/* Descriptor. */
+struct desc
+  {
+    size_t block_size;          /* Size of each element in bytes. */
+    struct block *free_list;    /* Freed blocks. */
+    uint8_t *bump;              /* Next never-used block, if any. */
+    uint8_t *bump_end;          /* End of the blocks after BUMP. */
+  };
+
+/* Magic number for detecting arena corruption. */
+#define ARENA_MAGIC 0x9a548eed
+
+/* Arena. */
+struct arena
+  {
+    unsigned magic;             /* Always set to ARENA_MAGIC. */
+    struct desc *desc;          /* Owning descriptor, null for big block. */
+    size_t page_cnt;            /* Pages in big block. */
+    struct arena *next;         /* Next free big block. */
+  };
+
+/* Free block. */
+struct block
+  {
+    struct block *next;         /* Next block in free list. */
+  };
+
+/* Our set of descriptors, for blocks of 16 bytes up to
+   MAX_BLOCK_SIZE. */
+#define MIN_BLOCK_SIZE 16
+#define MAX_BLOCK_SIZE (PGSIZE / 4)
+static struct desc descs[] =
+  {
+    {16, NULL, NULL, NULL}, {32, NULL, NULL, NULL},
+    {64, NULL, NULL, NULL}, {128, NULL, NULL, NULL},
+    {256, NULL, NULL, NULL}, {512, NULL, NULL, NULL},
+    {1024, NULL, NULL, NULL},
+  };
+
+/* Freed big blocks, in address order. */
+static struct arena *free_big;
+
+static struct arena *block_to_arena (void *);
+static void *get_pages (size_t page_cnt);
+static void free_big_block (struct arena *);
+
+/* Returns the descriptor for blocks of SIZE bytes, which must be
+   at most MAX_BLOCK_SIZE. */
+static inline struct desc *
+size_to_desc (size_t size)
+{
+  if (size <= MIN_BLOCK_SIZE)
+    return &descs[0];
+  return &descs[28 - __builtin_clz (size - 1)];
+}
+
+/* Obtains and returns a new block of at least SIZE bytes.
+   Returns a null pointer if memory is not available. */
+void *
+malloc (size_t size)
+{
+  struct desc *d;
+  struct block *b;
+  struct arena *a, **ap;
+  size_t page_cnt;
+
+  /* A null pointer satisfies a request for 0 bytes. */
+  if (size == 0)
+    return NULL;
+
+  if (size <= MAX_BLOCK_SIZE)
+    {
+      d = size_to_desc (size);
+
+      /* Reuse a freed block, if there is one. */
+      b = d->free_list;
+      if (b != NULL)
+        {
+          d->free_list = b->next;
+          return b;
+        }
+
+      /* Otherwise, take the next fresh block, starting a new
+         arena if the current one is used up. */
+      if (d->bump == d->bump_end)
+        {
+          a = get_pages (1);
+          if (a == NULL)
+            return NULL;
+          a->magic = ARENA_MAGIC;
+          a->desc = d;
+          d->bump = (uint8_t *) (a + 1);
+          d->bump_end = d->bump + (PGSIZE - sizeof *a) / d->block_size
+                                  * d->block_size;
+        }
+      b = (struct block *) d->bump;
+      d->bump += d->block_size;
+      return b;
+    }
+
+  /* SIZE is too big for any descriptor.  Find or allocate
+     enough pages to hold SIZE plus an arena. */
+  if (size > SIZE_MAX - sizeof *a - PGSIZE)
+    return NULL;
+  page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
+  for (ap = &free_big; *ap != NULL; ap = &(*ap)->next)
+    if ((*ap)->page_cnt >= page_cnt)
+      {
+        a = *ap;
+        if (a->page_cnt > page_cnt)
+          {
+            /* Keep the rest of the run on the free list. */
+            struct arena *rest = (struct arena *) ((uint8_t *) a
+                                                   + page_cnt * PGSIZE);
+            rest->magic = ARENA_MAGIC;
+            rest->desc = NULL;
+            rest->page_cnt = a->page_cnt - page_cnt;
+            rest->next = a->next;
+            *ap = rest;
+          }
+        else
+          *ap = a->next;
+        a->page_cnt = page_cnt;
+        return a + 1;
+      }
+
+  a = get_pages (page_cnt);
+  if (a == NULL)
+    return NULL;
+  a->magic = ARENA_MAGIC;
+  a->desc = NULL;
+  a->page_cnt = page_cnt;
+  return a + 1;
+}
+
+/* Allocates and return A times B bytes initialized to zeroes.
+   Returns a null pointer if memory is not available. */
+void *
+calloc (size_t a, size_t b)
+{
+  void *p;
+  size_t size;
+
+  /* Calculate block size and make sure it fits in size_t. */
+  size = a * b;
+  if (b != 0 && size / b != a)
+    return NULL;
+
+  /* Allocate and zero memory. */
+  p = malloc (size);
+  if (p != NULL)
+    memset (p, 0, size);
+
+  return p;
+}
+
+/* Returns the number of bytes allocated for BLOCK. */
+static size_t
+block_size (void *block)
+{
+  struct arena *a = block_to_arena (block);
+
+  return (a->desc != NULL
+          ? a->desc->block_size
+          : PGSIZE * a->page_cnt - sizeof *a);
+}
+
+/* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
+   moving it in the process.
+   If successful, returns the new block; on failure, returns a
+   null pointer.
+   A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+void *
+realloc (void *old_block, size_t new_size)
+{
+  if (new_size == 0)
+    {
+      free (old_block);
+      return NULL;
+    }
+  else if (old_block == NULL)
+    return malloc (new_size);
+  else
+    {
+      size_t old_size = block_size (old_block);
+      void *new_block;
+
+      /* Keep the block if it is already big enough. */
+      if (new_size <= old_size)
+        return old_block;
+
+      new_block = malloc (new_size);
+      if (new_block != NULL)
+        {
+          memcpy (new_block, old_block, old_size);
+          free (old_block);
+        }
+      return new_block;
+    }
+}
+
+/* Frees block P, which must have been previously allocated with
+   malloc(), calloc(), or realloc(). */
+void
+free (void *p)
+{
+  if (p != NULL)
+    {
+      struct arena *a = block_to_arena (p);
+      struct desc *d = a->desc;
+
+      if (d != NULL)
+        {
+          struct block *b = p;
+          b->next = d->free_list;
+          d->free_list = b;
+        }
+      else
+        free_big_block (a);
+    }
+}
+
+/* Frees the CNT blocks in BLOCKS, any of which may be null.
+   Equivalent to calling free() on each one, but a run of blocks
+   of the same size goes onto its free list in a single step. */
+void
+free_bulk (void **blocks, size_t cnt)
+{
+  struct desc *d = NULL;
+  struct block *head = NULL, *tail = NULL;
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      struct arena *a;
+
+      if (blocks[i] == NULL)
+        continue;
+      a = block_to_arena (blocks[i]);
+      if (a->desc == NULL)
+        {
+          free_big_block (a);
+          continue;
+        }
+
+      /* Splice the chain built so far if the size changes. */
+      if (a->desc != d)
+        {
+          if (d != NULL)
+            {
+              tail->next = d->free_list;
+              d->free_list = head;
+            }
+          d = a->desc;
+          head = tail = NULL;
+        }
+
+      if (tail == NULL)
+        tail = blocks[i];
+      ((struct block *) blocks[i])->next = head;
+      head = blocks[i];
+    }
+  if (d != NULL)
+    {
+      tail->next = d->free_list;
+      d->free_list = head;
+    }
+}
+
+/* Returns the end of big block A. */
+static inline uint8_t *
+big_block_end (struct arena *a)
+{
+  return (uint8_t *) a + a->page_cnt * PGSIZE;
+}
+
+/* Frees big block A, merging it with any adjacent free big
+   blocks.  If that leaves a free block at the end of the heap,
+   gives its pages back to the kernel. */
+static void
+free_big_block (struct arena *a)
+{
+  struct arena *prev = NULL, *next = free_big, **ap;
+
+  /* Find A's place in the list. */
+  while (next != NULL && next < a)
+    {
+      prev = next;
+      next = next->next;
+    }
+
+  /* Merge with the following and preceding blocks. */
+  if (next != NULL && big_block_end (a) == (uint8_t *) next)
+    {
+      a->page_cnt += next->page_cnt;
+      next = next->next;
+    }
+  if (prev != NULL && big_block_end (prev) == (uint8_t *) a)
+    {
+      prev->page_cnt += a->page_cnt;
+      a = prev;
+    }
+  else if (prev != NULL)
+    prev->next = a;
+  else
+    free_big = a;
+  a->next = next;
+
+  /* Give back the last block if it ends the heap. */
+  if (next == NULL && big_block_end (a) == sbrk (0))
+    {
+      for (ap = &free_big; *ap != a; ap = &(*ap)->next)
+        continue;
+      *ap = NULL;
+      sbrk (-(intptr_t) (a->page_cnt * PGSIZE));
+    }
+}
+
+/* Returns the arena that block B is inside. */
+static struct arena *
+block_to_arena (void *b)
+{
+  struct arena *a = pg_round_down (b);
+
+  /* Check that the arena is valid. */
+  ASSERT (a != NULL);
+  ASSERT (a->magic == ARENA_MAGIC);
+
+  /* Check that the block is properly aligned for the arena. */
+  ASSERT (a->desc == NULL
+          || (pg_ofs (b) - sizeof *a) % a->desc->block_size == 0);
+  ASSERT (a->desc != NULL || pg_ofs (b) == sizeof *a);
+
+  return a;
+}
+
+/* Extends the heap by PAGE_CNT pages and returns the first one,
+   or a null pointer if the kernel refuses.  Also aligns the end
+   of the heap to a page boundary first, in case the program
+   called sbrk() itself. */
+static void *
+get_pages (size_t page_cnt)
+{
+  uint8_t *brk = sbrk (0);
+  void *pages;
+
+  if (brk == (void *) -1)
+    return NULL;
+  if (pg_ofs (brk) != 0 && sbrk (PGSIZE - pg_ofs (brk)) == (void *) -1)
+    return NULL;
+  if (page_cnt > (size_t) INTPTR_MAX / PGSIZE)
+    return NULL;
+  pages = sbrk (page_cnt * PGSIZE);
+  return pages != (void *) -1 ? pages : NULL;
+}
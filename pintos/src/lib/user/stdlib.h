@@ -0,0 +1,13 @@
+#ifndef __LIB_USER_STDLIB_H
+#define __LIB_USER_STDLIB_H
+
+#include <stddef.h>
+
+/* Heap allocation, in lib/user/malloc.c. */
+void *malloc (size_t) __attribute__ ((malloc));
+void *calloc (size_t, size_t) __attribute__ ((malloc));
+void *realloc (void *, size_t);
+void free (void *);
+void free_bulk (void **, size_t cnt);
+
+#endif /* lib/user/stdlib.h */
@@ -61,6 +61,25 @@
           retval;                                               \
         })
 
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   and ARG3, and returns the return value as an `int'. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg3]; pushl %[arg2]; "                   \
+             "pushl %[arg1]; pushl %[arg0]; "                   \
+             "pushl %[number]; int $0x30; addl $20, %%esp"      \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "r" (ARG0),                             \
+                 [arg1] "r" (ARG1),                             \
+                 [arg2] "r" (ARG2),                             \
+                 [arg3] "r" (ARG3)                              \
+               : "memory");                                     \
+          retval;                                               \
+        })
+
 void
 halt (void) 
 {
@@ -197,3 +216,129 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+int
+getdents (int fd, struct dirent *ents, int cnt)
+{
+  return syscall3 (SYS_GETDENTS, fd, ents, cnt);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+sendfile (int out_fd, int in_fd, unsigned size)
+{
+  return syscall3 (SYS_SENDFILE, out_fd, in_fd, size);
+}
+
+int
+dup (int fd)
+{
+  return syscall1 (SYS_DUP, fd);
+}
+
+int
+dup2 (int old_fd, int new_fd)
+{
+  return syscall2 (SYS_DUP2, old_fd, new_fd);
+}
+
+bool
+stats (struct kstats *st)
+{
+  return syscall1 (SYS_STATS, st);
+}
+
+void *
+sbrk (intptr_t increment)
+{
+  return (void *) syscall1 (SYS_SBRK, increment);
+}
+
+bool
+pipe (int fds[2])
+{
+  return syscall2 (SYS_PIPE, fds, 0);
+}
+
+bool
+pipe2 (int fds[2], int flags)
+{
+  return syscall2 (SYS_PIPE, fds, flags);
+}
+
+void *
+shm_map (int key, void *addr, size_t size)
+{
+  return (void *) syscall3 (SYS_SHM_MAP, key, addr, size);
+}
+
+bool
+shm_unmap (void *addr)
+{
+  return syscall1 (SYS_SHM_UNMAP, addr);
+}
+
+struct aio_ring *
+aio_setup (void *addr)
+{
+  return (struct aio_ring *) syscall1 (SYS_AIO_SETUP, addr);
+}
+
+int
+aio_enter (unsigned to_submit, unsigned min_complete)
+{
+  return syscall2 (SYS_AIO_ENTER, to_submit, min_complete);
+}
+
+int
+fsync (int fd)
+{
+  return syscall1 (SYS_FSYNC, fd);
+}
+
+int
+ttymode (int mode)
+{
+  return syscall1 (SYS_TTYMODE, mode);
+}
+
+int
+ttypoll (void)
+{
+  return syscall0 (SYS_TTYPOLL);
+}
+
+bool
+getrusage (int who, struct rusage *ru)
+{
+  return syscall2 (SYS_GETRUSAGE, who, ru);
+}
+
+int
+cloexec (int fd, int flag)
+{
+  return syscall2 (SYS_CLOEXEC, fd, flag);
+}
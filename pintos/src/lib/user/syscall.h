@@ -2,7 +2,14 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <aio.h>
 #include <debug.h>
+#include <dirent.h>
+#include <iovec.h>
+#include <ipc.h>
+#include <kstats.h>
+#include <rusage.h>
+#include <tty.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -35,6 +42,7 @@ unsigned tell (int fd);
 void close (int fd);
 void sigaction (int signum, void (*handler) (void));
 void sendsig (pid_t, int signum);
+void sched_yield (void);
 #define SIGONE 1
 #define SIGTWO 2
 #define SIGTHREE 3
@@ -50,5 +58,46 @@ bool mkdir (const char *dir);
 bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
+int getdents (int fd, struct dirent *, int cnt);
+
+/* Vectored and positional I/O. */
+int readv (int fd, const struct iovec *, int iovcnt);
+int writev (int fd, const struct iovec *, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int sendfile (int out_fd, int in_fd, unsigned length);
+
+/* File descriptor duplication. */
+int dup (int fd);
+int dup2 (int old_fd, int new_fd);
+
+/* Kernel statistics. */
+bool stats (struct kstats *);
+
+/* Memory. */
+void *sbrk (intptr_t increment);
+
+/* Interprocess communication. */
+bool pipe (int fds[2]);
+bool pipe2 (int fds[2], int flags);
+void *shm_map (int key, void *addr, size_t size);
+bool shm_unmap (void *addr);
+
+/* Asynchronous I/O. */
+struct aio_ring *aio_setup (void *addr);
+int aio_enter (unsigned to_submit, unsigned min_complete);
+
+/* Durability. */
+int fsync (int fd);
+
+/* Console input. */
+int ttymode (int mode);
+int ttypoll (void);
+
+/* Resource accounting. */
+bool getrusage (int who, struct rusage *);
+
+/* Close-on-exec. */
+int cloexec (int fd, int flag);
 
 #endif /* lib/user/syscall.h */
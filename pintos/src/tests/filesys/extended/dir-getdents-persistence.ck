@@ -0,0 +1,8 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+my ($dir) = {'sub' => {}};
+$dir->{"f$_"} = [''] foreach 0...8;
+check_archive ({'a' => $dir});
+pass;
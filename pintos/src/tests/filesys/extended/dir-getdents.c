@@ -0,0 +1,82 @@
+/* Fills a directory with files and a subdirectory and reads it
+   back with getdents(), a few entries at a time, checking each
+   entry's name, type, and inumber. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Entries in "a": FILE_CNT - 1 files and "sub". */
+#define FILE_CNT 10
+
+/* Returns the index of NAME among the entries of "a", with "sub"
+   last, or -1 if NAME is not one of them. */
+static int
+find_entry (const char *name)
+{
+  char expected[16];
+  int i;
+
+  for (i = 0; i < FILE_CNT - 1; i++)
+    {
+      snprintf (expected, sizeof expected, "f%d", i);
+      if (!strcmp (name, expected))
+        return i;
+    }
+  return !strcmp (name, "sub") ? FILE_CNT - 1 : -1;
+}
+
+void
+test_main (void) 
+{
+  struct dirent ents[4];
+  bool seen[FILE_CNT + 1];
+  char name[32];
+  int dir_fd, fd, cnt, n, i;
+
+  CHECK (mkdir ("a"), "mkdir \"a\"");
+  CHECK (mkdir ("a/sub"), "mkdir \"a/sub\"");
+  msg ("create \"a/f0\" through \"a/f%d\"", FILE_CNT - 2);
+  for (i = 0; i < FILE_CNT - 1; i++)
+    {
+      snprintf (name, sizeof name, "a/f%d", i);
+      if (!create (name, 0))
+        fail ("create \"%s\" failed", name);
+    }
+  CHECK ((dir_fd = open ("a")) > 1, "open \"a\"");
+
+  memset (seen, 0, sizeof seen);
+  msg ("getdents \"a\"");
+  for (cnt = 0; (n = getdents (dir_fd, ents, 4)) > 0; cnt += n)
+    for (i = 0; i < n; i++)
+      {
+        struct dirent *e = &ents[i];
+        int idx;
+
+        idx = find_entry (e->name);
+        if (idx < 0)
+          fail ("unexpected entry \"%s\"", e->name);
+        if (e->is_dir != (idx == FILE_CNT - 1))
+          fail ("\"%s\" has the wrong type", e->name);
+        if (seen[idx])
+          fail ("\"%s\" returned twice", e->name);
+        seen[idx] = true;
+
+        snprintf (name, sizeof name, "a/%s", e->name);
+        fd = open (name);
+        if (fd < 0 || inumber (fd) != e->inumber)
+          fail ("inumber of \"%s\" does not match", e->name);
+        close (fd);
+      }
+  if (n < 0)
+    fail ("getdents failed");
+  if (cnt != FILE_CNT)
+    fail ("getdents returned %d entries, expected %d", cnt, FILE_CNT);
+  CHECK (getdents (dir_fd, ents, 4) == 0, "getdents at end");
+  close (dir_fd);
+
+  CHECK ((fd = open ("a/f0")) > 1, "open \"a/f0\"");
+  CHECK (getdents (fd, ents, 4) == -1, "getdents on a file (must fail)");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(dir-getdents) begin
+(dir-getdents) mkdir "a"
+(dir-getdents) mkdir "a/sub"
+(dir-getdents) create "a/f0" through "a/f8"
+(dir-getdents) open "a"
+(dir-getdents) getdents "a"
+(dir-getdents) getdents at end
+(dir-getdents) open "a/f0"
+(dir-getdents) getdents on a file (must fail)
+(dir-getdents) end
+EOF
+pass;
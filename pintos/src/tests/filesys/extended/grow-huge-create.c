@@ -0,0 +1,57 @@
+/* Creates a file with an initial size of 16 MB, much more than
+   the file system holds, then checks that it reads as zeroes,
+   that a few bytes can still be written in the middle of it,
+   and that it can be removed.  This only works if create()
+   leaves the new file's data as holes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define HUGE_SIZE (16 * 1024 * 1024)
+#define MIDDLE (9 * 1024 * 1024)
+
+static const char data[] = "Hello, huge file.";
+static char zeroes[sizeof data];
+static char buf[sizeof data];
+
+/* Reads sizeof buf bytes at OFS in FD and compares them against
+   EXPECTED. */
+static void
+check_at (int fd, int ofs, const char *expected)
+{
+  seek (fd, ofs);
+  if (read (fd, buf, sizeof buf) != (int) sizeof buf)
+    fail ("read at %d failed", ofs);
+  if (memcmp (buf, expected, sizeof buf))
+    fail ("wrong data at %d", ofs);
+}
+
+void
+test_main (void) 
+{
+  static const int holes[] = {0, 1024 * 1024, MIDDLE + 4096,
+                              HUGE_SIZE - sizeof data};
+  const char *file_name = "huge";
+  size_t i;
+  int fd;
+
+  CHECK (create (file_name, HUGE_SIZE), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  CHECK (filesize (fd) == HUGE_SIZE, "filesize \"%s\"", file_name);
+
+  msg ("verify holes");
+  for (i = 0; i < sizeof holes / sizeof *holes; i++)
+    check_at (fd, holes[i], zeroes);
+
+  seek (fd, MIDDLE);
+  CHECK (write (fd, data, sizeof data) == sizeof data,
+         "write in the middle of \"%s\"", file_name);
+  check_at (fd, MIDDLE, data);
+  CHECK (filesize (fd) == HUGE_SIZE, "filesize \"%s\" unchanged", file_name);
+
+  msg ("close \"%s\"", file_name);
+  close (fd);
+  CHECK (remove (file_name), "remove \"%s\"", file_name);
+}
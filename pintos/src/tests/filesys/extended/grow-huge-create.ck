@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(grow-huge-create) begin
+(grow-huge-create) create "huge"
+(grow-huge-create) open "huge"
+(grow-huge-create) filesize "huge"
+(grow-huge-create) verify holes
+(grow-huge-create) write in the middle of "huge"
+(grow-huge-create) filesize "huge" unchanged
+(grow-huge-create) close "huge"
+(grow-huge-create) remove "huge"
+(grow-huge-create) end
+EOF
+pass;
@@ -0,0 +1,61 @@
+/* Writes a few bytes 9 MB and 16 MB into an empty file, beyond
+   what a doubly indirect block can map, then checks that they
+   read back, that the holes around them read as zeroes, and
+   that the file can be removed.  The file system is much
+   smaller than the file, so this only works if holes take up no
+   sectors. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define HUGE_SIZE (16 * 1024 * 1024)
+#define MIDDLE (9 * 1024 * 1024)
+
+static const char data[] = "Hello, huge file.";
+static char zeroes[sizeof data];
+static char buf[sizeof data];
+
+/* Reads sizeof buf bytes at OFS in FD and compares them against
+   EXPECTED. */
+static void
+check_at (int fd, int ofs, const char *expected)
+{
+  seek (fd, ofs);
+  if (read (fd, buf, sizeof buf) != (int) sizeof buf)
+    fail ("read at %d failed", ofs);
+  if (memcmp (buf, expected, sizeof buf))
+    fail ("wrong data at %d", ofs);
+}
+
+void
+test_main (void) 
+{
+  static const int holes[] = {0, 511, 1024 * 1024, 4 * 1024 * 1024,
+                              MIDDLE + 4096, HUGE_SIZE - 4096};
+  const char *file_name = "huge";
+  size_t i;
+  int fd;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  seek (fd, MIDDLE);
+  CHECK (write (fd, data, sizeof data) == sizeof data,
+         "write in the middle of \"%s\"", file_name);
+  seek (fd, HUGE_SIZE - sizeof data);
+  CHECK (write (fd, data, sizeof data) == sizeof data,
+         "write at the end of \"%s\"", file_name);
+  CHECK (filesize (fd) == HUGE_SIZE, "filesize \"%s\"", file_name);
+
+  msg ("verify data");
+  check_at (fd, MIDDLE, data);
+  check_at (fd, HUGE_SIZE - sizeof data, data);
+  msg ("verify holes");
+  for (i = 0; i < sizeof holes / sizeof *holes; i++)
+    check_at (fd, holes[i], zeroes);
+
+  msg ("close \"%s\"", file_name);
+  close (fd);
+  CHECK (remove (file_name), "remove \"%s\"", file_name);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(grow-huge) begin
+(grow-huge) create "huge"
+(grow-huge) open "huge"
+(grow-huge) write in the middle of "huge"
+(grow-huge) write at the end of "huge"
+(grow-huge) filesize "huge"
+(grow-huge) verify data
+(grow-huge) verify holes
+(grow-huge) close "huge"
+(grow-huge) remove "huge"
+(grow-huge) end
+EOF
+pass;
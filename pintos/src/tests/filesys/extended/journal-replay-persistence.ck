@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+fail "The journal was not replayed at boot.\n"
+  if !grep (/^journal: replayed \d+ sectors from commit \d+\./, @output);
+check_archive ({'a' => {'b' => ["Written before the crash.\n"],
+                        'c' => ["\0" x 512]},
+                'd' => {}});
+pass;
@@ -0,0 +1,31 @@
+/* Makes file system changes that only the journal holds at
+   shutdown.  This test runs with -jcrash, so the kernel commits
+   the last transaction to the journal but never writes its
+   sectors in place.  The persistence check then passes only if
+   the next boot replays the journal.
+
+   The fsync() at the start commits everything made so far, so
+   that the changes after it all wait for the shutdown commit. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static const char text[] = "Written before the crash.\n";
+
+void
+test_main (void) 
+{
+  int fd;
+
+  CHECK (mkdir ("a"), "mkdir \"a\"");
+  CHECK (create ("a/b", 0), "create \"a/b\"");
+  CHECK ((fd = open ("a/b")) > 1, "open \"a/b\"");
+  CHECK (fsync (fd) == 0, "fsync \"a/b\"");
+  CHECK (write (fd, text, sizeof text - 1) == sizeof text - 1,
+         "write \"a/b\"");
+  CHECK (create ("a/c", 512), "create \"a/c\"");
+  CHECK (mkdir ("d"), "mkdir \"d\"");
+  msg ("close \"a/b\"");
+  close (fd);
+}
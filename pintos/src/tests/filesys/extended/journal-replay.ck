@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(journal-replay) begin
+(journal-replay) mkdir "a"
+(journal-replay) create "a/b"
+(journal-replay) open "a/b"
+(journal-replay) fsync "a/b"
+(journal-replay) write "a/b"
+(journal-replay) create "a/c"
+(journal-replay) mkdir "d"
+(journal-replay) close "a/b"
+(journal-replay) end
+EOF
+our ($test);
+my (@output) = read_text_file ("$test.output");
+fail "Shutdown did not leave a commit in the journal.\n"
+  if !grep (/^journal: leaving commit \d+ unapplied/, @output);
+pass;
@@ -0,0 +1,145 @@
+/* Test program and benchmark for bitmap_scan() in
+   lib/kernel/bitmap.c.
+
+   Checks bitmap_scan() and bitmap_scan_next_fit() against a
+   bit-at-a-time search on random bitmaps, then times
+   allocation-sized scans of a 1M-bit bitmap that is 99% full,
+   first-fit from the start and next-fit from a moving hint, and
+   prints scans per timer tick next to the old bit-at-a-time
+   search.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/test.h"
+
+/* Size of the bitmaps checked against the reference search. */
+#define CHECK_BITS 1000
+
+/* Size of the benchmark bitmap. */
+#define BENCH_BITS (1024 * 1024)
+
+/* Timer ticks each benchmark runs for. */
+#define BENCH_TICKS 50
+
+/* The search bitmap_scan() used to do: try every start index. */
+static size_t
+slow_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) 
+{
+  size_t i, j;
+
+  for (i = start; i + cnt <= bitmap_size (b); i++) 
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j) != value)
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Sets each bit in B to true with probability PERCENT / 100. */
+static void
+fill_random (struct bitmap *b, unsigned percent) 
+{
+  size_t i;
+
+  for (i = 0; i < bitmap_size (b); i++)
+    bitmap_set (b, i, random_ulong () % 100 < percent);
+}
+
+static void
+check_scan (void) 
+{
+  struct bitmap *b = bitmap_create (CHECK_BITS);
+  int i;
+
+  ASSERT (b != NULL);
+  printf ("checking bitmap_scan()...");
+  for (i = 0; i < 2000; i++) 
+    {
+      size_t start = random_ulong () % (CHECK_BITS + 1);
+      size_t cnt = random_ulong () % 8;
+      bool value = random_ulong () % 2;
+      size_t expect;
+
+      fill_random (b, random_ulong () % 101);
+      ASSERT (bitmap_scan (b, start, cnt, value)
+              == slow_scan (b, start, cnt, value));
+
+      expect = slow_scan (b, start, cnt, value);
+      if (expect == BITMAP_ERROR)
+        expect = slow_scan (b, 0, cnt, value);
+      ASSERT (bitmap_scan_next_fit (b, start, cnt, value) == expect);
+    }
+  bitmap_destroy (b);
+  printf (" okay\n");
+}
+
+/* Runs scans for groups of CNT free bits in B for BENCH_TICKS
+   ticks and prints the rate.  If NEXT_FIT, each scan starts
+   where the previous one left off; otherwise every scan starts
+   at bit 0, as palloc and the free map do.  SLOW selects the
+   old search. */
+static void
+bench (const char *name, struct bitmap *b, size_t cnt, bool next_fit,
+       bool slow) 
+{
+  size_t hint = 0;
+  long long scans = 0;
+  int64_t start;
+
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    continue;
+  start = timer_ticks ();
+  while (timer_elapsed (start) < BENCH_TICKS) 
+    {
+      size_t idx;
+
+      if (slow)
+        idx = slow_scan (b, hint, cnt, false);
+      else if (next_fit)
+        idx = bitmap_scan_next_fit (b, hint, cnt, false);
+      else
+        idx = bitmap_scan (b, 0, cnt, false);
+      if (next_fit)
+        hint = idx != BITMAP_ERROR ? (idx + cnt) % bitmap_size (b) : 0;
+      scans++;
+    }
+  printf ("%-10s cnt=%zu: %lld scans/tick\n",
+          name, cnt, scans / BENCH_TICKS);
+}
+
+/* Tests and times bitmap_scan(). */
+void
+test (void) 
+{
+  static const size_t cnts[] = {1, 8};
+  struct bitmap *b;
+  size_t i;
+
+  check_scan ();
+
+  b = bitmap_create (BENCH_BITS);
+  ASSERT (b != NULL);
+  fill_random (b, 99);
+  printf ("%d-bit bitmap, %zu bits free\n",
+          BENCH_BITS, bitmap_count (b, 0, BENCH_BITS, false));
+  for (i = 0; i < sizeof cnts / sizeof *cnts; i++) 
+    {
+      bench ("bit scan", b, cnts[i], false, true);
+      bench ("first-fit", b, cnts[i], false, false);
+      bench ("next-fit", b, cnts[i], true, false);
+    }
+  bitmap_destroy (b);
+  printf ("done\n");
+}
@@ -0,0 +1,240 @@
+/* Test program and benchmark for lib/kernel/hash.c and
+   lib/kernel/ihash.c.
+
+   Checks both tables against a plain array through random
+   insertions and deletions, including across resizes.  Then
+   inserts many elements into a struct hash one at a time,
+   timing each insertion, and prints the slowest one next to
+   the time it takes to move a whole table to new buckets at
+   once, which is what a single insertion used to cost when it
+   triggered a resize.  Finally, prints lookups per timer tick
+   for a buffer cache sized table in a struct hash and in an
+   ihash.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <hash.h>
+#include <ihash.h>
+#include <random.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/malloc.h"
+#include "threads/test.h"
+
+/* Keys used by the correctness checks are below this. */
+#define CHECK_KEYS 512
+
+/* Elements inserted by the insertion benchmark. */
+#define BENCH_ELEMS (32 * 1024)
+
+/* Entries in the lookup benchmark tables. */
+#define LOOKUP_ELEMS 64
+
+/* Timer ticks each lookup benchmark runs for. */
+#define BENCH_TICKS 50
+
+/* An element of a struct hash. */
+struct item 
+  {
+    struct hash_elem elem;
+    int key;
+  };
+
+static unsigned
+item_hash (const struct hash_elem *e, void *aux UNUSED) 
+{
+  return hash_int (hash_entry (e, struct item, elem)->key);
+}
+
+static bool
+item_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED) 
+{
+  return (hash_entry (a, struct item, elem)->key
+          < hash_entry (b, struct item, elem)->key);
+}
+
+/* Returns the element with KEY in H, or a null pointer. */
+static struct item *
+find_item (struct hash *h, int key) 
+{
+  struct item probe;
+  struct hash_elem *e;
+
+  probe.key = key;
+  e = hash_find (h, &probe.elem);
+  return e != NULL ? hash_entry (e, struct item, elem) : NULL;
+}
+
+/* Inserts and deletes random keys in a struct hash and an
+   ihash, checking both against IN[], which records which keys
+   should be present. */
+static void
+check_tables (void) 
+{
+  static struct item items[CHECK_KEYS];
+  static bool in[CHECK_KEYS];
+  struct hash h;
+  struct ihash ih;
+  struct hash_iterator it;
+  size_t cnt = 0;
+  int i, key;
+
+  printf ("checking hash and ihash...");
+  ASSERT (hash_init (&h, item_hash, item_less, NULL));
+  ASSERT (ihash_init (&ih, CHECK_KEYS));
+  for (key = 0; key < CHECK_KEYS; key++) 
+    {
+      items[key].key = key;
+      in[key] = false;
+    }
+
+  for (i = 0; i < 50000; i++) 
+    {
+      /* Bias toward insertion for the first half and deletion
+         for the second, so the tables grow and then shrink. */
+      bool insert = random_ulong () % 100 < (i < 25000 ? 70 : 30);
+
+      key = random_ulong () % CHECK_KEYS;
+      if (insert) 
+        {
+          ASSERT ((hash_insert (&h, &items[key].elem) == NULL) == !in[key]);
+          ASSERT ((ihash_insert (&ih, key, &items[key]) == NULL) == !in[key]);
+          cnt += !in[key];
+          in[key] = true;
+        }
+      else 
+        {
+          ASSERT ((hash_delete (&h, &items[key].elem) != NULL) == in[key]);
+          ASSERT ((ihash_delete (&ih, key) != NULL) == in[key]);
+          cnt -= in[key];
+          in[key] = false;
+        }
+      ASSERT (hash_size (&h) == cnt);
+      ASSERT (ihash_size (&ih) == cnt);
+
+      key = random_ulong () % CHECK_KEYS;
+      ASSERT ((find_item (&h, key) != NULL) == in[key]);
+      ASSERT ((ihash_find (&ih, key) != NULL) == in[key]);
+    }
+
+  /* Iteration must see each element exactly once. */
+  hash_first (&it, &h);
+  while (hash_next (&it)) 
+    {
+      key = hash_entry (hash_cur (&it), struct item, elem)->key;
+      ASSERT (in[key]);
+      in[key] = false;
+      cnt--;
+    }
+  ASSERT (cnt == 0);
+
+  hash_destroy (&h, NULL);
+  ihash_destroy (&ih);
+  printf (" okay\n");
+}
+
+/* Inserts BENCH_ELEMS elements into a struct hash, timing each
+   insertion, and prints the slowest.  Then keeps inserting until
+   the table starts another resize and times moving all of its
+   elements to the new buckets at once, as hash_first() does. */
+static void
+bench_insert (void) 
+{
+  struct item *items = malloc (sizeof *items * BENCH_ELEMS * 2);
+  struct hash h;
+  struct hash_iterator it;
+  int64_t start, elapsed, total = 0, worst = 0;
+  int i;
+
+  ASSERT (items != NULL);
+  ASSERT (hash_init (&h, item_hash, item_less, NULL));
+  for (i = 0; i < BENCH_ELEMS * 2; i++)
+    items[i].key = i;
+
+  for (i = 0; i < BENCH_ELEMS; i++) 
+    {
+      start = timer_usecs ();
+      hash_insert (&h, &items[i].elem);
+      elapsed = timer_usecs () - start;
+      total += elapsed;
+      if (elapsed > worst)
+        worst = elapsed;
+    }
+  printf ("%d inserts: %lld us average, %lld us worst\n",
+          BENCH_ELEMS, total / BENCH_ELEMS, worst);
+
+  while (h.old_buckets != NULL)
+    hash_insert (&h, &items[i++].elem);
+  while (h.old_buckets == NULL) 
+    {
+      ASSERT (i < BENCH_ELEMS * 2);
+      hash_insert (&h, &items[i++].elem);
+    }
+  start = timer_usecs ();
+  hash_first (&it, &h);
+  elapsed = timer_usecs () - start;
+  printf ("moving %zu elements at once: %lld us\n", hash_size (&h), elapsed);
+
+  hash_destroy (&h, NULL);
+  free (items);
+}
+
+/* Looks up random keys among LOOKUP_ELEMS, in a struct hash if
+   USE_IHASH is false or an ihash otherwise, for BENCH_TICKS
+   ticks, and prints the rate. */
+static void
+bench_lookup (bool use_ihash) 
+{
+  static struct item items[LOOKUP_ELEMS];
+  struct hash h;
+  struct ihash ih;
+  long long lookups = 0;
+  unsigned key = 0;
+  int64_t start;
+  int i;
+
+  ASSERT (hash_init (&h, item_hash, item_less, NULL));
+  ASSERT (ihash_init (&ih, LOOKUP_ELEMS));
+  for (i = 0; i < LOOKUP_ELEMS; i++) 
+    {
+      items[i].key = random_ulong ();
+      hash_insert (&h, &items[i].elem);
+      ihash_insert (&ih, items[i].key, &items[i]);
+    }
+
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    continue;
+  start = timer_ticks ();
+  while (timer_elapsed (start) < BENCH_TICKS) 
+    {
+      int k = items[key++ % LOOKUP_ELEMS].key;
+      bool found = (use_ihash
+                    ? ihash_find (&ih, k) != NULL
+                    : find_item (&h, k) != NULL);
+      ASSERT (found);
+      lookups++;
+    }
+  printf ("%-6s %d entries: %lld lookups/tick\n",
+          use_ihash ? "ihash" : "hash", LOOKUP_ELEMS,
+          lookups / BENCH_TICKS);
+
+  hash_destroy (&h, NULL);
+  ihash_destroy (&ih);
+}
+
+/* Tests and times hash tables. */
+void
+test (void) 
+{
+  check_tables ();
+  bench_insert ();
+  bench_lookup (false);
+  bench_lookup (true);
+  printf ("done\n");
+}
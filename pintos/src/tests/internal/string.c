@@ -0,0 +1,157 @@
+/* Test program and microbenchmark for memcpy(), memset(),
+   memmove(), memcmp() and strlen() in lib/string.c.
+
+   Checks each function against a byte-at-a-time reference at
+   every combination of source and destination alignment for a
+   range of sizes, then reports bytes per timer tick for 512-byte
+   (one sector) and 4 kB (one page) copies and fills, next to the
+   same byte loop the old implementations used.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/test.h"
+
+/* Largest block checked for correctness. */
+#define MAX_SIZE 80
+
+/* Timer ticks each benchmark runs for. */
+#define BENCH_TICKS 50
+
+static uint8_t src_buf[4096 + 8], dst_buf[4096 + 8], ref_buf[4096 + 8];
+
+static void
+byte_copy (void *dst_, const void *src_, size_t size) 
+{
+  volatile uint8_t *dst = dst_;
+  const uint8_t *src = src_;
+
+  while (size-- > 0)
+    *dst++ = *src++;
+}
+
+static void
+byte_fill (void *dst_, int value, size_t size) 
+{
+  volatile uint8_t *dst = dst_;
+
+  while (size-- > 0)
+    *dst++ = value;
+}
+
+static void
+fill_random (void) 
+{
+  random_bytes (src_buf, sizeof src_buf);
+  random_bytes (dst_buf, sizeof dst_buf);
+  memcpy (ref_buf, dst_buf, sizeof ref_buf);
+}
+
+static void
+check_functions (void) 
+{
+  size_t size, s_ofs, d_ofs;
+
+  printf ("checking alignments and sizes up to %d...", MAX_SIZE);
+  for (size = 0; size <= MAX_SIZE; size++)
+    for (s_ofs = 0; s_ofs < 4; s_ofs++)
+      for (d_ofs = 0; d_ofs < 4; d_ofs++) 
+        {
+          fill_random ();
+          ASSERT (memcpy (dst_buf + d_ofs, src_buf + s_ofs, size)
+                  == dst_buf + d_ofs);
+          byte_copy (ref_buf + d_ofs, src_buf + s_ofs, size);
+          ASSERT (!memcmp (dst_buf, ref_buf, MAX_SIZE + 8));
+          if (size > 0)
+            {
+              uint8_t *last = &ref_buf[d_ofs + size - 1];
+              *last ^= 1;
+              ASSERT ((memcmp (dst_buf, ref_buf, MAX_SIZE + 8) < 0)
+                      == (dst_buf[d_ofs + size - 1] < *last));
+            }
+
+          fill_random ();
+          ASSERT (memset (dst_buf + d_ofs, s_ofs * 85, size)
+                  == dst_buf + d_ofs);
+          byte_fill (ref_buf + d_ofs, s_ofs * 85, size);
+          ASSERT (!memcmp (dst_buf, ref_buf, MAX_SIZE + 8));
+
+          /* Overlapping moves, backward or forward depending on
+             which offset is larger. */
+          memcpy (dst_buf, src_buf, MAX_SIZE + 8);
+          memcpy (ref_buf, src_buf, MAX_SIZE + 8);
+          byte_copy (ref_buf + d_ofs, src_buf + s_ofs, size);
+          ASSERT (memmove (dst_buf + d_ofs, dst_buf + s_ofs, size)
+                  == dst_buf + d_ofs);
+          ASSERT (!memcmp (dst_buf, ref_buf, MAX_SIZE + 8));
+
+          /* A string of SIZE characters starting at S_OFS. */
+          memset (dst_buf, 'x', MAX_SIZE + 8);
+          dst_buf[s_ofs + size] = '\0';
+          ASSERT (strlen ((char *) dst_buf + s_ofs) == size);
+        }
+  printf (" okay\n");
+}
+
+/* Runs COPY or, if it is null, FILL over SIZE-byte blocks for
+   BENCH_TICKS ticks and prints the rate. */
+static void
+bench (const char *name, size_t size,
+       void (*copy) (void *, const void *, size_t),
+       void (*fill) (void *, int, size_t)) 
+{
+  int64_t start;
+  long long bytes = 0;
+
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    continue;
+  start = timer_ticks ();
+  while (timer_elapsed (start) < BENCH_TICKS) 
+    {
+      if (copy != NULL)
+        copy (dst_buf, src_buf, size);
+      else
+        fill (dst_buf, 0, size);
+      bytes += size;
+    }
+  printf ("%-12s %4zu bytes: %lld bytes/tick\n",
+          name, size, bytes / BENCH_TICKS);
+}
+
+static void
+string_memcpy (void *dst, const void *src, size_t size) 
+{
+  memcpy (dst, src, size);
+}
+
+static void
+string_memset (void *dst, int value, size_t size) 
+{
+  memset (dst, value, size);
+}
+
+/* Tests and times lib/string.c. */
+void
+test (void) 
+{
+  static const size_t sizes[] = {512, 4096};
+  size_t i;
+
+  check_functions ();
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++) 
+    {
+      bench ("byte copy", sizes[i], byte_copy, NULL);
+      bench ("memcpy", sizes[i], string_memcpy, NULL);
+      bench ("byte fill", sizes[i], NULL, byte_fill);
+      bench ("memset", sizes[i], NULL, string_memset);
+    }
+  printf ("done\n");
+}
@@ -0,0 +1,110 @@
+/* Writes "sample.txt" into a new file with several asynchronous
+   writes in flight at once, flushes it, reads it back the same
+   way, and checks the completions, including one for a request
+   with a bad fd and one for a read past AIO_MAX_BUFFERED. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHUNK 64
+#define RING_ADDR ((void *) 0x10000000)
+
+/* Reads of AIO_MAX_LEN bytes that fit in AIO_MAX_BUFFERED. */
+#define BIG_CNT (AIO_MAX_BUFFERED / AIO_MAX_LEN)
+
+static struct aio_ring *ring;
+static char big[AIO_MAX_LEN];
+
+/* Queues a request for LEN bytes at OFS, tagged with OFS. */
+static void
+submit (int opcode, int fd, void *buf, size_t len, size_t ofs)
+{
+  struct aio_sqe *sqe = &ring->sq[ring->sq_tail % AIO_ENTRIES];
+
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->len = len;
+  sqe->offset = ofs;
+  sqe->user_data = ofs;
+  ring->sq_tail++;
+}
+
+/* Hands the CNT queued requests to the kernel, waits for them,
+   and checks that each one transferred as much as it asked for,
+   or EXPECT bytes if that is not -2. */
+static void
+run (int cnt, int expect, const char *what)
+{
+  int i;
+
+  if (aio_enter (cnt, cnt) != cnt)
+    fail ("aio_enter() did not submit %d requests", cnt);
+  if ((int) (ring->cq_tail - ring->cq_head) != cnt)
+    fail ("%d completions, not %d", ring->cq_tail - ring->cq_head, cnt);
+  for (i = 0; i < cnt; i++)
+    {
+      struct aio_cqe *cqe = &ring->cq[ring->cq_head++ % AIO_ENTRIES];
+      int len = sizeof sample - 1 - cqe->user_data;
+
+      if (len > CHUNK)
+        len = CHUNK;
+      if (cqe->res != (expect != -2 ? expect : len))
+        fail ("%s at offset %u returned %d", what, cqe->user_data, cqe->res);
+    }
+}
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  size_t size = sizeof sample - 1;
+  size_t ofs;
+  int handle, cnt;
+
+  CHECK ((ring = aio_setup (RING_ADDR)) == RING_ADDR, "aio_setup");
+  CHECK (aio_setup ((char *) RING_ADDR + 4096) == NULL,
+         "second aio_setup fails");
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  msg ("write in chunks");
+  for (cnt = 0, ofs = 0; ofs < size; ofs += CHUNK, cnt++)
+    submit (AIO_WRITE, handle, sample + ofs,
+            size - ofs < CHUNK ? size - ofs : CHUNK, ofs);
+  run (cnt, -2, "write");
+
+  msg ("fsync");
+  submit (AIO_FSYNC, handle, NULL, 0, 0);
+  run (1, 0, "fsync");
+
+  msg ("read in chunks");
+  for (cnt = 0, ofs = 0; ofs < size; ofs += CHUNK, cnt++)
+    submit (AIO_READ, handle, buf + ofs,
+            size - ofs < CHUNK ? size - ofs : CHUNK, ofs);
+  run (cnt, -2, "read");
+  compare_bytes (buf, sample, size, 0, "test.txt");
+
+  msg ("read from bad fd");
+  submit (AIO_READ, 1234, buf, CHUNK, 0);
+  run (1, -1, "read");
+
+  msg ("read past AIO_MAX_BUFFERED");
+  for (cnt = 0; cnt <= BIG_CNT; cnt++)
+    submit (AIO_READ, handle, big, AIO_MAX_LEN, cnt);
+  if (aio_enter (cnt, cnt) != cnt)
+    fail ("aio_enter() did not submit %d requests", cnt);
+  while (ring->cq_head != ring->cq_tail)
+    {
+      struct aio_cqe *cqe = &ring->cq[ring->cq_head++ % AIO_ENTRIES];
+      int expect = (cqe->user_data < BIG_CNT
+                    ? (int) (size - cqe->user_data) : -1);
+
+      if (cqe->res != expect)
+        fail ("big read %u returned %d", cqe->user_data, cqe->res);
+    }
+
+  close (handle);
+}
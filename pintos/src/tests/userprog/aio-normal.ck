@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-normal) begin
+(aio-normal) aio_setup
+(aio-normal) second aio_setup fails
+(aio-normal) create "test.txt"
+(aio-normal) open "test.txt"
+(aio-normal) write in chunks
+(aio-normal) fsync
+(aio-normal) read in chunks
+(aio-normal) read from bad fd
+(aio-normal) read past AIO_MAX_BUFFERED
+(aio-normal) end
+aio-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Child process run by pipe-cloexec test.
+
+   The first command-line argument is the read end of a control
+   pipe, which it inherited.  The remaining arguments are the
+   descriptors of pipe ends created with PIPE_CLOEXEC, which must
+   not be open here.  Closes nothing and waits for a byte on the
+   control pipe before exiting. */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+int
+main (int argc, char *argv[]) 
+{
+  char c;
+  int i;
+
+  test_name = "child-cloexec";
+
+  if (argc != 6)
+    fail ("bad command-line arguments");
+  for (i = 1; i < argc; i++)
+    if (!isdigit (*argv[i]))
+      fail ("bad command-line arguments");
+  for (i = 2; i < argc; i++)
+    if (cloexec (atoi (argv[i]), -1) != -1)
+      fail ("inherited close-on-exec fd %s", argv[i]);
+  if (read (atoi (argv[1]), &c, 1) != 1)
+    fail ("read control pipe");
+
+  return 0;
+}
@@ -0,0 +1,39 @@
+/* Child process run by pipe-normal test.
+
+   Closes the pipe read end passed as the first command-line
+   argument, which it inherited, copies a string into the shared
+   memory segment named by the third argument, and then writes
+   6000 bytes to the pipe write end passed as the second
+   argument. */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+#define CHILD_BYTES 6000
+#define SHM_ADDR ((char *) 0x10000000)
+
+static char buf[CHILD_BYTES];
+
+int
+main (int argc, char *argv[]) 
+{
+  int i;
+
+  test_name = "child-pipe";
+
+  if (argc != 4 || !isdigit (*argv[1]) || !isdigit (*argv[2]))
+    fail ("bad command-line arguments");
+  close (atoi (argv[1]));
+  if (shm_map (atoi (argv[3]), SHM_ADDR, 4096) != SHM_ADDR)
+    fail ("shm_map");
+  strlcpy (SHM_ADDR, "from child", 4096);
+  for (i = 0; i < CHILD_BYTES; i++)
+    buf[i] = i % 251;
+  if (write (atoi (argv[2]), buf, CHILD_BYTES) != CHILD_BYTES)
+    fail ("write");
+
+  return 0;
+}
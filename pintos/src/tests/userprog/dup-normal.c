@@ -0,0 +1,48 @@
+/* Duplicates a descriptor for "sample.txt" with dup() and dup2()
+   and checks that all three share one file position, that the
+   file stays open until the last of them is closed, and that a
+   closed descriptor is the next one handed out.  Also checks
+   that each descriptor has its own close-on-exec flag, and that
+   the console descriptors, which are not open files, cannot be
+   duplicated or replaced. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define HIGH_FD 100
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  int fd, copy, high;
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((copy = dup (fd)) > 1 && copy != fd, "dup");
+  CHECK ((high = dup2 (copy, HIGH_FD)) == HIGH_FD, "dup2");
+  CHECK (dup (0) == -1 && dup (1) == -1, "dup of the console fails");
+  CHECK (dup2 (0, HIGH_FD + 1) == -1 && dup2 (fd, 1) == -1,
+         "dup2 to or from the console fails");
+  CHECK (cloexec (fd, 1) == 0 && cloexec (fd, -1) == 1, "cloexec");
+  CHECK (cloexec (copy, -1) == 0 && cloexec (high, -1) == 0,
+         "duplicates have their own close-on-exec flag");
+
+  if (read (fd, buf, 10) != 10)
+    fail ("read() through original failed");
+  if (tell (copy) != 10 || tell (high) != 10)
+    fail ("duplicates do not share the file position");
+  if (read (copy, buf + 10, 10) != 10)
+    fail ("read() through dup() failed");
+
+  close (fd);
+  close (copy);
+  if (read (high, buf + 20, sizeof sample - 21) != sizeof sample - 21)
+    fail ("read() through dup2() after closing the others failed");
+  compare_bytes (buf, sample, sizeof sample - 1, 0, "sample.txt");
+
+  CHECK (dup (high) == fd, "dup reuses lowest free fd");
+  CHECK (cloexec (fd, -1) == 0, "reused fd is not close-on-exec");
+  close (high);
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(dup-normal) begin
+(dup-normal) open "sample.txt"
+(dup-normal) dup
+(dup-normal) dup2
+(dup-normal) dup of the console fails
+(dup-normal) dup2 to or from the console fails
+(dup-normal) cloexec
+(dup-normal) duplicates have their own close-on-exec flag
+(dup-normal) dup reuses lowest free fd
+(dup-normal) reused fd is not close-on-exec
+(dup-normal) end
+dup-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,52 @@
+/* Writes a file and creates and removes a batch of files, calls
+   fsync() after each step, and checks that the data reads back.
+   Also checks that fsync() rejects bad fds and pipes. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 20
+
+static char buf[1500];
+
+void
+test_main (void) 
+{
+  char name[16], back[sizeof buf];
+  int fds[2];
+  int fd, i;
+
+  for (i = 0; i < (int) sizeof buf; i++)
+    buf[i] = i % 251;
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  CHECK (write (fd, buf, sizeof buf) == (int) sizeof buf,
+         "write \"data\"");
+  CHECK (fsync (fd) == 0, "fsync \"data\"");
+
+  msg ("create and remove %d files", FILE_CNT);
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (name, sizeof name, "f%d", i);
+      if (!create (name, 100))
+        fail ("create \"%s\" failed", name);
+      if (i % 2 == 0 && !remove (name))
+        fail ("remove \"%s\" failed", name);
+    }
+  CHECK (fsync (fd) == 0, "fsync \"data\"");
+
+  seek (fd, 0);
+  CHECK (read (fd, back, sizeof back) == (int) sizeof back,
+         "read \"data\"");
+  if (memcmp (back, buf, sizeof buf))
+    fail ("\"data\" does not match what was written");
+  close (fd);
+
+  CHECK (fsync (fd) == -1, "fsync closed fd");
+  CHECK (fsync (-1) == -1, "fsync bad fd");
+  CHECK (pipe (fds), "pipe");
+  CHECK (fsync (fds[1]) == -1, "fsync pipe");
+}
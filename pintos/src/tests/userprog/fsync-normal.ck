@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fsync-normal) begin
+(fsync-normal) create "data"
+(fsync-normal) open "data"
+(fsync-normal) write "data"
+(fsync-normal) fsync "data"
+(fsync-normal) create and remove 20 files
+(fsync-normal) fsync "data"
+(fsync-normal) read "data"
+(fsync-normal) fsync closed fd
+(fsync-normal) fsync bad fd
+(fsync-normal) pipe
+(fsync-normal) fsync pipe
+(fsync-normal) end
+fsync-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Starts a child that never closes the descriptors it was handed
+   and checks that pipes created with PIPE_CLOEXEC do not reach
+   it: while the child is still running, the parent sees end of
+   file once it closes its own write end, and a write fails once
+   it closes its own read end.  A control pipe, whose write end
+   is marked with cloexec(), keeps the child alive until then. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char cmd[64], c;
+  int ctl[2], data[2], noreader[2];
+  pid_t child;
+
+  CHECK (pipe (ctl), "pipe");
+  CHECK (cloexec (ctl[1], 1) == 0, "cloexec");
+  CHECK (pipe2 (data, PIPE_CLOEXEC), "pipe2");
+  CHECK (cloexec (data[0], -1) == 1 && cloexec (data[1], -1) == 1,
+         "pipe2 ends are close-on-exec");
+  CHECK (pipe2 (noreader, PIPE_CLOEXEC), "pipe2");
+
+  snprintf (cmd, sizeof cmd, "child-cloexec %d %d %d %d %d", ctl[0],
+            data[0], data[1], noreader[0], noreader[1]);
+  CHECK ((child = exec (cmd)) != PID_ERROR, "exec \"child-cloexec\"");
+  close (ctl[0]);
+
+  CHECK (write (data[1], "x", 1) == 1, "write 1 byte");
+  close (data[1]);
+  CHECK (read (data[0], &c, 1) == 1 && c == 'x', "read it back");
+  CHECK (read (data[0], &c, 1) == 0, "end of file");
+  close (data[0]);
+
+  close (noreader[0]);
+  CHECK (write (noreader[1], "x", 1) == -1, "write with no reader fails");
+  close (noreader[1]);
+
+  CHECK (write (ctl[1], "x", 1) == 1 && wait (child) == 0,
+         "release child and wait");
+  close (ctl[1]);
+}
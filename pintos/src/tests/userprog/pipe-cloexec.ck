@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-cloexec) begin
+(pipe-cloexec) pipe
+(pipe-cloexec) cloexec
+(pipe-cloexec) pipe2
+(pipe-cloexec) pipe2 ends are close-on-exec
+(pipe-cloexec) pipe2
+(pipe-cloexec) exec "child-cloexec"
+(pipe-cloexec) write 1 byte
+(pipe-cloexec) read it back
+(pipe-cloexec) end of file
+(pipe-cloexec) write with no reader fails
+(pipe-cloexec) release child and wait
+child-cloexec: exit(0)
+(pipe-cloexec) end
+pipe-cloexec: exit(0)
+EOF
+pass;
@@ -0,0 +1,65 @@
+/* Passes data through pipes and a shared memory segment.  A
+   child process inherits a pipe and sends data back over it,
+   while its writes wait on the parent's reads, and leaves a
+   string in shared memory.  Also checks end of file, writes
+   with no reader, and non-blocking pipes. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Bytes written by child-pipe, more than a pipe holds. */
+#define CHILD_BYTES 6000
+
+#define SHM_KEY 43
+#define SHM_ADDR ((char *) 0x10000000)
+
+static char buf[8192];
+
+void
+test_main (void) 
+{
+  char cmd[64];
+  int fds[2];
+  pid_t child;
+  int i, n, total;
+
+  CHECK (pipe (fds), "pipe");
+  CHECK (write (fds[1], "hello", 5) == 5, "write 5 bytes");
+  CHECK (read (fds[0], buf, sizeof buf) == 5 && !memcmp (buf, "hello", 5),
+         "read them back");
+  CHECK (filesize (fds[0]) == -1, "filesize on pipe fails");
+
+  CHECK (shm_map (SHM_KEY, SHM_ADDR, 4096) == SHM_ADDR, "shm_map");
+  snprintf (cmd, sizeof cmd, "child-pipe %d %d %d", fds[0], fds[1], SHM_KEY);
+  CHECK ((child = exec (cmd)) != PID_ERROR, "exec \"child-pipe\"");
+  close (fds[1]);
+  total = 0;
+  while ((n = read (fds[0], buf + total, sizeof buf - total)) > 0)
+    total += n;
+  CHECK (total == CHILD_BYTES, "read %d bytes until end of file", total);
+  for (i = 0; i < CHILD_BYTES; i++)
+    if (buf[i] != (char) (i % 251))
+      fail ("byte %d is %d, not %d", i, buf[i], i % 251);
+  CHECK (wait (child) == 0, "wait");
+  CHECK (!strcmp (SHM_ADDR, "from child"), "shm written by child");
+  CHECK (shm_unmap (SHM_ADDR), "shm_unmap");
+  close (fds[0]);
+
+  CHECK (pipe (fds), "pipe");
+  close (fds[0]);
+  CHECK (write (fds[1], "x", 1) == -1, "write with no reader fails");
+  close (fds[1]);
+
+  CHECK (pipe2 (fds, PIPE_NONBLOCK), "pipe2");
+  CHECK (read (fds[0], buf, 1) == -1, "empty read fails");
+  CHECK ((n = write (fds[1], buf, sizeof buf)) > 0 && n < (int) sizeof buf,
+         "write fills pipe");
+  CHECK (write (fds[1], buf, 1) == -1, "full write fails");
+  close (fds[1]);
+  CHECK (read (fds[0], buf, sizeof buf) == n, "read it all back");
+  CHECK (read (fds[0], buf, 1) == 0, "end of file");
+  close (fds[0]);
+}
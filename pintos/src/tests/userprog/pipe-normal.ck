@@ -0,0 +1,29 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-normal) begin
+(pipe-normal) pipe
+(pipe-normal) write 5 bytes
+(pipe-normal) read them back
+(pipe-normal) filesize on pipe fails
+(pipe-normal) shm_map
+(pipe-normal) exec "child-pipe"
+child-pipe: exit(0)
+(pipe-normal) read 6000 bytes until end of file
+(pipe-normal) wait
+(pipe-normal) shm written by child
+(pipe-normal) shm_unmap
+(pipe-normal) pipe
+(pipe-normal) write with no reader fails
+(pipe-normal) pipe2
+(pipe-normal) empty read fails
+(pipe-normal) write fills pipe
+(pipe-normal) full write fails
+(pipe-normal) read it all back
+(pipe-normal) end of file
+(pipe-normal) end
+pipe-normal: exit(0)
+EOF
+pass;
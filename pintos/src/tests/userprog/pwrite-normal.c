@@ -0,0 +1,46 @@
+/* Writes "sample.txt" into a new file back to front with
+   pwrite(), reads it back with pread(), and checks that neither
+   call moved the file position.  Also checks that offsets too
+   big for off_t are refused. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHUNK 64
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  size_t size = sizeof sample - 1;
+  size_t ofs;
+  int handle;
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  msg ("pwrite in reverse order");
+  for (ofs = (size - 1) / CHUNK * CHUNK; ; ofs -= CHUNK)
+    {
+      size_t len = size - ofs < CHUNK ? size - ofs : CHUNK;
+      if (pwrite (handle, sample + ofs, len, ofs) != (int) len)
+        fail ("pwrite() at offset %zu failed", ofs);
+      if (ofs == 0)
+        break;
+    }
+
+  msg ("pread whole file");
+  if (pread (handle, buf, size, 0) != (int) size)
+    fail ("pread() failed");
+  compare_bytes (buf, sample, size, 0, "test.txt");
+
+  CHECK (pread (handle, buf, 1, 0x80000000u) == -1
+         && pwrite (handle, sample, 1, 0x80000000u) == -1,
+         "offset past INT_MAX is refused");
+
+  if (tell (handle) != 0)
+    fail ("file position moved to %u", tell (handle));
+  close (handle);
+}
@@ -0,0 +1,37 @@
+/* Reads "sample.txt" with a single readv() into three buffers
+   of different sizes, then writes the same buffers back out to a
+   new file with writev(). */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char a[17], b[100], c[sizeof sample];
+  struct iovec iov[3] = {{a, sizeof a}, {b, sizeof b}, {c, sizeof c}};
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  byte_cnt = readv (handle, iov, 3);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("readv() returned %d instead of %zu", byte_cnt, sizeof sample - 1);
+  compare_bytes (a, sample, sizeof a, 0, "sample.txt");
+  compare_bytes (b, sample + sizeof a, sizeof b, sizeof a, "sample.txt");
+  compare_bytes (c, sample + sizeof a + sizeof b,
+                 sizeof sample - 1 - sizeof a - sizeof b,
+                 sizeof a + sizeof b, "sample.txt");
+  close (handle);
+
+  CHECK (create ("test.txt", 0), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  iov[2].iov_len = sizeof sample - 1 - sizeof a - sizeof b;
+  byte_cnt = writev (handle, iov, 3);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("writev() returned %d instead of %zu", byte_cnt, sizeof sample - 1);
+  close (handle);
+
+  check_file ("test.txt", sample, sizeof sample - 1);
+}
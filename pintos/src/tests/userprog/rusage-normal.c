@@ -0,0 +1,62 @@
+/* Checks that getrusage() charges a process for what it does:
+   the major faults that loaded its code, the minor faults on
+   fresh heap pages, the sectors fsync() writes, CPU time spent
+   spinning, and blocking to wait for a child, whose own use
+   then shows up under RUSAGE_CHILDREN. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HEAP_PAGES 4
+
+static struct rusage before, after, children;
+static char buf[PAGE_SIZE];
+
+void
+test_main (void) 
+{
+  char *heap;
+  int fd, i;
+
+  CHECK (getrusage (RUSAGE_SELF, &before), "getrusage");
+  CHECK (!getrusage (2, &after), "getrusage with bad WHO (must fail)");
+  if (before.major_faults == 0)
+    fail ("loading the program took no major faults");
+
+  CHECK ((heap = sbrk (HEAP_PAGES * PAGE_SIZE)) != (void *) -1, "sbrk");
+  for (i = 0; i < HEAP_PAGES; i++)
+    heap[i * PAGE_SIZE] = 1;
+
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  CHECK (write (fd, buf, sizeof buf) == (int) sizeof buf, "write \"data\"");
+  CHECK (fsync (fd) == 0, "fsync \"data\"");
+  close (fd);
+
+  msg ("spin");
+  do
+    {
+      volatile int n;
+      for (n = 0; n < 100000; n++)
+        continue;
+      getrusage (RUSAGE_SELF, &after);
+    }
+  while (after.user_ticks == before.user_ticks);
+
+  msg ("wait(exec()) = %d", wait (exec ("child-simple")));
+  CHECK (getrusage (RUSAGE_SELF, &after), "getrusage again");
+  CHECK (getrusage (RUSAGE_CHILDREN, &children),
+         "getrusage (RUSAGE_CHILDREN)");
+
+  if (after.minor_faults < before.minor_faults + HEAP_PAGES)
+    fail ("touching %d heap pages took %llu minor faults", HEAP_PAGES,
+          after.minor_faults - before.minor_faults);
+  if (after.blocks_written <= before.blocks_written)
+    fail ("fsync() wrote no sectors");
+  if (after.voluntary_switches <= before.voluntary_switches)
+    fail ("waiting for a child never blocked");
+  if (children.major_faults == 0)
+    fail ("the child's page faults were not counted");
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rusage-normal) begin
+(rusage-normal) getrusage
+(rusage-normal) getrusage with bad WHO (must fail)
+(rusage-normal) sbrk
+(rusage-normal) create "data"
+(rusage-normal) open "data"
+(rusage-normal) write "data"
+(rusage-normal) fsync "data"
+(rusage-normal) spin
+(child-simple) run
+child-simple: exit(81)
+(rusage-normal) wait(exec()) = 81
+(rusage-normal) getrusage again
+(rusage-normal) getrusage (RUSAGE_CHILDREN)
+(rusage-normal) end
+rusage-normal: exit(0)
+EOF
+pass;
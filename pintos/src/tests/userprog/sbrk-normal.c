@@ -0,0 +1,61 @@
+/* Grows the heap with sbrk(), checks that the new memory reads
+   as zeroes and can be written, shrinks it back, checks that
+   the heap grows to HEAP_MAX and no further, then exercises
+   malloc(), realloc(), and free_bulk() on top of it. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define GROW (3 * 4096 + 100)
+
+/* Heap size limit, as in userprog/syscall.c. */
+#define HEAP_MAX (32 * 1024 * 1024)
+#define BLOCK_CNT 100
+
+static void *blocks[BLOCK_CNT];
+
+void
+test_main (void) 
+{
+  char *start, *p;
+  size_t i;
+
+  start = sbrk (0);
+  CHECK (start != (void *) -1, "sbrk(0)");
+  CHECK ((p = sbrk (GROW)) == start, "sbrk(%d)", GROW);
+  for (i = 0; i < GROW; i++)
+    if (p[i] != 0)
+      fail ("byte %zu of new heap is %d, not 0", i, p[i]);
+  memset (p, 0x5a, GROW);
+  CHECK (sbrk (-GROW) == start + GROW, "sbrk(%d)", -GROW);
+  CHECK (sbrk (0) == start, "heap is back where it started");
+  CHECK (sbrk (0x40000000) == (void *) -1, "sbrk(1 GB) fails");
+  CHECK (sbrk (HEAP_MAX) == start, "sbrk(HEAP_MAX)");
+  start[HEAP_MAX - 1] = 1;
+  CHECK (sbrk (1) == (void *) -1, "sbrk(1) past HEAP_MAX fails");
+  CHECK (sbrk (-HEAP_MAX) == start + HEAP_MAX, "sbrk(-HEAP_MAX)");
+
+  for (i = 0; i < BLOCK_CNT; i++) 
+    {
+      size_t size = 1 + i * 37;
+      blocks[i] = malloc (size);
+      if (blocks[i] == NULL)
+        fail ("malloc(%zu) failed", size);
+      memset (blocks[i], i, size);
+    }
+  for (i = 0; i < BLOCK_CNT; i++) 
+    {
+      size_t size = 1 + i * 37;
+      blocks[i] = realloc (blocks[i], size * 2);
+      if (blocks[i] == NULL)
+        fail ("realloc() failed");
+      if (memchr (blocks[i], i, size) != blocks[i]
+          || ((char *) blocks[i])[size - 1] != (char) i)
+        fail ("block %zu was corrupted", i);
+    }
+  free_bulk (blocks, BLOCK_CNT);
+  msg ("malloc, realloc, free_bulk");
+}
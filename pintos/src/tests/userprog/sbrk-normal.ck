@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sbrk-normal) begin
+(sbrk-normal) sbrk(0)
+(sbrk-normal) sbrk(12388)
+(sbrk-normal) sbrk(-12388)
+(sbrk-normal) heap is back where it started
+(sbrk-normal) sbrk(1 GB) fails
+(sbrk-normal) sbrk(HEAP_MAX)
+(sbrk-normal) sbrk(1) past HEAP_MAX fails
+(sbrk-normal) sbrk(-HEAP_MAX)
+(sbrk-normal) malloc, realloc, free_bulk
+(sbrk-normal) end
+sbrk-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,35 @@
+/* Copies "sample.txt" to a new file with sendfile(), starting
+   partway in and finishing with a second call, then checks the
+   copy and that the source position ended up at end of file. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SKIP 10
+
+void
+test_main (void) 
+{
+  int in_fd, out_fd, byte_cnt;
+  int size = sizeof sample - 1;
+
+  CHECK ((in_fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("test.txt", 0), "create \"test.txt\"");
+  CHECK ((out_fd = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  byte_cnt = sendfile (out_fd, in_fd, SKIP);
+  if (byte_cnt != SKIP)
+    fail ("sendfile() returned %d instead of %d", byte_cnt, SKIP);
+  byte_cnt = sendfile (out_fd, in_fd, 100000);
+  if (byte_cnt != size - SKIP)
+    fail ("sendfile() returned %d instead of %d", byte_cnt, size - SKIP);
+  if ((int) tell (in_fd) != size)
+    fail ("source position is %u instead of %d", tell (in_fd), size);
+  if (sendfile (out_fd, in_fd, 100000) != 0)
+    fail ("sendfile() at end of file copied data");
+  close (out_fd);
+
+  check_file ("test.txt", sample, size);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sendfile-normal) begin
+(sendfile-normal) open "sample.txt"
+(sendfile-normal) create "test.txt"
+(sendfile-normal) open "test.txt"
+(sendfile-normal) open "test.txt" for verification
+(sendfile-normal) verified contents of "test.txt"
+(sendfile-normal) close "test.txt"
+(sendfile-normal) end
+sendfile-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,29 @@
+/* Checks that a shared memory segment that would take the pages
+   held by all segments past SHM_TOTAL_PAGES is refused, and that
+   the pages count again once the segment holding them is gone. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SMALL_KEY 44
+#define SMALL_ADDR ((char *) 0x10000000)
+#define BIG_KEY 45
+#define BIG_ADDR ((char *) 0x20000000)
+#define BIG_SIZE (SHM_TOTAL_PAGES * 4096)
+
+void
+test_main (void) 
+{
+  CHECK (shm_map (SMALL_KEY, SMALL_ADDR, 4096) == SMALL_ADDR,
+         "shm_map 1 page");
+  CHECK (shm_map (BIG_KEY, BIG_ADDR, BIG_SIZE) == NULL,
+         "shm_map SHM_TOTAL_PAGES more pages fails");
+  CHECK (shm_unmap (SMALL_ADDR), "shm_unmap 1 page");
+  CHECK (shm_map (BIG_KEY, BIG_ADDR, BIG_SIZE) == BIG_ADDR,
+         "shm_map SHM_TOTAL_PAGES pages");
+  BIG_ADDR[BIG_SIZE - 1] = 1;
+  CHECK (shm_map (SMALL_KEY, SMALL_ADDR, 4096) == NULL,
+         "shm_map 1 more page fails");
+  CHECK (shm_unmap (BIG_ADDR), "shm_unmap SHM_TOTAL_PAGES pages");
+}
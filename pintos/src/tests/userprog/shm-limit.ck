@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(shm-limit) begin
+(shm-limit) shm_map 1 page
+(shm-limit) shm_map SHM_TOTAL_PAGES more pages fails
+(shm-limit) shm_unmap 1 page
+(shm-limit) shm_map SHM_TOTAL_PAGES pages
+(shm-limit) shm_map 1 more page fails
+(shm-limit) shm_unmap SHM_TOTAL_PAGES pages
+(shm-limit) end
+shm-limit: exit(0)
+EOF
+pass;
@@ -0,0 +1,39 @@
+/* Samples the kernel's counters with stats() before and after
+   reading "sample.txt" and checks that they moved the way the
+   read should have moved them. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct kstats before, after;
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  int fd;
+
+  CHECK (stats (&before), "stats");
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  if (read (fd, buf, sizeof sample - 1) != sizeof sample - 1)
+    fail ("read() failed");
+  close (fd);
+  CHECK (stats (&after), "stats again");
+
+  if (after.ticks < before.ticks)
+    fail ("tick count went backward");
+  if (after.thread_ticks < before.thread_ticks)
+    fail ("thread tick count went backward");
+  if (after.bc_hits + after.bc_misses <= before.bc_hits + before.bc_misses)
+    fail ("read did not go through the buffer cache");
+  if (after.dc_hits + after.dc_misses <= before.dc_hits + before.dc_misses)
+    fail ("open did not look up the dentry cache");
+  if (after.faults[0] + after.faults[2] + after.faults[3] == 0)
+    fail ("no page faults counted");
+  if (after.blocks[1].name[0] == '\0')
+    fail ("no file system device");
+  msg ("counters advanced");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(stats-normal) begin
+(stats-normal) stats
+(stats-normal) open "sample.txt"
+(stats-normal) stats again
+(stats-normal) counters advanced
+(stats-normal) end
+stats-normal: exit(0)
+EOF
+pass;
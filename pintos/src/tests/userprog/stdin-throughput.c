@@ -0,0 +1,63 @@
+/* Reads LINE_CNT numbered lines, "0000000\n" onward, from the
+   serial port as standard input: the first LINE_MODE_CNT a line
+   per read() in TTY_LINE mode, the rest in large TTY_RAW reads.
+   Checks that every byte arrives in order and that ttypoll()
+   reports no input left at the end.  Compare the time taken
+   across kernels with "make timing". */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LINE_LEN 8
+#define LINE_CNT 8192
+#define LINE_MODE_CNT 1024
+
+static char buf[4096];
+
+/* Fails unless the SIZE bytes in BUF are the input stream's
+   bytes starting at offset OFS. */
+static void
+check_input (const char *buf, size_t size, size_t ofs)
+{
+  char line[16];                /* Room for any size_t, not just LINE_LEN. */
+  size_t i;
+
+  for (i = 0; i < size; i++, ofs++)
+    {
+      if (i == 0 || ofs % LINE_LEN == 0)
+        snprintf (line, sizeof line, "%07zu\n", ofs / LINE_LEN);
+      if (buf[i] != line[ofs % LINE_LEN])
+        fail ("wrong byte at offset %zu", ofs);
+    }
+}
+
+void
+test_main (void) 
+{
+  size_t ofs, total = LINE_CNT * LINE_LEN;
+  int n, i;
+
+  CHECK (ttymode (TTY_LINE) == TTY_RAW, "ttymode (TTY_LINE)");
+  msg ("read %d lines", LINE_MODE_CNT);
+  for (i = 0, ofs = 0; i < LINE_MODE_CNT; i++, ofs += LINE_LEN)
+    {
+      n = read (STDIN_FILENO, buf, sizeof buf);
+      if (n != LINE_LEN)
+        fail ("read of line %d returned %d bytes", i, n);
+      check_input (buf, n, ofs);
+    }
+
+  CHECK (ttymode (TTY_RAW) == TTY_LINE, "ttymode (TTY_RAW)");
+  msg ("read the remaining %zu bytes", total - ofs);
+  for (; ofs < total; ofs += n)
+    {
+      n = read (STDIN_FILENO, buf, sizeof buf);
+      if (n <= 0 || (size_t) n > total - ofs)
+        fail ("read at offset %zu returned %d", ofs, n);
+      check_input (buf, n, ofs);
+    }
+  CHECK (ttypoll () == 0, "ttypoll");
+}
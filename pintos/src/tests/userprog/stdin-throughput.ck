@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(stdin-throughput) begin
+(stdin-throughput) ttymode (TTY_LINE)
+(stdin-throughput) read 1024 lines
+(stdin-throughput) ttymode (TTY_RAW)
+(stdin-throughput) read the remaining 57344 bytes
+(stdin-throughput) ttypoll
+(stdin-throughput) end
+stdin-throughput: exit(0)
+EOF
+pass;
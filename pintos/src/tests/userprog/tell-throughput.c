@@ -0,0 +1,26 @@
+/* Issues a million "tell" system calls on an open file, as a
+   measure of raw system call overhead.  Each call must still
+   report the position set by the preceding seek.  Compare the
+   "Timer: N ticks" line printed at shutdown across kernels. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CALL_CNT 1000000
+
+void
+test_main (void) 
+{
+  int handle;
+  int i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  seek (handle, 7);
+
+  msg ("tell %d times", CALL_CNT);
+  for (i = 0; i < CALL_CNT; i++)
+    if (tell (handle) != 7)
+      fail ("tell() returned %u on call %d", tell (handle), i);
+  msg ("done");
+}
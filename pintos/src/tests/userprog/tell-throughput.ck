@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(tell-throughput) begin
+(tell-throughput) open "sample.txt"
+(tell-throughput) tell 1000000 times
+(tell-throughput) done
+(tell-throughput) end
+tell-throughput: exit(0)
+EOF
+pass;
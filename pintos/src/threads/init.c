@@ -21,9 +21,11 @@
 #include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/smp.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
+#include "userprog/aio.h"
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
@@ -36,8 +38,10 @@
 #include "devices/ide.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
+#include "filesys/journal.h"
 #include "filesys/buffer_cache.h"
 #endif
+#include "vm/shm.h"
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -58,6 +62,12 @@ static const char *swap_bdev_name;
 /* -ul: Maximum number of pages to put into palloc's user pool. */
 static size_t user_page_limit = SIZE_MAX;
 
+/* -lpt: Timer loops per tick, or 0 to calibrate at boot. */
+static unsigned preset_loops_per_tick;
+
+/* -bt: Print a timestamp as each boot phase finishes? */
+static bool boot_trace;
+
 static void bss_init (void);
 static void paging_init (void);
 
@@ -65,6 +75,7 @@ static char **read_command_line (void);
 static char **parse_options (char **argv);
 static void run_actions (char **argv);
 static void usage (void);
+static void boot_phase (const char *name);
 
 #ifdef FILESYS
 static void locate_block_devices (void);
@@ -98,6 +109,8 @@ main (void)
   palloc_init (user_page_limit);
   malloc_init ();
   paging_init ();
+  smp_init ();
+  boot_phase ("memory");
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -113,24 +126,41 @@ main (void)
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  process_init ();
 #endif
+  boot_phase ("interrupts");
 
   /* Start thread scheduler and enable interrupts. */
   thread_start ();
   serial_init_queue ();
-  timer_calibrate ();
+  if (preset_loops_per_tick != 0)
+    timer_set_loops_per_tick (preset_loops_per_tick);
+  else
+    timer_calibrate ();
+  boot_phase ("timer");
+
+  /* Start the other CPUs, if any. */
+  smp_start ();
+  boot_phase ("smp");
 
 #ifdef FILESYS
   /* Initialize file system. */
   ide_init ();
+  boot_phase ("ide");
   locate_block_devices ();
   filesys_init (format_filesys);
+  boot_phase ("filesys");
 #endif
 
   printf ("Boot complete.\n");
   swap_init();
     
   lru_list_init();
+  shm_init();
+#ifdef USERPROG
+  aio_init();
+#endif
+  boot_phase ("vm");
   /* Run actions specified on kernel command line. */
   run_actions (argv);
   /* Finish up. */
@@ -248,6 +278,8 @@ parse_options (char **argv)
         filesys_bdev_name = value;
       else if (!strcmp (name, "-scratch"))
         scratch_bdev_name = value;
+      else if (!strcmp (name, "-jcrash"))
+        journal_crash = true;
 #ifdef VM
       else if (!strcmp (name, "-swap"))
         swap_bdev_name = value;
@@ -257,9 +289,15 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-lpt"))
+        preset_loops_per_tick = atoi (value);
+      else if (!strcmp (name, "-bt"))
+        boot_trace = true;
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+      else if (!strcmp (name, "-ru"))
+        process_report_rusage = true;
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -374,19 +412,34 @@ usage (void)
           "  -f                 Format file system device during startup.\n"
           "  -filesys=BDEV      Use BDEV for file system instead of default.\n"
           "  -scratch=BDEV      Use BDEV for scratch instead of default.\n"
+          "  -jcrash            At shutdown, commit the journal but leave\n"
+          "                     it for the next boot to replay.\n"
 #ifdef VM
           "  -swap=BDEV         Use BDEV for swap instead of default.\n"
 #endif
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -lpt=LOOPS         Use LOOPS timer loops per tick, skipping\n"
+          "                     calibration.  LOOPS is the loops/s figure\n"
+          "                     from an earlier boot divided by %d.\n"
+          "  -bt                Print the time each boot phase finishes.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+          "  -ru                Print each process's resource use at exit.\n"
 #endif
-          );
+          , TIMER_FREQ);
   shutdown_power_off ();
 }
 
+/* With -bt, reports that boot phase NAME has just finished. */
+static void
+boot_phase (const char *name) 
+{
+  if (boot_trace)
+    printf ("Boot phase %s done at tick %"PRId64".\n", name, timer_ticks ());
+}
+
 #ifdef FILESYS
 /* Figure out what block devices to cast in the various Pintos roles. */
 static void
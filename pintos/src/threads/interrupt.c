@@ -6,6 +6,8 @@
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
+#include "threads/smp.h"
+#include "threads/spinlock.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
@@ -43,13 +45,21 @@ static unsigned int unexpected_cnt[INTR_CNT];
    pre-empted.  Handlers for external interrupts also may not
    sleep, although they may invoke intr_yield_on_return() to
    request that a new process be scheduled just before the
-   interrupt returns. */
-static bool in_external_intr;   /* Are we processing an external interrupt? */
-static bool yield_on_return;    /* Should we yield on interrupt return? */
+   interrupt returns.  Inter-processor interrupts are external
+   interrupts too.  Each CPU tracks its own in its struct cpu. */
+
+/* Big kernel lock.  Once smp_start() has started other CPUs, a
+   CPU holds it whenever it runs with interrupts off, so that
+   turning interrupts off keeps every other CPU out, not just
+   interrupt handlers on the same one.  It is held across thread
+   switches, like the interrupts-off state it stands for. */
+static struct spinlock big_lock;
+static bool big_lock_on;        /* Taken with interrupts off? */
 
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
+static bool is_external (uint8_t vec_no);
 
 /* Interrupt Descriptor Table helpers. */
 static uint64_t make_intr_gate (void (*) (void), int dpl);
@@ -90,6 +100,10 @@ intr_enable (void)
   enum intr_level old_level = intr_get_level ();
   ASSERT (!intr_context ());
 
+  if (old_level == INTR_OFF && big_lock_on
+      && spinlock_held_by_current_cpu (&big_lock))
+    spinlock_release (&big_lock);
+
   /* Enable interrupts by setting the interrupt flag.
 
      See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
@@ -110,8 +124,33 @@ intr_disable (void)
      Hardware Interrupts". */
   asm volatile ("cli" : : : "memory");
 
+  if (big_lock_on && !spinlock_held_by_current_cpu (&big_lock))
+    spinlock_acquire (&big_lock);
+
   return old_level;
 }
+
+/* Enables interrupts and halts the CPU until the next one
+   arrives.  Interrupts must be off.
+
+   The `sti' instruction disables interrupts until the completion
+   of the next instruction, so `sti; hlt' is executed atomically.
+   This atomicity is important; otherwise, an interrupt could be
+   handled between re-enabling interrupts and waiting for the
+   next one to occur, wasting as much as one clock tick worth of
+   time.
+
+   See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a] 7.11.1
+   "HLT Instruction". */
+void
+intr_wait (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (big_lock_on && spinlock_held_by_current_cpu (&big_lock))
+    spinlock_release (&big_lock);
+  asm volatile ("sti; hlt" : : : "memory");
+}
 
 /* Initializes the interrupt system. */
 void
@@ -155,6 +194,30 @@ intr_init (void)
   intr_names[17] = "#AC Alignment Check Exception";
   intr_names[18] = "#MC Machine-Check Exception";
   intr_names[19] = "#XF SIMD Floating-Point Exception";
+  intr_names[IPI_TLB] = "IPI TLB Shootdown";
+  intr_names[IPI_SPURIOUS] = "APIC Spurious Interrupt";
+}
+
+/* Loads the IDT set up by intr_init() on an application
+   processor. */
+void
+intr_init_ap (void) 
+{
+  uint64_t idtr_operand = make_idtr_operand (sizeof idt - 1, idt);
+  asm volatile ("lidt %0" : : "m" (idtr_operand));
+}
+
+/* Turns on the big kernel lock, just before smp_start() starts
+   the other CPUs, and takes it for the current CPU.  Interrupts
+   must be off. */
+void
+intr_init_smp (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  spinlock_init (&big_lock);
+  spinlock_acquire (&big_lock);
+  big_lock_on = true;
 }
 
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
@@ -181,7 +244,7 @@ void
 intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
                    const char *name) 
 {
-  ASSERT (vec_no >= 0x20 && vec_no <= 0x2f);
+  ASSERT (is_external (vec_no));
   register_handler (vec_no, 0, INTR_OFF, handler, name);
 }
 
@@ -202,7 +265,7 @@ void
 intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
                    intr_handler_func *handler, const char *name)
 {
-  ASSERT (vec_no < 0x20 || vec_no > 0x2f);
+  ASSERT (!is_external (vec_no));
   register_handler (vec_no, dpl, level, handler, name);
 }
 
@@ -211,7 +274,9 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 bool
 intr_context (void) 
 {
-  return in_external_intr;
+  /* External interrupts run with interrupts off, which also
+     keeps us on the CPU we ask about. */
+  return intr_get_level () == INTR_OFF && cpu_current ()->in_external_intr;
 }
 
 /* During processing of an external interrupt, directs the
@@ -222,7 +287,16 @@ void
 intr_yield_on_return (void) 
 {
   ASSERT (intr_context ());
-  yield_on_return = true;
+  cpu_current ()->yield_on_return = true;
+}
+
+/* Returns true if VEC_NO is an external interrupt vector: an
+   8259A PIC interrupt or an inter-processor interrupt. */
+static bool
+is_external (uint8_t vec_no) 
+{
+  return (vec_no >= 0x20 && vec_no <= 0x2f)
+          || (vec_no >= IPI_TICK && vec_no <= IPI_TLB);
 }
 
 /* 8259A Programmable Interrupt Controller. */
@@ -346,26 +420,44 @@ intr_handler (struct intr_frame *frame)
 {
   bool external;
   intr_handler_func *handler;
+  struct cpu *c;
+
+  /* A TLB shootdown is served without the big kernel lock, which
+     the CPU that sent it holds while it waits. */
+  if (frame->vec_no == IPI_TLB) 
+    {
+      smp_flush_tlb ();
+      smp_eoi ();
+      return;
+    }
+
+  /* An interrupt gate turned interrupts off, so take the big
+     kernel lock that goes with that. */
+  if (intr_get_level () == INTR_OFF)
+    intr_disable ();
 
   /* External interrupts are special.
      We only handle one at a time (so interrupts must be off)
-     and they need to be acknowledged on the PIC (see below).
+     and they need to be acknowledged on the PIC or local APIC
+     (see below).
      An external interrupt handler cannot sleep. */
-  external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+  external = is_external (frame->vec_no);
   if (external) 
     {
       ASSERT (intr_get_level () == INTR_OFF);
       ASSERT (!intr_context ());
 
-      in_external_intr = true;
-      yield_on_return = false;
+      c = cpu_current ();
+      c->in_external_intr = true;
+      c->yield_on_return = false;
     }
 
   /* Invoke the interrupt's handler. */
   handler = intr_handlers[frame->vec_no];
   if (handler != NULL)
     handler (frame);
-  else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f)
+  else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f
+           || frame->vec_no == IPI_SPURIOUS)
     {
       /* There is no handler, but this interrupt can trigger
          spuriously due to a hardware fault or hardware race
@@ -379,12 +471,25 @@ intr_handler (struct intr_frame *frame)
       ASSERT (intr_get_level () == INTR_OFF);
       ASSERT (intr_context ());
 
-      in_external_intr = false;
-      pic_end_of_interrupt (frame->vec_no); 
+      c = cpu_current ();
+      c->in_external_intr = false;
+      if (frame->vec_no >= IPI_TICK)
+        smp_eoi ();
+      else
+        pic_end_of_interrupt (frame->vec_no); 
 
-      if (yield_on_return) 
+      if (c->yield_on_return) 
         thread_yield (); 
     }
+
+  /* Leave the big kernel lock as the interrupted code had it:
+     held if it ran with interrupts off, free if not, since
+     returning restores its interrupt flag. */
+  if (!(frame->eflags & FLAG_IF))
+    intr_disable ();
+  else if (intr_get_level () == INTR_OFF && big_lock_on
+           && spinlock_held_by_current_cpu (&big_lock))
+    spinlock_release (&big_lock);
 }
 
 /* Handles an unexpected interrupt with interrupt frame F.  An
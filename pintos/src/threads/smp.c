@@ -0,0 +1,530 @@
+#include "threads/smp.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/io.h"
+#include "threads/loader.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+#ifdef USERPROG
+#include "userprog/gdt.h"
+#endif
+
+/* Symmetric multiprocessing.
+
+   The BIOS describes the CPUs in the MP configuration table
+   (see [MP] chapter 4).  Each CPU has a local APIC, through
+   which it receives timer ticks, reschedule requests, and TLB
+   shootdowns from the others as inter-processor interrupts
+   (IPIs).  Device interrupts still come from the 8259A PICs,
+   which stay wired to the BSP.
+
+   The kernel keeps its uniprocessor locking: code that turns
+   interrupts off also holds the big kernel lock (see
+   interrupt.c), so it still excludes every other CPU. */
+
+/* MP floating pointer structure.  See [MP] 4.1. */
+struct mp_float
+  {
+    char signature[4];          /* "_MP_". */
+    uint32_t config;            /* Physical address of struct mp_config. */
+    uint8_t length;             /* Length in 16-byte units. */
+    uint8_t revision;           /* [MP] version. */
+    uint8_t checksum;           /* All bytes add up to 0. */
+    uint8_t type;               /* Default configuration, if nonzero. */
+    uint8_t features[4];        /* Feature bytes. */
+  };
+
+/* MP configuration table header.  See [MP] 4.2. */
+struct mp_config
+  {
+    char signature[4];          /* "PCMP". */
+    uint16_t length;            /* Length of base table. */
+    uint8_t revision;           /* [MP] version. */
+    uint8_t checksum;           /* All bytes add up to 0. */
+    char oem_id[8];
+    char product_id[12];
+    uint32_t oem_table;
+    uint16_t oem_length;
+    uint16_t entry_cnt;         /* Number of entries after header. */
+    uint32_t lapic_addr;        /* Physical address of local APICs. */
+    uint16_t ext_length;
+    uint8_t ext_checksum;
+    uint8_t reserved;
+  };
+
+/* Processor entry in the MP configuration table.  Entries of
+   other types are 8 bytes long.  See [MP] 4.3.1. */
+struct mp_proc
+  {
+    uint8_t type;               /* MP_PROC. */
+    uint8_t apic_id;            /* Local APIC ID. */
+    uint8_t apic_version;
+    uint8_t flags;              /* MP_PROC_* bits. */
+    uint32_t signature;
+    uint32_t features;
+    uint32_t reserved[2];
+  };
+
+#define MP_PROC 0               /* Processor entry type. */
+#define MP_PROC_ENABLED 0x01    /* Usable. */
+#define MP_PROC_BSP 0x02        /* Bootstrap processor. */
+
+/* Local APIC registers, as byte offsets.  See [IA32-v3a] 8.4
+   "Local APIC". */
+#define LAPIC_ID 0x020          /* ID. */
+#define LAPIC_TPR 0x080         /* Task priority. */
+#define LAPIC_EOI 0x0b0         /* End of interrupt. */
+#define LAPIC_SVR 0x0f0         /* Spurious interrupt vector. */
+#define LAPIC_ICR_LO 0x300      /* Interrupt command, low word. */
+#define LAPIC_ICR_HI 0x310      /* Interrupt command, high word. */
+#define LAPIC_LINT0 0x350       /* Local interrupt 0 vector. */
+#define LAPIC_LINT1 0x360       /* Local interrupt 1 vector. */
+
+#define SVR_ENABLE 0x00000100   /* APIC software enable. */
+#define ICR_INIT 0x00000500     /* INIT delivery mode. */
+#define ICR_STARTUP 0x00000600  /* STARTUP delivery mode. */
+#define ICR_PENDING 0x00001000  /* Delivery status: send pending. */
+#define ICR_ASSERT 0x00004000   /* Level: assert. */
+#define ICR_LEVEL 0x00008000    /* Trigger mode: level. */
+#define LVT_NMI 0x00000400      /* NMI delivery mode. */
+#define LVT_EXTINT 0x00000700   /* External (8259A) delivery mode. */
+#define LVT_MASKED 0x00010000   /* Masked. */
+
+/* Kernel virtual address where the local APIC is mapped.  Each
+   CPU sees its own local APIC at the same address.  This is
+   above the kernel's mapping of physical memory. */
+#define LAPIC_VADDR 0xfee00000
+
+/* Physical address to which smp_start() copies ap-start.S for
+   application processors to start at.  It must be a page
+   boundary below 1 MB, in memory that is free after boot. */
+#define AP_START 0x8000
+
+/* CPUs.  cpus[0] is the BSP. */
+struct cpu cpus[CPU_MAX];
+size_t cpu_cnt = 1;
+
+/* Index in cpus[] of each local APIC ID. */
+static uint8_t cpu_by_apic_id[256];
+
+/* Local APIC registers, or a null pointer if there is only one
+   CPU. */
+static volatile uint32_t *lapic;
+
+/* Initial stack pointer for the application processor being
+   started, read by ap-start.S. */
+void *ap_stack;
+
+void ap_main (void) NO_RETURN;
+static struct mp_config *find_mp_config (void);
+static void map_lapic (uint32_t paddr);
+static void lapic_init (bool bsp);
+static uint32_t lapic_read (int reg);
+static void lapic_write (int reg, uint32_t value);
+static void lapic_command (uint8_t apic_id, uint32_t command);
+static void start_ap (struct cpu *);
+static intr_handler_func tick_interrupt, reschedule_interrupt;
+
+/* Reads the MP configuration table, if the BIOS provided one,
+   and records the CPUs that it lists in cpus[].  If there is
+   more than one, maps the local APIC.
+
+   Must be called after paging_init() and before any page
+   directory is created, since those copy init_page_dir. */
+void
+smp_init (void)
+{
+  struct mp_config *config = find_mp_config ();
+  uint8_t ids[CPU_MAX - 1];
+  size_t ap_cnt = 0;
+  uint8_t *entry;
+  size_t i;
+
+  if (config == NULL)
+    return;
+
+  entry = (uint8_t *) (config + 1);
+  for (i = 0; i < config->entry_cnt; i++)
+    if (*entry == MP_PROC)
+      {
+        struct mp_proc *proc = (struct mp_proc *) entry;
+        if ((proc->flags & (MP_PROC_ENABLED | MP_PROC_BSP)) == MP_PROC_ENABLED
+            && ap_cnt < sizeof ids)
+          ids[ap_cnt++] = proc->apic_id;
+        entry += sizeof *proc;
+      }
+    else
+      entry += 8;
+
+  if (ap_cnt == 0)
+    return;
+
+  map_lapic (config->lapic_addr);
+  cpus[0].apic_id = lapic_read (LAPIC_ID) >> 24;
+  for (i = 0; i < ap_cnt; i++)
+    if (ids[i] != cpus[0].apic_id)
+      {
+        cpus[cpu_cnt].apic_id = ids[i];
+        cpu_by_apic_id[ids[i]] = cpu_cnt++;
+      }
+}
+
+/* Starts the application processors that smp_init() found, and
+   from then on has every CPU hold the big kernel lock while it
+   runs with interrupts off.  Must be called with interrupts on,
+   once the timer is calibrated, since starting a processor takes
+   timed delays. */
+void
+smp_start (void)
+{
+  extern char ap_start[], ap_start_end[], ap_start_cr3[], ap_start_gdtr[];
+  uint8_t *code = ptov (AP_START);
+  enum intr_level old_level;
+  uint32_t *pd;
+  size_t i;
+
+  ASSERT (intr_get_level () == INTR_ON);
+
+  if (cpu_cnt < 2)
+    return;
+
+  intr_register_ext (IPI_TICK, tick_interrupt, "IPI Timer Tick");
+  intr_register_ext (IPI_RESCHEDULE, reschedule_interrupt,
+                     "IPI Reschedule");
+
+  /* ap-start.S runs at its physical address until it reaches
+     kernel virtual addresses, so it needs a page directory that
+     maps the first 4 MB both ways, like the one start.S uses. */
+  pd = palloc_get_page (PAL_ASSERT);
+  memcpy (pd, init_page_dir, PGSIZE);
+  pd[0] = init_page_dir[pd_no (PHYS_BASE)];
+
+  /* Copy ap-start.S into low memory, along with the page
+     directory and GDT for it to load. */
+  memcpy (code, ap_start, ap_start_end - ap_start);
+  *(uint32_t *) (code + (ap_start_cr3 - ap_start)) = vtop (pd);
+  asm volatile ("sgdt (%0)"
+                : : "r" (code + (ap_start_gdtr - ap_start)) : "memory");
+
+  /* Turn on the big kernel lock.  From here on, intr_disable()
+     and intr_enable() take and release it. */
+  old_level = intr_disable ();
+  lapic_init (true);
+  cpus[0].pagedir = init_page_dir;
+  cpus[0].started = true;
+  intr_init_smp ();
+  intr_set_level (old_level);
+
+  /* Set the shutdown code in the CMOS and the warm reset vector
+     in the BIOS data area, which some processors follow after
+     INIT instead of waiting for STARTUP.  See [MP] B.4. */
+  outb (0x70, 0x0f);
+  outb (0x71, 0x0a);
+  *(uint16_t *) ptov (0x467) = 0;
+  *(uint16_t *) ptov (0x469) = AP_START >> 4;
+
+  for (i = 1; i < cpu_cnt; i++)
+    {
+      start_ap (&cpus[i]);
+      if (!cpus[i].started)
+        {
+          /* Don't start any more: a late one would share the
+             next one's stack. */
+          printf ("CPU %zu (APIC ID %d) did not start.\n",
+                  i, cpus[i].apic_id);
+          break;
+        }
+    }
+
+  /* Make a warm reset reboot normally again. */
+  outb (0x70, 0x0f);
+  outb (0x71, 0x00);
+
+  printf ("%zu CPUs running.\n", i);
+}
+
+/* Returns the CPU that the caller is running on.  Unless
+   interrupts are off, the caller may be moved to another CPU
+   right after this returns. */
+struct cpu *
+cpu_current (void)
+{
+  if (lapic == NULL)
+    return &cpus[0];
+  return &cpus[cpu_by_apic_id[lapic_read (LAPIC_ID) >> 24]];
+}
+
+/* Returns the index in cpus[] of the current CPU.  See
+   cpu_current(). */
+int
+cpu_id (void)
+{
+  return cpu_current () - cpus;
+}
+
+/* Sends interrupt VEC to CPU C. */
+void
+smp_send_ipi (struct cpu *c, uint8_t vec)
+{
+  lapic_command (c->apic_id, vec);
+}
+
+/* Called by the BSP's timer interrupt handler at each timer
+   tick, which it passes on to the other CPUs.  Idle CPUs get no
+   tick, so as to stay halted. */
+void
+smp_tick (void)
+{
+  size_t i;
+
+  for (i = 1; i < cpu_cnt; i++)
+    if (cpus[i].started && !cpus[i].idle)
+      smp_send_ipi (&cpus[i], IPI_TICK);
+}
+
+/* Invalidates the TLB entry for VPAGE on every other CPU that
+   has PD active, and waits until they all have.  Interrupts
+   must be off. */
+void
+smp_invalidate_page (uint32_t *pd, const void *vpage)
+{
+  struct cpu *self = cpu_current ();
+  size_t i;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (i = 0; i < cpu_cnt; i++)
+    {
+      struct cpu *c = &cpus[i];
+      unsigned req;
+
+      if (c == self || !c->started || c->pagedir != pd)
+        continue;
+
+      c->tlb_page = vpage;
+      req = ++c->tlb_req;
+      smp_send_ipi (c, IPI_TLB);
+      while (c->tlb_done != req)
+        smp_spin ();
+    }
+}
+
+/* Serves a TLB shootdown request made of the current CPU by
+   smp_invalidate_page(), if there is one.  Interrupts must be
+   off. */
+void
+smp_flush_tlb (void)
+{
+  struct cpu *c = cpu_current ();
+  unsigned req = c->tlb_req;
+
+  if (c->tlb_done != req)
+    {
+      asm volatile ("invlpg (%0)" : : "r" (c->tlb_page) : "memory");
+      c->tlb_done = req;
+    }
+}
+
+/* Called on each iteration of a loop in which the current CPU,
+   with interrupts off, waits for another CPU.  The other CPU
+   may in turn be waiting for this one to serve a TLB shootdown,
+   so serve it here. */
+void
+smp_spin (void)
+{
+  smp_flush_tlb ();
+  asm volatile ("pause");
+}
+
+/* Acknowledges an IPI to the local APIC. */
+void
+smp_eoi (void)
+{
+  lapic_write (LAPIC_EOI, 0);
+}
+
+/* Entry point for application processors, called by ap-start.S
+   with interrupts off and the stack at the top of the page of
+   the processor's idle thread. */
+void
+ap_main (void)
+{
+  struct cpu *c;
+
+  asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)) : "memory");
+  intr_init_ap ();
+  lapic_init (false);
+#ifdef USERPROG
+  gdt_init_ap ();
+#endif
+
+  c = cpu_current ();
+  c->pagedir = init_page_dir;
+  c->started = true;
+  thread_start_ap ();
+}
+
+/* Starts application processor C, giving it up to 100 ms to
+   come up.  See [MP] B.4 "Application Processor Startup". */
+static void
+start_ap (struct cpu *c)
+{
+  struct thread *idle = thread_create_idle (c);
+  int i;
+
+  if (idle == NULL)
+    return;
+  ap_stack = (uint8_t *) idle + PGSIZE;
+
+  lapic_command (c->apic_id, ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+  timer_udelay (200);
+  lapic_command (c->apic_id, ICR_INIT | ICR_LEVEL);
+  timer_mdelay (10);
+
+  for (i = 0; i < 2; i++)
+    {
+      lapic_command (c->apic_id, ICR_STARTUP | (AP_START >> PGBITS));
+      timer_udelay (200);
+    }
+
+  for (i = 0; i < 100 && !c->started; i++)
+    timer_mdelay (1);
+}
+
+/* Returns true if the SIZE bytes at P add up to 0 mod 256. */
+static bool
+checksum_ok (const void *p_, size_t size)
+{
+  const uint8_t *p = p_;
+  uint8_t sum = 0;
+
+  while (size-- > 0)
+    sum += *p++;
+  return sum == 0;
+}
+
+/* Returns the MP floating pointer structure in the SIZE bytes
+   of physical memory at PADDR, or a null pointer if there is
+   none. */
+static struct mp_float *
+search_mp_float (uintptr_t paddr, size_t size)
+{
+  uint8_t *p, *end;
+
+  if (paddr == 0 || paddr + size > init_ram_pages * PGSIZE)
+    return NULL;
+
+  end = (uint8_t *) ptov (paddr) + size;
+  for (p = ptov (paddr); p + sizeof (struct mp_float) <= end; p += 16)
+    if (!memcmp (p, "_MP_", 4) && checksum_ok (p, sizeof (struct mp_float)))
+      return (struct mp_float *) p;
+  return NULL;
+}
+
+/* Returns the MP configuration table, or a null pointer if
+   there is none.  The floating pointer to it is in the first KB
+   of the extended BIOS data area, the last KB of base memory, or
+   the BIOS ROM.  See [MP] 4. */
+static struct mp_config *
+find_mp_config (void)
+{
+  const uint16_t *bda = ptov (0x400);
+  struct mp_float *mp;
+  struct mp_config *config;
+
+  mp = search_mp_float ((uintptr_t) bda[0x0e / 2] << 4, 1024);
+  if (mp == NULL)
+    mp = search_mp_float (((uintptr_t) bda[0x13 / 2] - 1) * 1024, 1024);
+  if (mp == NULL)
+    mp = search_mp_float (0xf0000, 0x10000);
+  if (mp == NULL || mp->config == 0
+      || mp->config + sizeof *config > init_ram_pages * PGSIZE)
+    return NULL;
+
+  config = ptov (mp->config);
+  if (memcmp (config->signature, "PCMP", 4)
+      || !checksum_ok (config, config->length))
+    return NULL;
+  return config;
+}
+
+/* Maps the local APIC, at physical address PADDR, at
+   LAPIC_VADDR in init_page_dir.  Its registers must not be
+   cached. */
+static void
+map_lapic (uint32_t paddr)
+{
+  void *vaddr = (void *) LAPIC_VADDR;
+  uint32_t *pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+
+  ASSERT (init_page_dir[pd_no (vaddr)] == 0);
+  pt[pt_no (vaddr)] = (paddr & PTE_ADDR) | PTE_PCD | PTE_PWT | PTE_W | PTE_P;
+  init_page_dir[pd_no (vaddr)] = pde_create (pt);
+  lapic = vaddr;
+}
+
+/* Enables the current CPU's local APIC.  The BSP's takes 8259A
+   interrupts on LINT0 ("virtual wire mode", see [MP] 3.6.2.2);
+   an AP's takes none. */
+static void
+lapic_init (bool bsp)
+{
+  lapic_write (LAPIC_SVR, SVR_ENABLE | IPI_SPURIOUS);
+  lapic_write (LAPIC_LINT0, bsp ? LVT_EXTINT : LVT_MASKED);
+  lapic_write (LAPIC_LINT1, bsp ? LVT_NMI : LVT_MASKED);
+  lapic_write (LAPIC_TPR, 0);
+}
+
+/* Returns local APIC register REG. */
+static uint32_t
+lapic_read (int reg)
+{
+  return lapic[reg / 4];
+}
+
+/* Sets local APIC register REG to VALUE. */
+static void
+lapic_write (int reg, uint32_t value)
+{
+  lapic[reg / 4] = value;
+  lapic_read (LAPIC_ID);        /* Wait for the write to finish. */
+}
+
+/* Sends COMMAND to the local APIC with ID APIC_ID through the
+   interrupt command register, and waits until it is sent. */
+static void
+lapic_command (uint8_t apic_id, uint32_t command)
+{
+  /* The two halves of the command must not be split by an
+     interrupt handler that sends a command of its own. */
+  enum intr_level old_level = intr_disable ();
+
+  lapic_write (LAPIC_ICR_HI, (uint32_t) apic_id << 24);
+  lapic_write (LAPIC_ICR_LO, command);
+  while (lapic_read (LAPIC_ICR_LO) & ICR_PENDING)
+    continue;
+
+  intr_set_level (old_level);
+}
+
+/* IPI_TICK handler: a timer tick, passed on by the BSP. */
+static void
+tick_interrupt (struct intr_frame *f)
+{
+  /* A code selector with privilege level 3 is user code. */
+  thread_tick ((f->cs & 3) == 3);
+}
+
+/* IPI_RESCHEDULE handler: another CPU has made threads ready for
+   this one. */
+static void
+reschedule_interrupt (struct intr_frame *f UNUSED)
+{
+  intr_yield_on_return ();
+}
@@ -0,0 +1,60 @@
+#ifndef THREADS_SMP_H
+#define THREADS_SMP_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Most CPUs that Pintos will run on. */
+#define CPU_MAX 8
+
+/* Interrupt vectors for inter-processor interrupts (IPIs),
+   which the CPUs' local APICs deliver like external
+   interrupts. */
+#define IPI_TICK 0xf0           /* Timer tick, from the BSP. */
+#define IPI_RESCHEDULE 0xf1     /* New work in a ready list. */
+#define IPI_TLB 0xf2            /* TLB shootdown. */
+#define IPI_SPURIOUS 0xff       /* Local APIC spurious interrupt. */
+
+/* A CPU.  cpus[0] is the bootstrap processor (BSP), the one
+   that booted Pintos; the rest are application processors
+   (APs), started by smp_start().
+
+   Members are only accessed with interrupts off, except where
+   noted. */
+struct cpu
+  {
+    uint8_t apic_id;                    /* Local APIC ID. */
+    volatile bool started;              /* Running Pintos yet? */
+    struct thread *idle_thread;         /* Runs when nothing else can. */
+    bool idle;                          /* Running idle_thread now? */
+    struct list ready_list;             /* Threads ready to run here. */
+    unsigned thread_ticks;              /* # of timer ticks since last yield. */
+    bool in_external_intr;              /* Processing an external interrupt? */
+    bool yield_on_return;               /* Yield on interrupt return? */
+    uint32_t *pagedir;                  /* Active page directory. */
+
+    /* TLB shootdown requests, written by other CPUs. */
+    const void *volatile tlb_page;      /* Page to invalidate. */
+    volatile unsigned tlb_req;          /* Requests made. */
+    volatile unsigned tlb_done;         /* Requests served. */
+  };
+
+extern struct cpu cpus[CPU_MAX];
+extern size_t cpu_cnt;
+
+void smp_init (void);
+void smp_start (void);
+
+struct cpu *cpu_current (void);
+int cpu_id (void);
+
+void smp_send_ipi (struct cpu *, uint8_t vec);
+void smp_tick (void);
+void smp_invalidate_page (uint32_t *pd, const void *vpage);
+void smp_flush_tlb (void);
+void smp_spin (void);
+void smp_eoi (void);
+
+#endif /* threads/smp.h */
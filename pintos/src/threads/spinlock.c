@@ -0,0 +1,70 @@
+#include "threads/spinlock.h"
+#include <debug.h>
+#include <stddef.h>
+#include "threads/interrupt.h"
+#include "threads/smp.h"
+
+/* Initializes LOCK as released. */
+void
+spinlock_init (struct spinlock *lock) 
+{
+  ASSERT (lock != NULL);
+
+  lock->locked = 0;
+  lock->holder = NULL;
+}
+
+/* Acquires LOCK, busy-waiting until it becomes available.  The
+   lock must not already be held by the current CPU, and
+   interrupts must be off. */
+void
+spinlock_acquire (struct spinlock *lock) 
+{
+  int locked = 1;
+
+  ASSERT (lock != NULL);
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (!spinlock_held_by_current_cpu (lock));
+
+  /* XCHG is atomic with respect to other CPUs and orders the
+     loads and stores around it.  See [IA32-v2b] "XCHG" and
+     [IA32-v3a] 8.1.2 "Bus Locking".  While waiting, keep
+     answering requests from the holder, which may be waiting on
+     us in turn. */
+  for (;;) 
+    {
+      asm volatile ("xchgl %0, %1"
+                    : "+r" (locked), "+m" (lock->locked) : : "memory");
+      if (!locked)
+        break;
+      while (lock->locked)
+        smp_spin ();
+      locked = 1;
+    }
+  lock->holder = cpu_current ();
+}
+
+/* Releases LOCK, which must be held by the current CPU. */
+void
+spinlock_release (struct spinlock *lock) 
+{
+  int unlocked = 0;
+
+  ASSERT (lock != NULL);
+  ASSERT (spinlock_held_by_current_cpu (lock));
+
+  lock->holder = NULL;
+  asm volatile ("xchgl %0, %1"
+                : "+r" (unlocked), "+m" (lock->locked) : : "memory");
+}
+
+/* Returns true if the current CPU holds LOCK, false otherwise.
+   Interrupts must be off, or the answer may be out of date by
+   the time the caller sees it. */
+bool
+spinlock_held_by_current_cpu (const struct spinlock *lock) 
+{
+  ASSERT (lock != NULL);
+
+  return lock->locked && lock->holder == cpu_current ();
+}
@@ -0,0 +1,24 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <stdbool.h>
+
+/* Spin lock, for mutual exclusion between CPUs.
+
+   Unlike a `struct lock', a spin lock never sleeps: a CPU that
+   finds it held busy-waits until the holder releases it.  It is
+   held by a CPU, not a thread, and may only be acquired and
+   released with interrupts off, so that the holder cannot be
+   preempted in between. */
+struct spinlock 
+  {
+    volatile int locked;        /* Nonzero while held. */
+    struct cpu *holder;         /* CPU holding the lock. */
+  };
+
+void spinlock_init (struct spinlock *);
+void spinlock_acquire (struct spinlock *);
+void spinlock_release (struct spinlock *);
+bool spinlock_held_by_current_cpu (const struct spinlock *);
+
+#endif /* threads/spinlock.h */
@@ -1,5 +1,6 @@
 #include "threads/thread.h"
 #include <debug.h>
+#include <kstats.h>
 #include <stddef.h>
 #include <random.h>
 #include <stdio.h>
@@ -10,11 +11,14 @@
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/smp.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "filesys/buffer_cache.h"
 #ifdef USERPROG
+#include "userprog/fdtable.h"
 #include "userprog/process.h"
 #endif
 
@@ -23,16 +27,16 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running, are in the ready_list
+   of a CPU, normally the one each last ran on.  A CPU with an
+   empty ready list steals from the longest one.  Each CPU also
+   has its own idle thread.  See struct cpu in smp.h. */
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
 static struct list all_list;
 static struct list sleep_list;
-/* Idle thread. */
-static struct thread *idle_thread;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
@@ -55,7 +59,6 @@ static long long user_ticks;    /* # of timer ticks in user programs. */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 static unsigned global_tick;
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
@@ -65,14 +68,19 @@ list_less_func less;
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
+static void idle_loop (void) NO_RETURN;
+static bool others_idle (void);
 static struct thread *running_thread (void);
 static struct thread *next_thread_to_run (void);
+static void ready_push (struct thread *);
+static void kick (struct cpu *);
 static void init_thread (struct thread *, const char *name, int priority);
 static bool is_thread (struct thread *) UNUSED;
 static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static void rusage_add_child (struct thread *parent, struct thread *child);
 
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
@@ -90,11 +98,14 @@ static tid_t allocate_tid (void);
 void
 thread_init (void) 
 {
+  size_t i;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
    list_init (&sleep_list);
-  list_init (&ready_list);
+  for (i = 0; i < CPU_MAX; i++)
+    list_init (&cpus[i].ready_list);
   list_init (&all_list);
 
   /* Set up a thread structure for the running thread. */
@@ -122,15 +133,17 @@ thread_start (void)
   sema_down (&idle_started);
 }
 
-/* Called by the timer interrupt handler at each timer tick.
+/* Called by the timer interrupt handler at each timer tick,
+   with USER true if the tick interrupted user code.
    Thus, this function runs in an external interrupt context. */
 void
-thread_tick (void) 
+thread_tick (bool user) 
 {
   struct thread *t = thread_current ();
+  struct cpu *c = cpu_current ();
 
   /* Update statistics. */
-  if (t == idle_thread)
+  if (t == c->idle_thread)
     idle_ticks++;
 #ifdef USERPROG
   else if (t->pagedir != NULL)
@@ -138,9 +151,13 @@ thread_tick (void)
 #endif
   else
     kernel_ticks++;
+  if (user)
+    t->ru.user_ticks++;
+  else if (t != c->idle_thread)
+    t->ru.kernel_ticks++;
 
   /* Enforce preemption. */
-  if (++thread_ticks >= TIME_SLICE)
+  if (++c->thread_ticks >= TIME_SLICE)
     intr_yield_on_return ();
 }
 
@@ -152,6 +169,46 @@ thread_print_stats (void)
           idle_ticks, kernel_ticks, user_ticks);
 }
 
+/* Copies the tick counters into ST. */
+void
+thread_get_stats (struct kstats *st) 
+{
+  enum intr_level old_level = intr_disable ();
+  st->ticks = timer_ticks ();
+  st->idle_ticks = idle_ticks;
+  st->kernel_ticks = kernel_ticks;
+  st->user_ticks = user_ticks;
+  st->thread_ticks = (thread_current ()->ru.user_ticks
+                      + thread_current ()->ru.kernel_ticks);
+  intr_set_level (old_level);
+}
+
+/* Adds the resource use of CHILD, which is exiting, and of its
+   own exited children to PARENT's child_ru. */
+static void
+rusage_add_child (struct thread *parent, struct thread *child) 
+{
+  const struct rusage *srcs[] = {&child->ru, &child->child_ru};
+  struct rusage *sum = &parent->child_ru;
+  enum intr_level old_level;
+  size_t i;
+
+  old_level = intr_disable ();
+  for (i = 0; i < sizeof srcs / sizeof *srcs; i++)
+    {
+      sum->user_ticks += srcs[i]->user_ticks;
+      sum->kernel_ticks += srcs[i]->kernel_ticks;
+      sum->minor_faults += srcs[i]->minor_faults;
+      sum->major_faults += srcs[i]->major_faults;
+      sum->swap_ins += srcs[i]->swap_ins;
+      sum->blocks_read += srcs[i]->blocks_read;
+      sum->blocks_written += srcs[i]->blocks_written;
+      sum->voluntary_switches += srcs[i]->voluntary_switches;
+      sum->involuntary_switches += srcs[i]->involuntary_switches;
+    }
+  intr_set_level (old_level);
+}
+
 /* Creates a new kernel thread named NAME with the given initial
    PRIORITY, which executes FUNCTION passing AUX as the argument,
    and adds it to the ready queue.  Returns the thread identifier
@@ -208,8 +265,10 @@ thread_create (const char *name, int priority,
   sf->ebp = 0;
 
 
-  t->fdt = (struct file **) malloc(sizeof (struct file *) * 1000);
-  t->next_fd = 2;
+#ifdef USERPROG
+  fd_table_init (&t->fdt);
+  fd_table_inherit (&t->fdt, &thread_current ()->fdt);
+#endif
   
   if(strcmp(t->name,"idle"))
   list_push_back(&thread_current()->child_list,&t->child_elem);
@@ -233,12 +292,14 @@ thread_sleep (int64_t ticks_to_wakeup)
     ASSERT(!intr_context());
 
     old_level = intr_disable();
-    if (cur != idle_thread)
+    if (cur != cpu_current ()->idle_thread)
     {  
         save_global_tick (ticks_to_wakeup);
         cur->status = THREAD_BLOCKED;
         cur->wakeup_tick = ticks_to_wakeup;
         list_push_back (&sleep_list, &cur->elem);  
+        /* The BSP's timer may be idling until a later wakeup. */
+        kick (&cpus[0]);
     }
     schedule ();
     intr_set_level (old_level);
@@ -275,7 +336,7 @@ thread_wakeup (int64_t cur_ticks)
         checking_thread_elem->next->prev = checking_thread_elem->prev;
         checking_thread_elem = checking_thread_elem->prev; 
         checking_thread->status = THREAD_READY;
-        list_push_back (&ready_list, &checking_thread->elem);
+        ready_push (checking_thread);
       }
       else
         save_global_tick (checking_thread->wakeup_tick);
@@ -316,9 +377,8 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
-  list_push_back (&ready_list, &t->elem);
-  list_sort(&ready_list, less, NULL);
   t->status = THREAD_READY;
+  ready_push (t);
   intr_set_level (old_level);
 }
 
@@ -365,29 +425,32 @@ thread_exit (void)
   struct thread *t;
   struct list_elem *e;
   struct list *l =&thread_current()->child_sema.waiters;
+#ifdef USERPROG
+  process_exit ();
+#endif
+  /* Tear down first, so that the parent does not see us exit
+     until the I/O and page faults that takes are in its
+     RUSAGE_CHILDREN totals. */
+#ifdef USERPROG
+  fd_table_destroy (&thread_current ()->fdt);
+#endif
     for (e = list_begin (&all_list); e != list_end (&all_list);
        e = list_next (e))
     {
 
       t = list_entry (e, struct thread, allelem);
       if(t->tid == thread_current()->father_tid){
+      rusage_add_child (t, thread_current ());
       t->pdt[t->next_pd] = thread_current()->tid;
       t->est[t->next_pd++] = thread_current()->exit_status; 
       sema_up(&thread_current()->child_sema);
       break;
       }
     }  
-#ifdef USERPROG
-  process_exit ();
-#endif
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
      when it calls thread_schedule_tail(). */
   intr_disable ();
-  int i;
-  for(i=2;i<thread_current()->next_fd;i++)
-  file_close(thread_current()->fdt[i]);
-  free(thread_current()->fdt);
   free(thread_current()->pdt);
   free(thread_current()->est);
   list_remove (&thread_current()->child_elem);
@@ -408,10 +471,9 @@ thread_yield (void)
   ASSERT (!intr_context ());
 
   old_level = intr_disable ();
-  if (cur != idle_thread) 
-    list_push_back (&ready_list, &cur->elem);
+  if (cur != cpu_current ()->idle_thread) 
+    list_insert_ordered (&cur->cpu->ready_list, &cur->elem, less, NULL);
   cur->status = THREAD_READY;
-  list_sort(&ready_list, less, NULL);
   schedule ();
   intr_set_level (old_level);
 }
@@ -486,42 +548,101 @@ thread_get_recent_cpu (void)
 
 /* Idle thread.  Executes when no other thread is ready to run.
 
-   The idle thread is initially put on the ready list by
+   The BSP's idle thread is initially put on the ready list by
    thread_start().  It will be scheduled once initially, at which
-   point it initializes idle_thread, "up"s the semaphore passed
-   to it to enable thread_start() to continue, and immediately
-   blocks.  After that, the idle thread never appears in the
-   ready list.  It is returned by next_thread_to_run() as a
-   special case when the ready list is empty. */
+   point it records itself as the BSP's idle thread, "up"s the
+   semaphore passed to it to enable thread_start() to continue,
+   and immediately blocks.  After that, the idle thread never
+   appears in the ready list.  It is returned by
+   next_thread_to_run() as a special case when there is nothing
+   else to run.  An AP's idle thread is made by
+   thread_create_idle() instead. */
 static void
 idle (void *idle_started_ UNUSED) 
 {
   struct semaphore *idle_started = idle_started_;
-  idle_thread = thread_current ();
+  cpu_current ()->idle_thread = thread_current ();
   sema_up (idle_started);
 
+  idle_loop ();
+}
+
+/* Creates the idle thread of application processor C, whose
+   stack ap_main() starts out on, and returns it.  Returns a null
+   pointer if memory is short. */
+struct thread *
+thread_create_idle (struct cpu *c) 
+{
+  struct thread *t = palloc_get_page (PAL_ZERO);
+  if (t == NULL)
+    return NULL;
+
+  init_thread (t, "idle", PRI_MIN);
+  t->tid = allocate_tid ();
+  t->status = THREAD_RUNNING;
+  t->cpu = c;
+  c->idle_thread = t;
+  c->idle = true;
+  return t;
+}
+
+/* Runs the idle thread of an application processor, as the
+   last step in ap_main(). */
+void
+thread_start_ap (void) 
+{
+  idle_loop ();
+}
+
+/* Body of every CPU's idle thread. */
+static void
+idle_loop (void) 
+{
+  struct cpu *c = cpu_current ();
+  bool bsp = c == &cpus[0];
+
   for (;;) 
     {
+      bool stretch;
+
       /* Let someone else run. */
       intr_disable ();
       thread_block ();
 
       /* Re-enable interrupts and wait for the next one.
 
-         The `sti' instruction disables interrupts until the
-         completion of the next instruction, so these two
-         instructions are executed atomically.  This atomicity is
-         important; otherwise, an interrupt could be handled
-         between re-enabling interrupts and waiting for the next
-         one to occur, wasting as much as one clock tick worth of
-         time.
-
-         See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-         7.11.1 "HLT Instruction". */
-      asm volatile ("sti; hlt" : : : "memory");
+         In between, let the timer sleep through ticks until the
+         next wakeup, since nothing can run before then.  The
+         timer interrupts only the BSP, which passes ticks on to
+         the other CPUs, so it may only do so while they are
+         idle too. */
+      stretch = bsp && others_idle ();
+      if (stretch)
+        timer_idle_enter ();
+      intr_wait ();
+      if (bsp)
+        timer_idle_exit ();
     }
 }
 
+/* Returns true if every CPU other than the current one is idle
+   with nothing ready to run.  Interrupts must be off. */
+static bool
+others_idle (void) 
+{
+  struct cpu *self = cpu_current ();
+  size_t i;
+
+  for (i = 0; i < cpu_cnt; i++)
+    {
+      struct cpu *c = &cpus[i];
+      if (c != self && c->started
+          && (!c->idle || !list_empty (&c->ready_list)))
+        return false;
+    }
+  return true;
+}
+
 /* Function used as the basis for a kernel thread. */
 static void
 kernel_thread (thread_func *function, void *aux) 
@@ -570,11 +691,13 @@ init_thread (struct thread *t, const char *name, int priority)
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
+  t->cpu = cpu_current ();
   t->magic = THREAD_MAGIC;
   sema_init(&t->child_sema, 0);
   sema_init(&t->sema_exec, 0);
   list_init(&t->child_list);
   list_init(&t->mmap_list);
+  list_init(&t->shm_list);
   t->exit_status = -1;
   t->load_status = 0;
   t->deny_write = 0;
@@ -600,17 +723,73 @@ alloc_frame (struct thread *t, size_t size)
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
-   return a thread from the run queue, unless the run queue is
-   empty.  (If the running thread can continue running, then it
-   will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   return a thread from the current CPU's run queue, unless the
+   run queue is empty.  (If the running thread can continue
+   running, then it will be in the run queue.)  If the run queue
+   is empty, steal the first thread from the longest run queue of
+   another CPU, and if they are all empty, return the CPU's idle
+   thread. */
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list))
-    return idle_thread;
+  struct cpu *self = cpu_current ();
+  struct list *ready_list = &self->ready_list;
+
+  if (list_empty (ready_list))
+    {
+      size_t longest = 0;
+      size_t i;
+
+      for (i = 0; i < cpu_cnt; i++)
+        {
+          size_t size = list_size (&cpus[i].ready_list);
+          if (size > longest)
+            {
+              longest = size;
+              ready_list = &cpus[i].ready_list;
+            }
+        }
+      if (longest == 0)
+        return self->idle_thread;
+    }
+  return list_entry (list_pop_front (ready_list), struct thread, elem);
+}
+
+/* Adds T, which is ready, to the ready list of its CPU, and
+   makes sure that some CPU picks it up soon: T's CPU, if that
+   is idle, or else any idle CPU, which will steal it.
+   Interrupts must be off. */
+static void
+ready_push (struct thread *t) 
+{
+  struct cpu *c = t->cpu;
+  size_t i;
+
+  list_insert_ordered (&c->ready_list, &t->elem, less, NULL);
+  if (c->idle || cpu_current ()->idle)
+    kick (c);
   else
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+    for (i = 0; i < cpu_cnt; i++)
+      if (cpus[i].started && cpus[i].idle)
+        {
+          kick (&cpus[i]);
+          break;
+        }
+}
+
+/* Sends C a reschedule IPI, if it is another CPU that is idle.
+   Waking an AP also wakes the BSP, whose timer may be idling
+   through ticks that the AP now needs.  Interrupts must be
+   off. */
+static void
+kick (struct cpu *c) 
+{
+  if (c != cpu_current () && c->started && c->idle)
+    {
+      smp_send_ipi (c, IPI_RESCHEDULE);
+      if (c != &cpus[0])
+        kick (&cpus[0]);
+    }
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -633,14 +812,17 @@ void
 thread_schedule_tail (struct thread *prev)
 {
   struct thread *cur = running_thread ();
+  struct cpu *c = cpu_current ();
   
   ASSERT (intr_get_level () == INTR_OFF);
 
-  /* Mark us as running. */
+  /* Mark us as running, here from now on. */
   cur->status = THREAD_RUNNING;
+  cur->cpu = c;
+  c->idle = cur == c->idle_thread;
 
   /* Start new time slice. */
-  thread_ticks = 0;
+  c->thread_ticks = 0;
 
 #ifdef USERPROG
   /* Activate the new address space. */
@@ -678,7 +860,15 @@ schedule (void)
   ASSERT (is_thread (next));
 
   if (cur != next)
-    prev = switch_threads (cur, next);
+    {
+      /* A thread that blocked gave up the CPU; one that is still
+         ready lost it. */
+      if (cur->status == THREAD_BLOCKED)
+        cur->ru.voluntary_switches++;
+      else if (cur->status == THREAD_READY)
+        cur->ru.involuntary_switches++;
+      prev = switch_threads (cur, next);
+    }
   thread_schedule_tail (prev);
 }
 
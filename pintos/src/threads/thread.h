@@ -3,9 +3,13 @@
 
 #include <debug.h>
 #include <list.h>
+#include <rusage.h>
 #include <stdint.h>
 #include "synch.h"
 #include "../lib/kernel/hash.h"
+#ifdef USERPROG
+#include "userprog/fdtable.h"
+#endif
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -90,8 +94,11 @@ struct thread
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
     int priority;                       /* Priority. */
+    struct cpu *cpu;                    /* CPU whose ready list to use. */
     struct list_elem allelem;           /* List element for all threads list. */
     int64_t wakeup_tick;
+    struct rusage ru;                   /* Resource use, for getrusage(). */
+    struct rusage child_ru;             /* Exited children's, summed. */
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
 
@@ -104,11 +111,12 @@ struct thread
     tid_t child_tid;  //tid of father(parent)
     tid_t father_tid;
     struct semaphore sema_exec;  //parent waits child finishing execution
-    struct file **fdt;  //file descriptor table
+    struct fd_table fdt;                /* File descriptor table. */
+    struct aio_ctx *aio;                /* Asynchronous I/O, if set up. */
+    int tty_mode;                       /* Console input mode, TTY_*. */
     struct file *running_file;  //for rox
     int *pdt, *est;  //process descriptor table. exit status table
     int next_pd;  // current end position of process descriptor table
-    int next_fd;  // same for file descriptor table
     int exit_status; 
     int load_status;
     bool deny_write;
@@ -118,7 +126,11 @@ struct thread
     struct hash vm;  
     struct list mmap_list;
     int mapping_id;
+    struct list shm_list;               /* Shared memory mappings. */
+    void *heap_start;                   /* Start of the sbrk() heap. */
+    void *brk;                          /* End of the sbrk() heap. */
     void * syscall_esp;
+    bool user_access;                   /* In get_user()/put_user()? */
     struct dir *dir;
 
     /* Owned by thread.c. */
@@ -132,9 +144,14 @@ extern bool thread_mlfqs;
 
 void thread_init (void);
 void thread_start (void);
+struct cpu;
+struct thread *thread_create_idle (struct cpu *);
+void thread_start_ap (void) NO_RETURN;
 
-void thread_tick (void);
+void thread_tick (bool user);
 void thread_print_stats (void);
+struct kstats;
+void thread_get_stats (struct kstats *);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
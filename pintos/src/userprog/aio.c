@@ -0,0 +1,389 @@
+#include "userprog/aio.h"
+#include <debug.h>
+#include <list.h>
+#include <stdio.h>
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "filesys/journal.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/fdtable.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/page.h"
+
+/* Asynchronous I/O.
+
+   A process maps a struct aio_ring with aio_setup(), fills in
+   requests, and hands them to the kernel with aio_enter().
+   Requests are queued for a pool of kernel worker threads, which
+   do the file system work while the process keeps running.
+
+   Workers are kernel threads with no access to the process's
+   memory, so the data passes through a kernel buffer: a write's
+   data is copied in when it is submitted, and a read's data is
+   copied out, and its completion added to the ring, by the next
+   aio_enter() after the worker finishes.  A process waits for
+   completions inside aio_enter().
+
+   The file system itself is serialized by filesys_lock, so only
+   one request is on the disk at a time.  The gain is that the
+   process computes while its I/O is done, and that a request
+   can wait for the lock and the disk without holding up the
+   next submission. */
+
+/* Number of worker threads. */
+#define AIO_WORKER_CNT 2
+
+/* A process's asynchronous I/O state. */
+struct aio_ctx
+  {
+    struct aio_ring *ring;      /* Kernel address of the ring page. */
+    void *upage;                /* User address of the ring page. */
+    int inflight;               /* Submitted but not yet completed. */
+    size_t buffered;            /* Bytes of BUF in requests in flight. */
+
+    /* Shared with workers. */
+    struct lock lock;           /* Protects the members below. */
+    struct condition done_cond; /* Signaled when DONE gets a request. */
+    struct list done;           /* Finished, waiting to be posted. */
+    int pending;                /* Queued or being worked on. */
+  };
+
+/* One request. */
+struct aio_req
+  {
+    struct aio_ctx *ctx;        /* Owning process's state. */
+    struct aio_sqe sqe;         /* Copy of the submission. */
+    struct file *file;          /* Reference to SQE.FD's file. */
+    void *buf;                  /* Kernel copy of the data. */
+    int res;                    /* Result for the completion. */
+    struct list_elem elem;      /* In the queue or CTX's DONE list. */
+  };
+
+/* Requests waiting for a worker. */
+static struct list queue;
+static struct lock queue_lock;
+static struct condition queue_cond;
+
+static thread_func worker NO_RETURN;
+
+/* Initializes asynchronous I/O and starts the worker threads. */
+void
+aio_init (void) 
+{
+  int i;
+
+  list_init (&queue);
+  lock_init (&queue_lock);
+  cond_init (&queue_cond);
+  for (i = 0; i < AIO_WORKER_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "aio%d", i);
+      thread_create (name, PRI_DEFAULT, worker, NULL);
+    }
+}
+
+/* Moves REQ to its process's DONE list and wakes the process. */
+static void
+complete (struct aio_req *req) 
+{
+  struct aio_ctx *ctx = req->ctx;
+
+  lock_acquire (&ctx->lock);
+  list_push_back (&ctx->done, &req->elem);
+  ctx->pending--;
+  cond_signal (&ctx->done_cond, &ctx->lock);
+  lock_release (&ctx->lock);
+}
+
+/* Worker thread: carries out queued requests, one at a time. */
+static void
+worker (void *aux UNUSED) 
+{
+  for (;;)
+    {
+      struct aio_req *req;
+
+      lock_acquire (&queue_lock);
+      while (list_empty (&queue))
+        cond_wait (&queue_cond, &queue_lock);
+      req = list_entry (list_pop_front (&queue), struct aio_req, elem);
+      lock_release (&queue_lock);
+
+      lock_acquire (&filesys_lock);
+      switch (req->sqe.opcode)
+        {
+        case AIO_READ:
+          req->res = file_read_at (req->file, req->buf, req->sqe.len,
+                                   req->sqe.offset);
+          break;
+        case AIO_WRITE:
+          req->res = file_write_at (req->file, req->buf, req->sqe.len,
+                                    req->sqe.offset);
+          break;
+        case AIO_FSYNC:
+          journal_commit ();
+          req->res = 0;
+          break;
+        default:
+          NOT_REACHED ();
+        }
+      lock_release (&filesys_lock);
+
+      complete (req);
+    }
+}
+
+/* Maps a zeroed struct aio_ring into the current process at
+   ADDR, which must be page-aligned and not in use, and returns
+   ADDR.  Returns a null pointer if ADDR is bad, the process
+   already has a ring, or memory is exhausted. */
+struct aio_ring *
+aio_setup (void *addr) 
+{
+  struct thread *t = thread_current ();
+  struct aio_ctx *ctx;
+  struct vm_entry *vme;
+
+  if (t->aio != NULL || addr == NULL || pg_ofs (addr) != 0
+      || !is_user_vaddr (addr) || pagedir_get_page (t->pagedir, addr) != NULL)
+    return NULL;
+
+  ctx = calloc (1, sizeof *ctx);
+  vme = malloc (sizeof *vme);
+  if (ctx == NULL || vme == NULL)
+    goto error;
+  ctx->ring = palloc_get_page (PAL_USER | PAL_ZERO);
+  if (ctx->ring == NULL)
+    goto error;
+
+  /* The ring page is always present, like a shared memory
+     page, so it never faults and is never evicted. */
+  vme->type = VM_SHM;
+  vme->vaddr = addr;
+  vme->writable = true;
+  vme->is_loaded = true;
+  vme->file = NULL;
+  if (!insert_vme (&t->vm, vme))
+    goto error;
+  if (!pagedir_set_page (t->pagedir, addr, ctx->ring, true))
+    {
+      delete_vme (&t->vm, vme);
+      vme = NULL;
+      goto error;
+    }
+
+  ctx->upage = addr;
+  ctx->inflight = 0;
+  ctx->buffered = 0;
+  lock_init (&ctx->lock);
+  cond_init (&ctx->done_cond);
+  list_init (&ctx->done);
+  ctx->pending = 0;
+  t->aio = ctx;
+  return addr;
+
+ error:
+  if (ctx != NULL && ctx->ring != NULL)
+    palloc_free_page (ctx->ring);
+  free (vme);
+  free (ctx);
+  return NULL;
+}
+
+/* Releases REQ's file and buffer, and REQ itself. */
+static void
+free_req (struct aio_req *req) 
+{
+  if (req->buf != NULL)
+    req->ctx->buffered -= req->sqe.len;
+  if (req->file != NULL)
+    {
+      lock_acquire (&filesys_lock);
+      file_close (req->file);
+      lock_release (&filesys_lock);
+    }
+  free (req->buf);
+  free (req);
+}
+
+/* Prepares REQ, whose SQE is filled in, to be carried out for
+   the current process.  Returns false if the request is bad or
+   its data would take the process's buffered bytes past
+   AIO_MAX_BUFFERED. */
+static bool
+prepare (struct aio_req *req) 
+{
+  const struct aio_sqe *sqe = &req->sqe;
+  struct aio_ctx *ctx = req->ctx;
+  struct file *file = fd_lookup (&thread_current ()->fdt, sqe->fd);
+
+  if (file == NULL || file_is_pipe (file))
+    return false;
+  switch (sqe->opcode)
+    {
+    case AIO_READ:
+    case AIO_WRITE:
+      if (sqe->len > AIO_MAX_LEN
+          || sqe->len > AIO_MAX_BUFFERED - ctx->buffered)
+        return false;
+      if (sqe->opcode == AIO_WRITE
+          && inode_is_dir (file_get_inode (file)))
+        return false;
+      if (sqe->len > 0)
+        {
+          req->buf = malloc (sqe->len);
+          if (req->buf == NULL)
+            return false;
+          ctx->buffered += sqe->len;
+        }
+      if (sqe->opcode == AIO_WRITE
+          && !copy_in (req->buf, sqe->buf, sqe->len))
+        return false;
+      break;
+    case AIO_FSYNC:
+      break;
+    default:
+      return false;
+    }
+  req->file = file_dup (file);
+  return true;
+}
+
+/* Adds completions for CTX's finished requests to its ring, as
+   long as there is room, copying read data out to the process.
+   Returns the number added. */
+static int
+post_completions (struct aio_ctx *ctx) 
+{
+  struct aio_ring *ring = ctx->ring;
+  int cnt = 0;
+
+  while (ring->cq_tail - ring->cq_head < AIO_ENTRIES)
+    {
+      struct aio_req *req;
+      struct aio_cqe *cqe;
+
+      lock_acquire (&ctx->lock);
+      req = (!list_empty (&ctx->done)
+             ? list_entry (list_pop_front (&ctx->done), struct aio_req, elem)
+             : NULL);
+      lock_release (&ctx->lock);
+      if (req == NULL)
+        break;
+
+      if (req->sqe.opcode == AIO_READ && req->res > 0
+          && !copy_out (req->sqe.buf, req->buf, req->res))
+        req->res = -1;
+      cqe = &ring->cq[ring->cq_tail % AIO_ENTRIES];
+      cqe->user_data = req->sqe.user_data;
+      cqe->res = req->res;
+      ring->cq_tail++;
+      ctx->inflight--;
+      free_req (req);
+      cnt++;
+    }
+  return cnt;
+}
+
+/* Submits up to TO_SUBMIT requests from the current process's
+   submission queue, then waits until its completion queue holds
+   at least MIN_COMPLETE entries or nothing is left in flight.
+   A bad request is not an error here: it completes at once with
+   a result of -1, as does one whose data does not fit in
+   AIO_MAX_BUFFERED.  No more than AIO_ENTRIES requests are in
+   flight at once; requests past that stay in the queue.  Returns
+   the number of requests submitted, or -1 if the process has no
+   ring. */
+int
+aio_enter (unsigned to_submit, unsigned min_complete) 
+{
+  struct aio_ctx *ctx = thread_current ()->aio;
+  struct aio_ring *ring;
+  unsigned submitted = 0;
+
+  if (ctx == NULL)
+    return -1;
+  ring = ctx->ring;
+  if (min_complete > AIO_ENTRIES)
+    min_complete = AIO_ENTRIES;
+
+  post_completions (ctx);
+  while (submitted < to_submit && ring->sq_head != ring->sq_tail
+         && ctx->inflight < AIO_ENTRIES)
+    {
+      struct aio_req *req = calloc (1, sizeof *req);
+
+      if (req == NULL)
+        break;
+      req->ctx = ctx;
+      req->sqe = ring->sq[ring->sq_head % AIO_ENTRIES];
+      ring->sq_head++;
+      submitted++;
+      ctx->inflight++;
+
+      if (prepare (req))
+        {
+          lock_acquire (&ctx->lock);
+          ctx->pending++;
+          lock_release (&ctx->lock);
+
+          lock_acquire (&queue_lock);
+          list_push_back (&queue, &req->elem);
+          cond_signal (&queue_cond, &queue_lock);
+          lock_release (&queue_lock);
+        }
+      else
+        {
+          req->res = -1;
+          lock_acquire (&ctx->lock);
+          list_push_back (&ctx->done, &req->elem);
+          lock_release (&ctx->lock);
+        }
+    }
+
+  for (;;)
+    {
+      post_completions (ctx);
+      if (ring->cq_tail - ring->cq_head >= min_complete
+          || ctx->inflight == 0)
+        break;
+
+      lock_acquire (&ctx->lock);
+      while (list_empty (&ctx->done))
+        cond_wait (&ctx->done_cond, &ctx->lock);
+      lock_release (&ctx->lock);
+    }
+  return submitted;
+}
+
+/* Waits for the current process's requests in flight, discards
+   their results, and unmaps and frees its ring.  Must be called
+   before the process's page directory is destroyed. */
+void
+aio_exit (void) 
+{
+  struct thread *t = thread_current ();
+  struct aio_ctx *ctx = t->aio;
+
+  if (ctx == NULL)
+    return;
+
+  lock_acquire (&ctx->lock);
+  while (ctx->pending > 0)
+    cond_wait (&ctx->done_cond, &ctx->lock);
+  lock_release (&ctx->lock);
+  while (!list_empty (&ctx->done))
+    free_req (list_entry (list_pop_front (&ctx->done), struct aio_req, elem));
+
+  pagedir_clear_page (t->pagedir, ctx->upage);
+  delete_vme (&t->vm, find_vme (ctx->upage));
+  palloc_free_page (ctx->ring);
+  free (ctx);
+  t->aio = NULL;
+}
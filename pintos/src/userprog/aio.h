@@ -0,0 +1,11 @@
+#ifndef USERPROG_AIO_H
+#define USERPROG_AIO_H
+
+#include <aio.h>
+
+void aio_init (void);
+struct aio_ring *aio_setup (void *addr);
+int aio_enter (unsigned to_submit, unsigned min_complete);
+void aio_exit (void);
+
+#endif /* userprog/aio.h */
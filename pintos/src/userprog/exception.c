@@ -150,21 +150,23 @@ page_fault (struct intr_frame *f)
   user = (f->error_code & PF_U) != 0;
   //printf("fault addr: %x and esp addr : %x, tid:%d\n", fault_addr, f->esp, thread_tid());
   struct vm_entry *vme = find_vme(fault_addr); 
-  if(vme == NULL){ 
-    // printf("stack alloc need\n");
-  if(verify_stack(fault_addr,f->esp)){
-   expand_stack(fault_addr);
-     vme = find_vme(fault_addr);
-     if(vme == NULL)
-     exit(-1);
-  }
-  else   {
-     //printf("stack alloc failed..\n");
-  exit(-1);
+  if(vme == NULL && verify_stack(fault_addr,f->esp)){
+    expand_stack(fault_addr);
+    vme = find_vme(fault_addr);
   }
+  else if(vme == NULL && is_heap_vaddr(fault_addr) && expand_heap(fault_addr))
+    vme = find_vme(fault_addr);
+  if(vme != NULL && handle_mm_fault(vme))
+    return;
+
+  /* A fault taken inside get_user() or put_user() (see
+     userprog/syscall.c) resumes at the address they left in
+     %eax, with -1 in %eax to report the failure. */
+  if(!user && thread_current()->user_access){
+    f->eip = (void (*) (void)) f->eax;
+    f->eax = 0xffffffff;
+    return;
   }
-  
-  if(!handle_mm_fault(vme))
   exit(-1);
 
    /* To implement virtual memory, delete the rest of the function
@@ -0,0 +1,177 @@
+#include "userprog/fdtable.h"
+#include <bitmap.h>
+#include <debug.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+
+/* Initial number of elements in a table's FILES array. */
+#define FD_INITIAL_SIZE 16
+
+/* Initializes FDT as an empty table.  Nothing is allocated until
+   the first descriptor is. */
+void
+fd_table_init (struct fd_table *fdt) 
+{
+  fdt->files = NULL;
+  fdt->size = 0;
+  fdt->used = NULL;
+  fdt->first_free = FD_MIN;
+  fdt->cloexec = NULL;
+}
+
+/* Closes every file open in FDT and frees its memory. */
+void
+fd_table_destroy (struct fd_table *fdt) 
+{
+  size_t fd;
+
+  for (fd = FD_MIN; fd < fdt->size; fd++)
+    file_close (fdt->files[fd]);
+  free (fdt->files);
+  if (fdt->used != NULL)
+    bitmap_destroy (fdt->used);
+  if (fdt->cloexec != NULL)
+    bitmap_destroy (fdt->cloexec);
+  fd_table_init (fdt);
+}
+
+/* Gives FDT, a new process's empty table, its own reference to
+   each pipe end open in PARENT, under the same descriptor, so
+   that a process can talk to the children it starts.  Ends
+   marked close-on-exec and other files are not inherited.  An
+   end that cannot be reopened for lack of memory is left out. */
+void
+fd_table_inherit (struct fd_table *fdt, const struct fd_table *parent) 
+{
+  size_t fd;
+
+  for (fd = FD_MIN; fd < parent->size; fd++)
+    {
+      struct file *file = parent->files[fd];
+
+      if (file != NULL && file_is_pipe (file)
+          && !bitmap_test (parent->cloexec, fd))
+        {
+          struct file *copy = file_reopen (file);
+          if (copy != NULL && !fd_install (fdt, fd, copy))
+            file_close (copy);
+        }
+    }
+}
+
+/* Makes FDT's FILES array large enough to hold descriptor FD,
+   which must be less than FD_MAX, allocating the bitmaps on
+   first use.  Returns false if memory is exhausted. */
+static bool
+reserve (struct fd_table *fdt, size_t fd) 
+{
+  if (fdt->used == NULL)
+    {
+      fdt->used = bitmap_create (FD_MAX);
+      if (fdt->used == NULL)
+        return false;
+    }
+  if (fdt->cloexec == NULL)
+    {
+      fdt->cloexec = bitmap_create (FD_MAX);
+      if (fdt->cloexec == NULL)
+        return false;
+    }
+  if (fd >= fdt->size)
+    {
+      size_t new_size = fdt->size > 0 ? fdt->size : FD_INITIAL_SIZE;
+      struct file **new_files;
+      size_t i;
+
+      while (new_size <= fd)
+        new_size *= 2;
+      if (new_size > FD_MAX)
+        new_size = FD_MAX;
+      new_files = realloc (fdt->files, new_size * sizeof *new_files);
+      if (new_files == NULL)
+        return false;
+      for (i = fdt->size; i < new_size; i++)
+        new_files[i] = NULL;
+      fdt->files = new_files;
+      fdt->size = new_size;
+    }
+  return true;
+}
+
+/* Stores FILE in FDT under the lowest free descriptor and
+   returns it, or returns -1 if the table is full or memory is
+   exhausted. */
+int
+fd_alloc (struct fd_table *fdt, struct file *file) 
+{
+  size_t fd;
+
+  if (!reserve (fdt, FD_MIN))
+    return -1;
+  fd = bitmap_scan (fdt->used, fdt->first_free, 1, false);
+  if (fd == BITMAP_ERROR || !reserve (fdt, fd))
+    return -1;
+  bitmap_mark (fdt->used, fd);
+  fdt->files[fd] = file;
+  fdt->first_free = fd + 1;
+  return fd;
+}
+
+/* Stores FILE in FDT under descriptor FD, which must be free.
+   Returns false if FD is out of range or memory is exhausted. */
+bool
+fd_install (struct fd_table *fdt, int fd, struct file *file) 
+{
+  if (fd < FD_MIN || fd >= FD_MAX || !reserve (fdt, fd))
+    return false;
+  ASSERT (!bitmap_test (fdt->used, fd));
+  bitmap_mark (fdt->used, fd);
+  fdt->files[fd] = file;
+  return true;
+}
+
+/* Returns the file open as FD in FDT, or a null pointer if FD
+   is not open. */
+struct file *
+fd_lookup (const struct fd_table *fdt, int fd) 
+{
+  if (fd < FD_MIN || (size_t) fd >= fdt->size)
+    return NULL;
+  return fdt->files[fd];
+}
+
+/* Removes descriptor FD from FDT and returns the file it named,
+   which the caller must close, or a null pointer if FD was not
+   open. */
+struct file *
+fd_remove (struct fd_table *fdt, int fd) 
+{
+  struct file *file = fd_lookup (fdt, fd);
+
+  if (file != NULL)
+    {
+      fdt->files[fd] = NULL;
+      bitmap_reset (fdt->used, fd);
+      bitmap_reset (fdt->cloexec, fd);
+      if ((size_t) fd < fdt->first_free)
+        fdt->first_free = fd;
+    }
+  return file;
+}
+
+/* Returns true if descriptor FD in FDT is closed on exec, false
+   if it is passed on or not open. */
+bool
+fd_get_cloexec (const struct fd_table *fdt, int fd) 
+{
+  return fd_lookup (fdt, fd) != NULL && bitmap_test (fdt->cloexec, fd);
+}
+
+/* Marks descriptor FD in FDT, which must be open, as closed on
+   exec if CLOEXEC is true, or as passed on otherwise. */
+void
+fd_set_cloexec (struct fd_table *fdt, int fd, bool cloexec) 
+{
+  ASSERT (fd_lookup (fdt, fd) != NULL);
+  bitmap_set (fdt->cloexec, fd, cloexec);
+}
@@ -0,0 +1,47 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct bitmap;
+struct file;
+
+/* Lowest file descriptor handed out.  0 and 1 are the console. */
+#define FD_MIN 2
+
+/* One more than the highest file descriptor a process may hold. */
+#define FD_MAX 4096
+
+/* A process's file descriptor table.
+
+   FILES grows by doubling as higher descriptors are used.  USED
+   has one bit per possible descriptor, set if it is open, so the
+   lowest free descriptor is found with a bitmap scan that starts
+   at FIRST_FREE, below which every descriptor is known to be in
+   use.  Opening files one after another never rescans.
+
+   CLOEXEC has one bit per descriptor, set if the descriptor is
+   closed on exec, that is, not passed on to the processes this
+   one starts.  Descriptors start out with the bit clear. */
+struct fd_table
+  {
+    struct file **files;        /* Open files, indexed by fd. */
+    size_t size;                /* Number of elements in FILES. */
+    struct bitmap *used;        /* Bit N set if fd N is open. */
+    size_t first_free;          /* No free fd below this. */
+    struct bitmap *cloexec;     /* Bit N set if fd N is closed on exec. */
+  };
+
+void fd_table_init (struct fd_table *);
+void fd_table_destroy (struct fd_table *);
+void fd_table_inherit (struct fd_table *, const struct fd_table *parent);
+
+int fd_alloc (struct fd_table *, struct file *);
+bool fd_install (struct fd_table *, int fd, struct file *);
+struct file *fd_lookup (const struct fd_table *, int fd);
+struct file *fd_remove (struct fd_table *, int fd);
+bool fd_get_cloexec (const struct fd_table *, int fd);
+void fd_set_cloexec (struct fd_table *, int fd, bool);
+
+#endif /* userprog/fdtable.h */
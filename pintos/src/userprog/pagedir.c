@@ -3,11 +3,13 @@
 #include <stddef.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
+#include "threads/smp.h"
 
 
-static void invalidate_pagedir (uint32_t *);
+static void invalidate_page (uint32_t *, const void *);
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
@@ -152,7 +154,7 @@ pagedir_clear_page (uint32_t *pd, void *upage)
   if (pte != NULL && (*pte & PTE_P) != 0)
     {
       *pte &= ~PTE_P;
-      invalidate_pagedir (pd);
+      invalidate_page (pd, upage);
     }
 }
 
@@ -180,7 +182,7 @@ pagedir_set_dirty (uint32_t *pd, const void *vpage, bool dirty)
       else 
         {
           *pte &= ~(uint32_t) PTE_D;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -209,7 +211,7 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
       else 
         {
           *pte &= ~(uint32_t) PTE_A; 
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -219,6 +221,8 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
 void
 pagedir_activate (uint32_t *pd) 
 {
+  enum intr_level old_level;
+
   if (pd == NULL)
     pd = init_page_dir;
 
@@ -226,8 +230,12 @@ pagedir_activate (uint32_t *pd)
      aka PDBR (page directory base register).  This activates our
      new page tables immediately.  See [IA32-v2a] "MOV--Move
      to/from Control Registers" and [IA32-v3a] 3.7.5 "Base
-     Address of the Page Directory". */
+     Address of the Page Directory".  Record it too, for
+     invalidate_page() on other CPUs. */
+  old_level = intr_disable ();
+  cpu_current ()->pagedir = pd;
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (pd)) : "memory");
+  intr_set_level (old_level);
 }
 
 /* Returns the currently active page directory. */
@@ -245,19 +253,29 @@ active_pd (void)
 
 /* Seom page table changes can cause the CPU's translation
    lookaside buffer (TLB) to become out-of-sync with the page
-   table.  When this happens, we have to "invalidate" the TLB by
-   re-activating it.
+   table.  When this happens, we have to "invalidate" the stale
+   TLB entry.
 
-   This function invalidates the TLB if PD is the active page
-   directory.  (If PD is not active then its entries are not in
-   the TLB, so there is no need to invalidate anything.) */
+   This function invalidates the TLB entry for VPAGE in every
+   CPU on which PD is the active page directory.  (If PD is not
+   active then its entries are not in the TLB, so there is no
+   need to invalidate anything.)  Other CPUs do so when
+   smp_invalidate_page() interrupts them; holding interrupts off
+   meanwhile keeps them from activating PD behind our back. */
 static void
-invalidate_pagedir (uint32_t *pd) 
+invalidate_page (uint32_t *pd, const void *vpage) 
 {
+  enum intr_level old_level = intr_disable ();
+
   if (active_pd () == pd) 
     {
-      /* Re-activating PD clears the TLB.  See [IA32-v3a] 3.12
-         "Translation Lookaside Buffers (TLBs)". */
-      pagedir_activate (pd);
+      /* INVLPG drops just the one entry, unlike reloading CR3,
+         which clears the whole TLB.  See [IA32-v2a] "INVLPG"
+         and [IA32-v3a] 3.12 "Translation Lookaside Buffers
+         (TLBs)". */
+      asm volatile ("invlpg (%0)" : : "r" (vpage) : "memory");
     } 
+  smp_invalidate_page (pd, vpage);
+
+  intr_set_level (old_level);
 }
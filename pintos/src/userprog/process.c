@@ -1,6 +1,7 @@
 #include "userprog/process.h"
 #include <debug.h>
 #include <inttypes.h>
+#include <kstats.h>
 #include <round.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -19,41 +20,75 @@
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/malloc.h"
+#include "devices/timer.h"
+#include "filesys/inode.h"
+#include "userprog/aio.h"
+#include "vm/shm.h"
 #include <list.h>
 
 
 
-void argument_stack(char **parse, int count,void **esp);
+static bool argument_stack (const char *first, char **save_ptr, void **esp);
 static thread_func start_process NO_RETURN;
+static void exec_account (int64_t start);
+static void print_rusage (const struct thread *);
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
 static bool install_page (void *upage, void *kpage, bool writable);
 
+/* Page faults handled, by vm_entry type. */
+static uint64_t fault_cnt[KSTATS_FAULT_TYPES];
+
+/* Print each process's resource use when it exits? */
+bool process_report_rusage;
+
 
 bool handle_mm_fault(struct vm_entry *vme){
+ struct rusage *ru = &thread_current()->ru;
+ /* Shared pages and aio rings are always present; see vm/shm.c
+    and userprog/aio.c. */
+ if(vme->type == VM_SHM)
+   return false;
+ if(vme->type < KSTATS_FAULT_TYPES)
+   fault_cnt[vme->type]++;
  struct page *p = alloc_page(PAL_USER);
 // printf("%x : alloc success, %d\n",p->kaddr, vme->type);
  p->vme = vme;
   bool success = true;
+  /* A fault that has to read the page in is major. */
+  bool major = false;
   switch(vme->type){
     case VM_BIN:
     success = load_file(p->kaddr, vme);
+    major = true;
     break;
     case VM_FILE:
     if(!vme->is_loaded){
       vme->is_loaded = true;
     //printf("%0x, tid:%d\n", p->kaddr, thread_tid());
     success = load_file(p->kaddr, vme);
+    major = true;
     }
     break;
     case VM_ANON:
+    /* A heap page that was never touched starts out zeroed. */
+    if(!vme->is_loaded){
+      memset(p->kaddr, 0, PGSIZE);
+      break;
+    }
     //printf("p->kaddr1 : %x\n", p->kaddr);
     swap_in(vme->swap_slot, p->kaddr);
+    ru->swap_ins++;
+    major = true;
     //printf("p->kaddr2 : %x\n", p->kaddr);
     break;
     case VM_STACK:
     vme->type = VM_ANON;
     break;
   }
+  if(major)
+    ru->major_faults++;
+  else
+    ru->minor_faults++;
   if(!success){
     //printf("success fail1\n");
   free_page(p);
@@ -85,6 +120,27 @@ return false;
 return true;
 }
 
+/* Gives the heap page at ADDR, which has not been touched since
+   sbrk() last grew over it, a VM_ANON entry that
+   handle_mm_fault() will zero-fill.  Returns false if out of
+   memory. */
+bool expand_heap(void *addr){
+  struct vm_entry *vme = malloc(sizeof *vme);
+
+  if(vme == NULL)
+    return false;
+  vme->type = VM_ANON;
+  vme->vaddr = pg_round_down(addr);
+  vme->writable = true;
+  vme->is_loaded = false;
+  vme->file = NULL;
+  if(!insert_vme(&thread_current()->vm, vme)){
+    free(vme);
+    return false;
+  }
+  return true;
+}
+
 bool verify_stack(void *sp, void *esp){
   
 if(esp > PHYS_BASE){
@@ -115,22 +171,25 @@ process_execute (const char *file_name)
   thread_current()->est = (int *) malloc(sizeof (int) * 100);  // allocate 100 size
 }
  
-  char *fn_copy, *thread_name, *save_ptr, *fn_copy1;
+  char *fn_copy, thread_name[16];
+  size_t len;
   struct list_elem *e;
   struct thread *t;
   tid_t tid;
-  /* Make a copy of FILE_NAME.
+  /* Make a copy of FILE_NAME for start_process() to tokenize.
      Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (0);
+  len = strnlen (file_name, PGSIZE - 1);
+  fn_copy = malloc (len + 1);
   if (fn_copy == NULL)
     return TID_ERROR;
-  strlcpy (fn_copy, file_name, PGSIZE);
-  fn_copy1 = (char *) malloc(sizeof (char) * (strlen(fn_copy)+1));
-  strlcpy (fn_copy1, fn_copy, strlen(fn_copy)+1);
-  thread_name = strtok_r (fn_copy, " ", &save_ptr);
+  strlcpy (fn_copy, file_name, len + 1);
+  file_name += strspn (file_name, " ");
+  len = strcspn (file_name, " ");
+  strlcpy (thread_name, file_name,
+           len < sizeof thread_name ? len + 1 : sizeof thread_name);
   /* Create a new thread to execute FILE_NAME. */
     //oom
-  tid = thread_create (thread_name, PRI_DEFAULT , start_process, fn_copy1);
+  tid = thread_create (thread_name, PRI_DEFAULT , start_process, fn_copy);
   for (e = list_begin (&thread_current()->child_list); e != list_end (&thread_current()->child_list);
        e = list_next (e))
     {
@@ -140,30 +199,28 @@ process_execute (const char *file_name)
       break;
       }
     }
-    if(!thread_current()->load_status){
-    palloc_free_page (fn_copy);  
-    return -1;
-    }
-  palloc_free_page (fn_copy);  
   if (tid == TID_ERROR)
-    free (fn_copy1);   
+    {
+      free (fn_copy);
+      return TID_ERROR;
+    }
+    if(!thread_current()->load_status)
+    return -1;
   return tid;
 }
 
 /* A thread function that loads a user process and starts it
    running. */
 static void
-start_process (void *file_name_)
+start_process (void *cmd_line_)
 {
-
-  char *fn_copy, *file_name, *save_ptr, *token;
-  char **parse = palloc_get_page (0);
-  int j, i=0;
-  fn_copy = (char *) malloc(sizeof (char) *(strlen(file_name_)+1));
-  strlcpy (fn_copy, file_name_, strlen(file_name_)+1);
-  file_name = strtok_r (fn_copy, " ", &save_ptr);
+  char *cmd_line = cmd_line_;
+  char *file_name, *save_ptr;
   struct intr_frame if_;
   bool success;
+  int64_t start = timer_ticks ();
+
+  file_name = strtok_r (cmd_line, " ", &save_ptr);
 
   vm_init(&thread_current()->vm);
 
@@ -175,7 +232,11 @@ start_process (void *file_name_)
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
     
-  success = load (file_name, &if_.eip, &if_.esp);
+  success = (file_name != NULL
+             && load (file_name, &if_.eip, &if_.esp)
+             && argument_stack (file_name, &save_ptr, &if_.esp));
+  free (cmd_line);
+  exec_account (start);
   struct list l = thread_current()->sema_exec.waiters;
   if(!list_empty(&l)){
     struct thread *t = list_entry(list_begin(&l), struct thread, elem);
@@ -185,16 +246,6 @@ start_process (void *file_name_)
   /* If load failed, quit. */
   if (!success) 
     thread_exit ();
-   for (token = file_name; token != NULL; token = strtok_r (NULL, " ", &save_ptr)){
-              parse[i] = (char *)malloc(sizeof (char)*128);    
-              strlcpy(parse[i++], token, strlen(token)+1);
-   }
-    argument_stack(parse, i, &if_.esp); 
-   // hex_dump((uintptr_t) if_.esp , if_.esp , PHYS_BASE - if_.esp , true);
-    free (file_name);
-    for(j=0;j<i;j++)
-    free(parse[j]);
-    palloc_free_page (parse);
 
   /* Start the user process by simulating a return from an
      interrupt, implemented by intr_exit (in
@@ -293,12 +344,19 @@ process_exit (void)
     }
     //free(mf);
        }
+  shm_unmap_all();
+  aio_exit();
    free_all();     
   vm_destroy(&cur->vm);     
   dir_close(cur->dir); 
   pd = cur->pagedir;
   if (pd != NULL) 
     {
+      /* Report usage now that the teardown above, which can
+         fault, write back and wait, has been charged for. */
+      if (process_report_rusage)
+        print_rusage (cur);
+
       /* Correct ordering here is crucial.  We must set
          cur->pagedir to NULL before switching page directories,
          so that a timer interrupt can't switch back to the
@@ -320,6 +378,11 @@ void
 process_activate (void)
 {
   struct thread *t = thread_current ();
+  enum intr_level old_level;
+
+  /* Keep interrupts off so that we cannot move to another CPU
+     partway through. */
+  old_level = intr_disable ();
 
   /* Activate thread's page tables. */
   pagedir_activate (t->pagedir);
@@ -327,6 +390,8 @@ process_activate (void)
   /* Set thread's kernel stack for use in processing
      interrupts. */
   tss_update ();
+
+  intr_set_level (old_level);
 }
 
 /* We load ELF binaries.  The following definitions are taken
@@ -392,64 +457,138 @@ struct Elf32_Phdr
 #define PF_W 2          /* Writable. */
 #define PF_R 4          /* Readable. */
 
+/* A PT_LOAD segment, reduced to the arguments load_segment()
+   takes. */
+struct elf_segment
+  {
+    off_t ofs;                  /* Page-aligned offset in the file. */
+    uint8_t *upage;             /* User page it starts at. */
+    uint32_t read_bytes;        /* Bytes to read from the file. */
+    uint32_t zero_bytes;        /* Bytes to zero after those. */
+    bool writable;              /* Mapped writable? */
+  };
+
+/* Maximum number of PT_LOAD segments in an executable. */
+#define ELF_MAX_SEGMENTS 8
+
+/* Everything load() takes from an executable's headers. */
+struct elf_image
+  {
+    void (*entry) (void);       /* Entry point. */
+    int segment_cnt;            /* Number of SEGMENTS in use. */
+    struct elf_segment segments[ELF_MAX_SEGMENTS];
+  };
+
+/* A parsed executable in the ELF cache.  The cache holds INODE
+   open, so the in-memory inode lives on between runs and its
+   write count shows whether the file changed since parsing. */
+struct elf_cache_entry
+  {
+    struct list_elem elem;      /* Element in elf_cache. */
+    struct inode *inode;        /* The executable, held open. */
+    unsigned write_cnt;         /* inode_write_cnt() when parsed. */
+    struct elf_image image;
+  };
+
+/* Number of executables the ELF cache remembers. */
+#define ELF_CACHE_SIZE 8
+
+static struct list elf_cache;   /* Most recently used first. */
+static struct lock exec_lock;   /* Protects elf_cache and the counters. */
+static long long exec_cnt;      /* Number of processes started. */
+static long long exec_hit_cnt;  /* ...whose headers came from elf_cache. */
+static long long exec_ticks;    /* Timer ticks spent starting them. */
+
 static bool setup_stack (void **esp);
 static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
                           bool writable);
 
-/* Loads an ELF executable from FILE_NAME into the current thread.
-   Stores the executable's entry point into *EIP
-   and its initial stack pointer into *ESP.
-   Returns true if successful, false otherwise. */
-bool
-load (const char *file_name, void (**eip) (void), void **esp) 
+/* Initializes the ELF cache. */
+void
+process_init (void) 
+{
+  list_init (&elf_cache);
+  lock_init (&exec_lock);
+}
+
+/* Prints exec statistics. */
+void
+process_print_stats (void) 
+{
+  printf ("Exec: %lld processes (%lld from ELF cache), %lld ticks loading\n",
+          exec_cnt, exec_hit_cnt, exec_ticks);
+}
+
+/* Prints a line summing up the resource use of process T. */
+static void
+print_rusage (const struct thread *t)
+{
+  const struct rusage *ru = &t->ru;
+
+  printf ("%s: rusage: %lld user + %lld kernel ticks, "
+          "%llu major + %llu minor faults, %llu swap-ins, "
+          "%llu sectors read, %llu written, "
+          "%llu voluntary + %llu involuntary switches\n",
+          t->name, ru->user_ticks, ru->kernel_ticks,
+          ru->major_faults, ru->minor_faults, ru->swap_ins,
+          ru->blocks_read, ru->blocks_written,
+          ru->voluntary_switches, ru->involuntary_switches);
+}
+
+/* Copies the page fault counters into ST. */
+void
+process_get_stats (struct kstats *st) 
+{
+  memcpy (st->faults, fault_cnt, sizeof st->faults);
+}
+
+/* Counts one process start that began at timer tick START. */
+static void
+exec_account (int64_t start) 
+{
+  int64_t elapsed = timer_elapsed (start);
+
+  lock_acquire (&exec_lock);
+  exec_cnt++;
+  exec_ticks += elapsed;
+  lock_release (&exec_lock);
+}
+
+/* Reads and validates FILE's ELF header and program headers into
+   *IMAGE.  Returns true if successful, false if FILE is not an
+   executable we can load. */
+static bool
+elf_parse (struct file *file, struct elf_image *image) 
 {
-  struct thread *t = thread_current ();
   struct Elf32_Ehdr ehdr;
-  struct file *file = NULL;
-  off_t file_ofs;
-  bool success = false;
+  off_t file_ofs, length;
   int i;
-  /* Allocate and activate page directory. */
-  t->pagedir = pagedir_create ();
-  if (t->pagedir == NULL)
-    goto done;
-  process_activate ();
-  /* Open executable file. */
-  file = filesys_open (file_name);
-  if (file == NULL) 
-    {
-      printf ("load: %s: open failed\n", file_name);
-      goto done; 
-    }
 
-  file_deny_write(file);
-  t->running_file = file;
-  t->deny_write = 1;
   /* Read and verify executable header. */
-  if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
+  if (file_read_at (file, &ehdr, sizeof ehdr, 0) != sizeof ehdr
       || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
       || ehdr.e_type != 2
       || ehdr.e_machine != 3
       || ehdr.e_version != 1
       || ehdr.e_phentsize != sizeof (struct Elf32_Phdr)
       || ehdr.e_phnum > 1024) 
-    {
-      printf ("load: %s: error loading executable\n", file_name);
-      goto done; 
-    }
+    return false;
+
   /* Read program headers. */
+  image->entry = (void (*) (void)) ehdr.e_entry;
+  image->segment_cnt = 0;
+  length = file_length (file);
   file_ofs = ehdr.e_phoff;
   for (i = 0; i < ehdr.e_phnum; i++) 
     {
       struct Elf32_Phdr phdr;
 
-      if (file_ofs < 0 || file_ofs > file_length (file))
-        goto done;
-      file_seek (file, file_ofs);
-      if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-        goto done;
+      if (file_ofs < 0 || file_ofs > length)
+        return false;
+      if (file_read_at (file, &phdr, sizeof phdr, file_ofs) != sizeof phdr)
+        return false;
       file_ofs += sizeof phdr;
       switch (phdr.p_type) 
         {
@@ -463,45 +602,178 @@ load (const char *file_name, void (**eip) (void), void **esp)
         case PT_DYNAMIC:
         case PT_INTERP:
         case PT_SHLIB:
-          goto done;
+          return false;
         case PT_LOAD:
-          if (validate_segment (&phdr, file)) 
+          if (validate_segment (&phdr, file)
+              && image->segment_cnt < ELF_MAX_SEGMENTS) 
             {
-              bool writable = (phdr.p_flags & PF_W) != 0;
-              uint32_t file_page = phdr.p_offset & ~PGMASK;
-              uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
+              struct elf_segment *seg = &image->segments[image->segment_cnt++];
               uint32_t page_offset = phdr.p_vaddr & PGMASK;
-              uint32_t read_bytes, zero_bytes;
+
+              seg->writable = (phdr.p_flags & PF_W) != 0;
+              seg->ofs = phdr.p_offset & ~PGMASK;
+              seg->upage = (uint8_t *) (phdr.p_vaddr & ~PGMASK);
               if (phdr.p_filesz > 0)
                 {
                   /* Normal segment.
                      Read initial part from disk and zero the rest. */
-                  read_bytes = page_offset + phdr.p_filesz;
-                  zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-                                - read_bytes);
+                  seg->read_bytes = page_offset + phdr.p_filesz;
+                  seg->zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz,
+                                               PGSIZE)
+                                     - seg->read_bytes);
                 }
               else 
                 {
                   /* Entirely zero.
                      Don't read anything from disk. */
-                  read_bytes = 0;
-                  zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
+                  seg->read_bytes = 0;
+                  seg->zero_bytes = ROUND_UP (page_offset + phdr.p_memsz,
+                                              PGSIZE);
                 }
-              if (!load_segment (file, file_page, (void *) mem_page,
-                                 read_bytes, zero_bytes, writable))
-                goto done;
             }
           else
-            goto done;
+            return false;
           break;
         }
     }
+  return true;
+}
+
+/* Looks up FILE in the ELF cache.  If it is there and has not
+   been written since it was parsed, copies its image into *IMAGE,
+   marks it most recently used, and returns true. */
+static bool
+elf_cache_lookup (struct file *file, struct elf_image *image) 
+{
+  struct inode *inode = file_get_inode (file);
+  struct list_elem *e;
+  bool found = false;
+
+  lock_acquire (&exec_lock);
+  for (e = list_begin (&elf_cache); e != list_end (&elf_cache);
+       e = list_next (e)) 
+    {
+      struct elf_cache_entry *ce = list_entry (e, struct elf_cache_entry, elem);
+      if (ce->inode == inode) 
+        {
+          if (ce->write_cnt == inode_write_cnt (inode)) 
+            {
+              *image = ce->image;
+              list_remove (&ce->elem);
+              list_push_front (&elf_cache, &ce->elem);
+              exec_hit_cnt++;
+              found = true;
+            }
+          break;
+        }
+    }
+  lock_release (&exec_lock);
+  return found;
+}
+
+/* Adds FILE's parsed IMAGE to the ELF cache, replacing any stale
+   entry for it or else the least recently used one. */
+static void
+elf_cache_insert (struct file *file, const struct elf_image *image) 
+{
+  struct inode *inode = file_get_inode (file);
+  struct elf_cache_entry *ce = NULL;
+  struct list_elem *e;
+
+  lock_acquire (&exec_lock);
+  for (e = list_begin (&elf_cache); e != list_end (&elf_cache);
+       e = list_next (e)) 
+    if (list_entry (e, struct elf_cache_entry, elem)->inode == inode) 
+      {
+        ce = list_entry (e, struct elf_cache_entry, elem);
+        list_remove (&ce->elem);
+        break;
+      }
+  if (ce == NULL && list_size (&elf_cache) >= ELF_CACHE_SIZE) 
+    {
+      ce = list_entry (list_pop_back (&elf_cache),
+                       struct elf_cache_entry, elem);
+      inode_close (ce->inode);
+      ce->inode = inode_reopen (inode);
+    }
+  if (ce == NULL) 
+    {
+      ce = malloc (sizeof *ce);
+      if (ce == NULL) 
+        {
+          lock_release (&exec_lock);
+          return;
+        }
+      ce->inode = inode_reopen (inode);
+    }
+  ce->write_cnt = inode_write_cnt (inode);
+  ce->image = *image;
+  list_push_front (&elf_cache, &ce->elem);
+  lock_release (&exec_lock);
+}
+
+/* Loads an ELF executable from FILE_NAME into the current thread.
+   Stores the executable's entry point into *EIP
+   and its initial stack pointer into *ESP.
+   The headers are parsed only on the first run, or after the
+   file has been written; later runs reuse them from the ELF
+   cache.
+   Returns true if successful, false otherwise. */
+bool
+load (const char *file_name, void (**eip) (void), void **esp) 
+{
+  struct thread *t = thread_current ();
+  struct elf_image image;
+  struct file *file = NULL;
+  bool success = false;
+  int i;
+  /* Allocate and activate page directory. */
+  t->pagedir = pagedir_create ();
+  if (t->pagedir == NULL)
+    goto done;
+  process_activate ();
+  /* Open executable file. */
+  file = filesys_open (file_name);
+  if (file == NULL) 
+    {
+      printf ("load: %s: open failed\n", file_name);
+      goto done; 
+    }
+
+  file_deny_write(file);
+  t->running_file = file;
+  t->deny_write = 1;
+  /* Find or parse the executable's headers. */
+  if (!elf_cache_lookup (file, &image)) 
+    {
+      if (!elf_parse (file, &image)) 
+        {
+          printf ("load: %s: error loading executable\n", file_name);
+          goto done; 
+        }
+      elf_cache_insert (file, &image);
+    }
+  t->heap_start = NULL;
+  for (i = 0; i < image.segment_cnt; i++) 
+    {
+      struct elf_segment *seg = &image.segments[i];
+      uint8_t *end = seg->upage + seg->read_bytes + seg->zero_bytes;
+      if (!load_segment (file, seg->ofs, seg->upage,
+                         seg->read_bytes, seg->zero_bytes, seg->writable))
+        goto done;
+      if ((void *) end > t->heap_start)
+        t->heap_start = end;
+    }
+
+  /* The sbrk() heap starts out empty, just past the highest
+     segment. */
+  t->brk = t->heap_start;
   /* Set up stack. */
   if (!setup_stack (esp))
     goto done;
 
   /* Start address. */
-  *eip = (void (*) (void)) ehdr.e_entry;
+  *eip = image.entry;
 
   success = true;
 
@@ -511,7 +783,7 @@ load (const char *file_name, void (**eip) (void), void **esp)
   //file_close (file);
   return success;
 }
-
+
 /* load() helpers. */
 
 
@@ -641,32 +913,57 @@ setup_stack (void **esp)
     
   return success;
 }
-void
-argument_stack(char** parse, int count, void **esp){
-  int stack_count=0,i;
-  uint32_t adr[count];
-  for(i=count-1;i>=0;i--){
-    *esp-=strlen(parse[i])+1;
-    strlcpy(*esp, parse[i], strlen(parse[i])+1);
-    adr[i] = *esp;
-    stack_count +=strlen(parse[i])+1;
-  }
-  int word_align=0;
-  word_align = (4 - (stack_count%4))%4;
-  *esp -= word_align;
-  *esp = memset(*esp, 0, word_align);
-  *esp -=4;
-  **(uint32_t **) esp = 0;
-  for(i=count-1;i>=0;i--){
-    *esp-=4;
-    **(uint32_t **) esp =(uint32_t) adr[i];
-  }
-  *esp -=4;
-  **(uint32_t **) esp =(uint32_t) (*esp + 4);
-  *esp -=4;
-  **(uint32_t **) esp = count;
-  *esp -=4;
-  **(uint32_t **) esp = 0; 
+
+/* Pushes the arguments to main() onto the fresh user stack at
+   *ESP: FIRST, then each token strtok_r() still has to return
+   from *SAVE_PTR.  Every token is copied straight from the
+   command line to its place on the stack, so the strings end up
+   in reverse order, last argument lowest.  Returns false if the
+   arguments do not fit in the stack page. */
+static bool
+argument_stack (const char *first, char **save_ptr, void **esp) 
+{
+  uint8_t *bottom = (uint8_t *) PHYS_BASE - PGSIZE;
+  uint8_t *sp = *esp;
+  const char *token;
+  char *arg;
+  char **argv;
+  int argc = 0;
+  int i;
+
+  /* The strings themselves. */
+  for (token = first; token != NULL; token = strtok_r (NULL, " ", save_ptr)) 
+    {
+      size_t len = strlen (token) + 1;
+      if ((size_t) (sp - bottom) < len)
+        return false;
+      sp -= len;
+      memcpy (sp, token, len);
+      argc++;
+    }
+  arg = (char *) sp;
+
+  /* Word-align, then argv[argc] down to argv[0], argv, argc and
+     a fake return address.  The page is zeroed, so the padding
+     and argv[argc] already read as 0. */
+  sp = (uint8_t *) ROUND_DOWN ((uintptr_t) sp, sizeof (char *));
+  if ((size_t) (sp - bottom) < (argc + 4) * sizeof (char *))
+    return false;
+  argv = (char **) sp - 1 - argc;
+  for (i = argc - 1; i >= 0; i--) 
+    {
+      argv[i] = arg;
+      arg += strlen (arg) + 1;
+    }
+  sp = (uint8_t *) argv;
+  sp -= sizeof (char **);
+  *(char ***) sp = argv;
+  sp -= sizeof (int);
+  *(int *) sp = argc;
+  sp -= sizeof (void *);
+  *(void **) sp = NULL;
+  *esp = sp;
+  return true;
 }
 
 /* Adds a mapping from user virtual address UPAGE to kernel
@@ -4,12 +4,21 @@
 #include "threads/thread.h"
 #include "vm/page.h"
 
+/* Print each process's resource use when it exits?  Set by the
+   -ru kernel command line option. */
+extern bool process_report_rusage;
+
+void process_init (void);
+void process_print_stats (void);
+struct kstats;
+void process_get_stats (struct kstats *);
 tid_t process_execute (const char *file_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
 bool handle_mm_fault(struct vm_entry *vme);
 bool expand_stack(void *addr);
+bool expand_heap(void *addr);
 bool verify_stack(void *sp, void *esp);
 
 
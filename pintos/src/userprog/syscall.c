@@ -1,13 +1,39 @@
 #include "userprog/syscall.h"
 #include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "userprog/aio.h"
+#include <dirent.h>
+#include <iovec.h>
+#include <ipc.h>
+#include <kstats.h>
+#include <limits.h>
+#include <rusage.h>
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
+#include <tty.h>
+#include "devices/intq.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "vm/page.h"
+#include "vm/frame.h"
 #include "devices/block.h"
+#include "devices/input.h"
+#include "devices/shutdown.h"
 #include "filesys/inode.h"
+#include "filesys/directory.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/dentry_cache.h"
+#include "filesys/journal.h"
+#include "filesys/pipe.h"
+#include "vm/shm.h"
+#include "vm/swap.h"
 
 typedef int mapid_t;
 
@@ -34,6 +60,8 @@ void close(int fd);
 
 int filesize(int fd);
 
+int fsync(int fd);
+
 void seek(int fd, unsigned position);
 
 unsigned tell(int fd);
@@ -59,6 +87,232 @@ bool mkdir(const char *dir);
 bool readdir(int fd, char *name);
 block_sector_t inumber(int fd);
 
+int getdents (int fd, struct dirent *ents, int cnt);
+
+int readv (int fd, const struct iovec *iov, int iovcnt);
+
+int writev (int fd, const struct iovec *iov, int iovcnt);
+
+int pread (int fd, void *buffer, unsigned size, unsigned offset);
+
+int pwrite (int fd, const void *buffer, unsigned size, unsigned offset);
+
+int sendfile (int out_fd, int in_fd, unsigned size);
+
+int dup (int fd);
+
+int dup2 (int old_fd, int new_fd);
+
+bool stats (struct kstats *st);
+
+void *sbrk (intptr_t increment);
+
+bool pipe2 (int *fds, int flags);
+
+int ttymode (int mode);
+
+int ttypoll (void);
+
+bool getrusage (int who, struct rusage *ru);
+
+int cloexec (int fd, int flag);
+
+/* Number of argument words taken by each system call, indexed
+   by system call number.  Calls not listed take no arguments. */
+static const int syscall_argc[] =
+  {
+    [SYS_EXIT] = 1, [SYS_EXEC] = 1, [SYS_WAIT] = 1,
+    [SYS_CREATE] = 2, [SYS_REMOVE] = 1, [SYS_OPEN] = 1,
+    [SYS_FILESIZE] = 1, [SYS_READ] = 3, [SYS_WRITE] = 3,
+    [SYS_SEEK] = 2, [SYS_TELL] = 1, [SYS_CLOSE] = 1,
+    [SYS_SIGACTION] = 2, [SYS_SENDSIG] = 2,
+    [SYS_MMAP] = 2, [SYS_MUNMAP] = 1,
+    [SYS_CHDIR] = 1, [SYS_MKDIR] = 1, [SYS_READDIR] = 2,
+    [SYS_ISDIR] = 1, [SYS_INUMBER] = 1,
+    [SYS_READV] = 3, [SYS_WRITEV] = 3, [SYS_PREAD] = 4, [SYS_PWRITE] = 4,
+    [SYS_SENDFILE] = 3, [SYS_DUP] = 1, [SYS_DUP2] = 2,
+    [SYS_STATS] = 1, [SYS_SBRK] = 1,
+    [SYS_PIPE] = 2, [SYS_SHM_MAP] = 3, [SYS_SHM_UNMAP] = 1,
+    [SYS_AIO_SETUP] = 1, [SYS_AIO_ENTER] = 2,
+    [SYS_FSYNC] = 1, [SYS_GETDENTS] = 3,
+    [SYS_TTYMODE] = 1, [SYS_GETRUSAGE] = 2, [SYS_CLOEXEC] = 2,
+  };
+#define SYSCALL_CNT (sizeof syscall_argc / sizeof *syscall_argc)
+
+/* Reads a byte at user virtual address UADDR, which must be
+   below PHYS_BASE.  Returns the byte value if successful, -1 if
+   a page fault could not be resolved.  See page_fault(). */
+static inline int
+get_user (const uint8_t *uaddr)
+{
+  int result;
+  asm ("movl $1f, %0; movzbl %1, %0; 1:"
+       : "=&a" (result) : "m" (*uaddr));
+  return result;
+}
+
+/* Writes BYTE to user address UDST, which must be below
+   PHYS_BASE.  Returns true if successful, false if a page fault
+   could not be resolved. */
+static inline bool
+put_user (uint8_t *udst, uint8_t byte)
+{
+  int error_code;
+  asm ("movl $1f, %0; movb %b2, %1; 1:"
+       : "=&a" (error_code), "=m" (*udst) : "q" (byte));
+  return error_code != -1;
+}
+
+/* Returns true if the SIZE bytes starting at user address UADDR
+   lie entirely below PHYS_BASE.  This is the only check made up
+   front; whether the pages are actually mapped is left to the
+   page fault handler when the memory is touched. */
+static inline bool
+is_user_range (const void *uaddr, size_t size)
+{
+  uintptr_t start = (uintptr_t) uaddr;
+  return start + size >= start && start + size <= (uintptr_t) PHYS_BASE;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.  Returns false if USRC is not valid user memory. */
+bool
+copy_in (void *dst_, const void *usrc_, size_t size)
+{
+  uint8_t *dst = dst_;
+  const uint8_t *usrc = usrc_;
+  struct thread *cur = thread_current ();
+  bool success = true;
+
+  if (!is_user_range (usrc, size))
+    return false;
+  cur->user_access = true;
+  for (; size > 0; size--)
+    {
+      int byte = get_user (usrc++);
+      if (byte == -1)
+        {
+          success = false;
+          break;
+        }
+      *dst++ = byte;
+    }
+  cur->user_access = false;
+  return success;
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+   UDST.  Returns false if UDST is not valid, writable user
+   memory. */
+bool
+copy_out (void *udst_, const void *src_, size_t size)
+{
+  uint8_t *udst = udst_;
+  const uint8_t *src = src_;
+  struct thread *cur = thread_current ();
+  bool success = true;
+
+  if (!is_user_range (udst, size))
+    return false;
+  cur->user_access = true;
+  for (; size > 0; size--)
+    if (!put_user (udst++, *src++))
+      {
+        success = false;
+        break;
+      }
+  cur->user_access = false;
+  return success;
+}
+
+/* Terminates the process unless USTR is a null-terminated string
+   in valid user memory. */
+static void
+check_user_string (const char *ustr)
+{
+  struct thread *cur = thread_current ();
+  const uint8_t *p = (const uint8_t *) ustr;
+  int byte;
+
+  if (ustr == NULL)
+    exit (-1);
+  cur->user_access = true;
+  do
+    {
+      byte = is_user_vaddr (p) ? get_user (p++) : -1;
+      if (byte == -1)
+        {
+          cur->user_access = false;
+          exit (-1);
+        }
+    }
+  while (byte != '\0');
+  cur->user_access = false;
+}
+
+/* Terminates the process unless the SIZE-byte user buffer at
+   UADDR lies below PHYS_BASE.  The pages are faulted in (or the
+   process killed) by the page fault handler as they are used. */
+static void
+check_user_buffer (const void *uaddr, unsigned size)
+{
+  if (!is_user_range (uaddr, size))
+    exit (-1);
+}
+
+/* Faults in each page of the SIZE-byte user buffer at UADDR,
+   which must already have passed check_user_buffer(), and
+   terminates the process if a page is missing, or is read-only
+   and WRITE is true.  Pipe I/O calls this first, because a bad
+   buffer found in the middle of the copy would kill the process
+   while it holds the pipe's lock. */
+static void
+touch_user_buffer (const void *uaddr, unsigned size, bool write)
+{
+  struct thread *cur = thread_current ();
+  const uint8_t *p = uaddr, *end = p + size;
+  struct vm_entry *vme;
+  int byte;
+
+  for (; p < end; p = (const uint8_t *) pg_round_down (p) + PGSIZE)
+    {
+      cur->user_access = true;
+      byte = get_user (p);
+      cur->user_access = false;
+      if (byte == -1
+          || (write && ((vme = find_vme ((void *) p)) == NULL
+                        || !vme->writable)))
+        exit (-1);
+    }
+}
+
+/* Acquires filesys_lock for I/O on FD, unless FD is a pipe or
+   the console, and returns true if it did.  Pipe and console I/O
+   may wait for another process or for input, which must not
+   happen with the lock held, and never touches the file
+   system. */
+static bool
+lock_fd (int fd)
+{
+  struct file *file;
+
+  if (fd == STDIN_FILENO || fd == STDOUT_FILENO)
+    return false;
+  file = fd_lookup (&thread_current ()->fdt, fd);
+  if (file != NULL && file_is_pipe (file))
+    return false;
+  lock_acquire (&filesys_lock);
+  return true;
+}
+
+/* Releases filesys_lock if LOCKED, as returned by lock_fd(). */
+static void
+unlock_fd (bool locked)
+{
+  if (locked)
+    lock_release (&filesys_lock);
+}
+
 void
 syscall_init (void) 
 {
@@ -69,185 +323,229 @@ syscall_init (void)
 static void
 syscall_handler (struct intr_frame *f) 
 {
-  
-  if(!is_user_vaddr(f->esp))
-    exit(-1);
-  int *number = f->esp;
-   // printf("%x esp syscall! :\n", f->esp);
-  thread_current()->syscall_esp = number;
-  switch(*(uint32_t *) number){
+  uint32_t *esp = f->esp;
+  uint32_t number, arg[4];
+  int argc;
+  bool locked;
+
+  thread_current()->syscall_esp = esp;
+  if (!copy_in (&number, esp, sizeof number))
+    exit (-1);
+  argc = number < SYSCALL_CNT ? syscall_argc[number] : 0;
+  if (!copy_in (arg, esp + 1, argc * sizeof *arg))
+    exit (-1);
+
+  switch(number){
   case SYS_HALT:
-  //printf("a\n"); 
     halt();   
     break;      
   case SYS_EXIT:
-   //printf("b\n"); 
-    if(!is_user_vaddr(number + 1))
-      exit(-1);
-    exit(*(uint32_t *)(number + 1));
+    exit(arg[0]);
     break;                  
   case SYS_EXEC:          
-  //printf("c\n");
-    if(!is_user_vaddr(number + 1))
-      exit(-1);
-    f->eax = exec(*(uint32_t *)(number + 1));
+    check_user_string((const char *) arg[0]);
+    f->eax = exec((const char *) arg[0]);
     break;
   case SYS_WAIT:
-   //printf("d\n");
-    if(!is_user_vaddr(number + 1))
-     exit(-1);
-    f->eax = wait(*(uint32_t *)(number + 1));
+    f->eax = wait(arg[0]);
     break;                         
   case SYS_READ:
-  //printf("e\n");
-
-    if(!is_user_vaddr(number + 3) || !is_user_vaddr(*(uint32_t *)(number + 2)) || *(uint32_t *)(number + 1) == 1 || *(uint32_t *)(number + 1) <0)
+    if(arg[0] == 1)
       exit(-1);
-    lock_acquire(&filesys_lock);
-    f->eax = read(*(uint32_t *)(number + 1),*(uint32_t *)(number + 2),*(uint32_t *)(number + 3));
-    lock_release(&filesys_lock);
+    check_user_buffer((void *) arg[1], arg[2]);
+    locked = lock_fd(arg[0]);
+    f->eax = read(arg[0], (void *) arg[1], arg[2]);
+    unlock_fd(locked);
     break;                   
   case SYS_WRITE:
-   //printf("f\n");
-   //printf("%s\n",*(uint32_t *)(number + 2));
-  // hex_dump((uintptr_t) f->esp , f->esp , PHYS_BASE - f->esp , true);
-    if(!is_user_vaddr(number + 3))
-      exit(-1);
-    lock_acquire(&filesys_lock);  
-      f->eax = write(*(uint32_t *)(number + 1),*(uint32_t *)(number + 2),*(uint32_t *)(number + 3));
-    lock_release(&filesys_lock);  
-   break;     
+    check_user_buffer((const void *) arg[1], arg[2]);
+    locked = lock_fd(arg[0]);
+    f->eax = write(arg[0], (const void *) arg[1], arg[2]);
+    unlock_fd(locked);
+    break;     
   case SYS_CREATE:
-   //printf("g\n");
-    if(!is_user_vaddr(number + 2) || *(uint32_t *)(number + 1)==NULL || !strcmp(*(uint32_t *)(number + 1),""))
-    exit(-1);
-   // hex_dump((uintptr_t) f->esp , f->esp , PHYS_BASE - f->esp , true);
+    check_user_string((const char *) arg[0]);
+    if(*(const char *) arg[0] == '\0')
+      exit(-1);
     lock_acquire(&filesys_lock); 
-    f->eax = create(*(uint32_t *)(number + 1), *(uint32_t *)(number + 2));
+    f->eax = create((const char *) arg[0], arg[1]);
     lock_release(&filesys_lock);  
-    //printf("%x,%d\n",f->eip,*(uint32_t *)f->eip);
-     //hex_dump((uintptr_t)  0xbffffec0 ,  0xbffffec0 , PHYS_BASE - 0xbffffec0 , true);
     break;   
   case SYS_OPEN:
-  // printf("h\n");
-   if(!is_user_vaddr(number + 1) || *(uint32_t *)(number + 1) == NULL)
-      exit(-1);
+    check_user_string((const char *) arg[0]);
     lock_acquire(&filesys_lock);   
-    f->eax = open(*(uint32_t *)(number + 1));
+    f->eax = open((const char *) arg[0]);
     lock_release(&filesys_lock);  
     break;       
   case SYS_CLOSE:
- // printf("i\n");
-    if(!is_user_vaddr(number + 1))
-      exit(-1);
     lock_acquire(&filesys_lock);     
-    close(*(uint32_t *)(number + 1));
+    close(arg[0]);
     lock_release(&filesys_lock);  
     break;             
   case SYS_REMOVE:
-   //printf("j\n");
-   if(!is_user_vaddr(number + 1))
-      exit(-1);
+    check_user_string((const char *) arg[0]);
     lock_acquire(&filesys_lock);       
-    f->eax = remove(*(uint32_t *)(number + 1));
+    f->eax = remove((const char *) arg[0]);
     lock_release(&filesys_lock);  
     break;    
   case SYS_FILESIZE:
-   //printf("k\n");
-  if(!is_user_vaddr(number + 1))
-      exit(-1);
     lock_acquire(&filesys_lock);         
-    f->eax = filesize(*(uint32_t *)(number + 1));
+    f->eax = filesize(arg[0]);
     lock_release(&filesys_lock);  
     break;      
   case SYS_SEEK:
-   //printf("l\n");
-   if(!is_user_vaddr(number + 2))
-      exit(-1);
     lock_acquire(&filesys_lock);           
-    seek(*(uint32_t *)(number + 1), *(uint32_t *)(number + 2));
+    seek(arg[0], arg[1]);
     lock_release(&filesys_lock);  
     break;      
   case SYS_TELL:
-   //printf("m\n");
-   if(!is_user_vaddr(number + 1))
-      exit(-1);
     lock_acquire(&filesys_lock);             
-    f->eax = tell(*(uint32_t *)(number + 1));
+    f->eax = tell(arg[0]);
     lock_release(&filesys_lock);  
     break;
   case SYS_SIGACTION:
-   //printf("n\n");
-   if(!is_user_vaddr(number + 2))
-      exit(-1);
-    sigaction(*(uint32_t *)(number + 1), *(uint32_t *)(number + 2));
+    sigaction(arg[0], (void (*) (void)) arg[1]);
     break;     
   case SYS_SENDSIG:
-   //printf("o\n");
-   if(!is_user_vaddr(number + 2))
-      exit(-1);
-    sendsig(*(uint32_t *)(number + 1), *(uint32_t *)(number + 2));
+    sendsig(arg[0], arg[1]);
     break;  
   case SYS_YIELD:
-   //printf("p\n");
-   if(!is_user_vaddr(number))
-      exit(-1);
-      sched_yield();
+    sched_yield();
     break;      
   case SYS_MMAP:
-   if(!is_user_vaddr(number + 2))
-      exit(-1);
-        lock_acquire(&filesys_lock);  
-     f->eax = mmap(*(uint32_t *)(number + 1), *(uint32_t *)(number + 2));
-     lock_release(&filesys_lock);
+    lock_acquire(&filesys_lock);  
+    f->eax = mmap(arg[0], (void *) arg[1]);
+    lock_release(&filesys_lock);
     break;      
   case SYS_MUNMAP:
-   if(!is_user_vaddr(number + 1))
-      exit(-1);
-        lock_acquire(&filesys_lock);  
-      munmap(*(uint32_t *)(number + 1));
-           lock_release(&filesys_lock);
+    lock_acquire(&filesys_lock);  
+    munmap(arg[0]);
+    lock_release(&filesys_lock);
     break;
   case SYS_CHDIR:
-  if(!is_user_vaddr(number + 1))
-      exit(-1);
-        lock_acquire(&filesys_lock);  
-      f->eax = chdir(*(uint32_t *)(number + 1));
-           lock_release(&filesys_lock);
-  break;  
+    check_user_string((const char *) arg[0]);
+    lock_acquire(&filesys_lock);  
+    f->eax = chdir((const char *) arg[0]);
+    lock_release(&filesys_lock);
+    break;  
   case SYS_MKDIR:
-  if(!is_user_vaddr(number + 1))
-      exit(-1);
-        lock_acquire(&filesys_lock);  
-      f->eax = mkdir(*(uint32_t *)(number + 1));
-           lock_release(&filesys_lock);
-  break;
+    check_user_string((const char *) arg[0]);
+    lock_acquire(&filesys_lock);  
+    f->eax = mkdir((const char *) arg[0]);
+    lock_release(&filesys_lock);
+    break;
   case SYS_READDIR:
-  if(!is_user_vaddr(number + 2))
-      exit(-1);
-        lock_acquire(&filesys_lock);  
-     f->eax = readdir(*(uint32_t *)(number + 1), *(uint32_t *)(number + 2));
-     lock_release(&filesys_lock);
-  break;
+    check_user_buffer((void *) arg[1], NAME_MAX + 1);
+    lock_acquire(&filesys_lock);  
+    f->eax = readdir(arg[0], (char *) arg[1]);
+    lock_release(&filesys_lock);
+    break;
   case SYS_ISDIR:
-  if(!is_user_vaddr(number + 1))
-      exit(-1);
-        lock_acquire(&filesys_lock);  
-      f->eax = isdir(*(uint32_t *)(number + 1));
-           lock_release(&filesys_lock);
-  break;       
+    lock_acquire(&filesys_lock);  
+    f->eax = isdir(arg[0]);
+    lock_release(&filesys_lock);
+    break;       
   case SYS_INUMBER:
-  if(!is_user_vaddr(number + 1))
+    lock_acquire(&filesys_lock);  
+    f->eax = inumber(arg[0]);
+    lock_release(&filesys_lock);
+    break;
+  case SYS_READV:
+    if(arg[0] == 1)
       exit(-1);
-        lock_acquire(&filesys_lock);  
-      f->eax = inumber(*(uint32_t *)(number + 1));
-           lock_release(&filesys_lock);
-  break;
+    locked = lock_fd(arg[0]);
+    f->eax = readv(arg[0], (const struct iovec *) arg[1], arg[2]);
+    unlock_fd(locked);
+    break;
+  case SYS_WRITEV:
+    locked = lock_fd(arg[0]);
+    f->eax = writev(arg[0], (const struct iovec *) arg[1], arg[2]);
+    unlock_fd(locked);
+    break;
+  case SYS_PREAD:
+    check_user_buffer((void *) arg[1], arg[2]);
+    lock_acquire(&filesys_lock);
+    f->eax = pread(arg[0], (void *) arg[1], arg[2], arg[3]);
+    lock_release(&filesys_lock);
+    break;
+  case SYS_PWRITE:
+    check_user_buffer((const void *) arg[1], arg[2]);
+    lock_acquire(&filesys_lock);
+    f->eax = pwrite(arg[0], (const void *) arg[1], arg[2], arg[3]);
+    lock_release(&filesys_lock);
+    break;
+  case SYS_SENDFILE:
+    lock_acquire(&filesys_lock);
+    f->eax = sendfile(arg[0], arg[1], arg[2]);
+    lock_release(&filesys_lock);
+    break;
+  case SYS_DUP:
+    lock_acquire(&filesys_lock);
+    f->eax = dup(arg[0]);
+    lock_release(&filesys_lock);
+    break;
+  case SYS_DUP2:
+    lock_acquire(&filesys_lock);
+    f->eax = dup2(arg[0], arg[1]);
+    lock_release(&filesys_lock);
+    break;
+  case SYS_STATS:
+    check_user_buffer((void *) arg[0], sizeof (struct kstats));
+    f->eax = stats((struct kstats *) arg[0]);
+    break;
+  case SYS_SBRK:
+    f->eax = (uint32_t) sbrk(arg[0]);
+    break;
+  case SYS_PIPE:
+    check_user_buffer((void *) arg[0], 2 * sizeof (int));
+    f->eax = pipe2((int *) arg[0], arg[1]);
+    break;
+  case SYS_SHM_MAP:
+    f->eax = (uint32_t) shm_map(arg[0], (void *) arg[1], arg[2]);
+    break;
+  case SYS_SHM_UNMAP:
+    f->eax = shm_unmap((void *) arg[0]);
+    break;
+  case SYS_AIO_SETUP:
+    f->eax = (uint32_t) aio_setup((void *) arg[0]);
+    break;
+  case SYS_AIO_ENTER:
+    f->eax = aio_enter(arg[0], arg[1]);
+    break;
+  case SYS_FSYNC:
+    lock_acquire(&filesys_lock);
+    f->eax = fsync(arg[0]);
+    lock_release(&filesys_lock);
+    break;
+  case SYS_GETDENTS:
+    lock_acquire(&filesys_lock);
+    f->eax = getdents(arg[0], (struct dirent *) arg[1], arg[2]);
+    lock_release(&filesys_lock);
+    break;
+  case SYS_TTYMODE:
+    f->eax = ttymode(arg[0]);
+    break;
+  case SYS_TTYPOLL:
+    f->eax = ttypoll();
+    break;
+  case SYS_GETRUSAGE:
+    check_user_buffer((void *) arg[1], sizeof (struct rusage));
+    f->eax = getrusage(arg[0], (struct rusage *) arg[1]);
+    break;
+  case SYS_CLOEXEC:
+    f->eax = cloexec(arg[0], arg[1]);
+    break;
   } 
 
-
   thread_current()->syscall_esp = NULL;
+}
 
+/* Returns the file open as FD in the current process, or a null
+   pointer if FD does not name an open file. */
+static struct file *
+fd_file (int fd)
+{
+  return fd_lookup (&thread_current ()->fdt, fd);
 }
 
 void halt (void) {
@@ -255,6 +553,10 @@ void halt (void) {
 }
 
 void exit (int status) {
+   /* A fault on a user buffer can land here in the middle of a
+      file system call. */
+   if (lock_held_by_current_thread (&filesys_lock))
+     lock_release (&filesys_lock);
    printf("%s: exit(%d)\n" , thread_current() -> name , status);
    thread_current()->exit_status = status;
   thread_exit ();
@@ -268,19 +570,77 @@ int wait (tid_t tid) {
   return process_wait(tid);
 }
 
+/* Reads up to SIZE bytes of console input into user BUFFER, in
+   the calling process's ttymode().  The input buffer may only be
+   read with interrupts off, when a fault on BUFFER could not be
+   handled, so input is taken a buffer's worth at a time into
+   kernel memory.  In TTY_LINE mode, keeps going until a whole
+   line has been read. */
+static int
+read_stdin (uint8_t *buffer, unsigned size)
+{
+  uint8_t chunk[INTQ_BUFSIZE];
+  bool line = thread_current ()->tty_mode == TTY_LINE;
+  unsigned total = 0;
+
+  touch_user_buffer (buffer, size, true);
+  while (total < size)
+    {
+      size_t n = input_read (chunk, (size - total < sizeof chunk
+                                     ? size - total : sizeof chunk), line);
+      memcpy (buffer + total, chunk, n);
+      total += n;
+      if (!line || chunk[n - 1] == '\n' || chunk[n - 1] == '\r')
+        break;
+    }
+  return total;
+}
+
+/* Writes SIZE bytes from user BUFFER to the console.  The
+   console and serial port are written with interrupts off, when
+   a fault on BUFFER could not be handled, so the data is copied
+   into kernel memory a buffer's worth at a time first. */
+static int
+write_stdout (const uint8_t *buffer, unsigned size)
+{
+  uint8_t chunk[INTQ_BUFSIZE];
+  unsigned total = 0;
+
+  while (total < size)
+    {
+      size_t n = (size - total < sizeof chunk
+                  ? size - total : sizeof chunk);
+      if (!copy_in (chunk, buffer + total, n))
+        exit (-1);
+      putbuf ((const char *) chunk, n);
+      total += n;
+    }
+  return total;
+}
+
 int read (int fd, void* buffer, unsigned size) {
-  if (fd == 0)
-    return input_getc();
+  if (fd == STDIN_FILENO)
+    return read_stdin(buffer, size);
   else{
-    return file_read(thread_current()->fdt[fd], buffer, size);
+    struct file *file = fd_file(fd);
+    if(file == NULL)
+      return -1;
+    if(file_is_pipe(file))
+      touch_user_buffer(buffer, size, true);
+    return file_read(file, buffer, size);
   }
 }
 
 int write (int fd, const void *buffer, unsigned size) {
   int written = 0;
-  if (fd == 1) {
-    putbuf(buffer, size);
-    return size;
+  if (fd == STDOUT_FILENO)
+    return write_stdout(buffer, size);
+  struct file *file = fd_file(fd);
+  if(file == NULL)
+    return -1;
+  if(file_is_pipe(file)){
+    touch_user_buffer(buffer, size, false);
+    return file_write(file, buffer, size);
   }
   struct inode *inode = inode_open(inumber(fd));
   if(inode_cnt(inode)>1 && isdir(fd)){
@@ -288,10 +648,7 @@ int write (int fd, const void *buffer, unsigned size) {
   return -1;
   }
   inode_close(inode);
-    if(thread_current()->fdt[fd]!=NULL)
-   return file_write(thread_current()->fdt[fd], buffer, size);
-   
-  
+  return file_write(file, buffer, size);
 }
 
 bool create (const char *file, unsigned initial_size) {
@@ -306,31 +663,49 @@ bool remove(const char *file){
 
 int open (const char *file){
   struct file *f = filesys_open(file);
-  if(f!=NULL){
-  thread_current()->fdt[thread_current()->next_fd++] = f;
-  return (thread_current()->next_fd - 1 );
-  }
-  return -1;
-  
+  int fd;
+  if(f == NULL)
+    return -1;
+  fd = fd_alloc(&thread_current()->fdt, f);
+  if(fd < 0)
+    file_close(f);
+  return fd;
 }
 
 void close(int fd){
-  if(fd>1){
-  file_close(thread_current()->fdt[fd]);
-  thread_current()->fdt[fd] = NULL;
-  }
+  file_close(fd_remove(&thread_current()->fdt, fd));
 }
 
 int filesize(int fd){
-return file_length(thread_current()->fdt[fd]);
+  struct file *file = fd_file(fd);
+  if(file == NULL || file_is_pipe(file))
+    return -1;
+  return file_length(file);
+}
+
+/* Writes FD's data and the file system's metadata to disk.
+   Cached data is not tracked per file, so this commits the
+   journal, which writes back all dirty file data first.
+   Returns 0 if successful, -1 if FD is bad or a pipe. */
+int fsync(int fd){
+  struct file *file = fd_file(fd);
+  if(file == NULL || file_is_pipe(file))
+    return -1;
+  journal_commit();
+  return 0;
 }
 
 void seek(int fd, unsigned position){
-   file_seek(thread_current()->fdt[fd], position);
+  struct file *file = fd_file(fd);
+  if(file != NULL)
+    file_seek(file, position);
 }
 
 unsigned tell(int fd){
-  return file_tell(thread_current()->fdt[fd]);
+  struct file *file = fd_file(fd);
+  if(file == NULL)
+    return 0;
+  return file_tell(file);
 }
 
 void sigaction (int signum, void (*handler) (void)){
@@ -366,7 +741,9 @@ int mmap (int fd, void *addr){
 struct vm_entry *vme;
 struct mmap_file *mf;
 off_t ofs = 0;
-struct file* file = file_reopen(thread_current()->fdt[fd]);
+if(fd_file(fd) == NULL || file_is_pipe(fd_file(fd)))
+  return -1;
+struct file* file = file_reopen(fd_file(fd));
 uint32_t read_bytes = file_length(file), zero_bytes = 0;
 mf = (struct mmap_file *) malloc(sizeof (struct mmap_file));
 mf->mapid = thread_current()->mapping_id++;
@@ -441,7 +818,8 @@ struct vm_entry *check_address(void *addr, void* esp){
 }
 
 bool isdir(int fd){
-return inode_is_dir(file_get_inode(thread_current()->fdt[fd]));
+struct file *file = fd_file(fd);
+return file != NULL && !file_is_pipe(file) && inode_is_dir(file_get_inode(file));
 }
 
 bool chdir(const char *dir){
@@ -483,22 +861,393 @@ bool readdir(int fd, char *name){
   if(!isdir(fd))
   return false;
   bool success, b = false;
-  struct inode *inode = file_get_inode(thread_current()->fdt[fd]);
+  char kname[NAME_MAX + 1];
+  struct inode *inode = file_get_inode(fd_file(fd));
   struct dir *sub, *dir;
   if(inode == NULL || thread_current()->dir == NULL)
   return false;
 
   dir = dir_open(inode_reopen(inode));
-if(!dir_readdir(dir, name ))
+if(!dir_readdir(dir, kname))
 success = false;
 else
 success = true;
 if(!b)
 dir_close(dir);
+if(success && !copy_out(name, kname, strlen(kname) + 1))
+  exit(-1);
 
 return success;
 }
 block_sector_t inumber(int fd){
-struct inode *inode = file_get_inode(thread_current()->fdt[fd]);
-return inode_get_inumber(inode);
-}
\ No newline at end of file
+struct file *file = fd_file(fd);
+if(file == NULL || file_is_pipe(file))
+  return -1;
+return inode_get_inumber(file_get_inode(file));
+}
+
+/* Stores up to CNT entries of directory FD into ENTS, at most
+   GETDENTS_MAX at a time, continuing where the last readdir() or
+   getdents() on the directory left off.  Returns the number of
+   entries stored, 0 at the end of the directory, or -1 if FD is
+   not a directory. */
+int getdents (int fd, struct dirent *ents, int cnt){
+  struct dirent *kents;
+  struct dir *dir;
+  size_t n;
+  bool ok;
+
+  if(!isdir(fd) || cnt < 0)
+    return -1;
+  if(cnt > GETDENTS_MAX)
+    cnt = GETDENTS_MAX;
+  kents = malloc(cnt * sizeof *kents);
+  if(kents == NULL && cnt > 0)
+    return -1;
+  dir = dir_open(inode_reopen(file_get_inode(fd_file(fd))));
+  if(dir == NULL){
+    free(kents);
+    return -1;
+  }
+  n = dir_getdents(dir, kents, cnt);
+  dir_close(dir);
+  ok = copy_out(ents, kents, n * sizeof *kents);
+  free(kents);
+  if(!ok)
+    exit(-1);
+  return n;
+}
+
+/* Copies the IOVCNT-element iovec array at user address UIOV
+   into KIOV, checking each buffer it describes.  Returns false
+   if IOVCNT is out of range. */
+static bool
+copy_in_iovec (struct iovec *kiov, const struct iovec *uiov, int iovcnt)
+{
+  int i;
+
+  if (iovcnt < 0 || iovcnt > IOV_MAX)
+    return false;
+  if (!copy_in (kiov, uiov, iovcnt * sizeof *kiov))
+    exit (-1);
+  for (i = 0; i < iovcnt; i++)
+    check_user_buffer (kiov[i].iov_base, kiov[i].iov_len);
+  return true;
+}
+
+int readv (int fd, const struct iovec *iov, int iovcnt){
+  struct iovec kiov[IOV_MAX];
+  int i, total = 0;
+
+  if(!copy_in_iovec(kiov, iov, iovcnt))
+    return -1;
+  for(i = 0; i < iovcnt; i++){
+    int n = read(fd, kiov[i].iov_base, kiov[i].iov_len);
+    if(n < 0)
+      return total > 0 ? total : -1;
+    total += n;
+    if((size_t) n < kiov[i].iov_len)
+      break;
+  }
+  return total;
+}
+
+int writev (int fd, const struct iovec *iov, int iovcnt){
+  struct iovec kiov[IOV_MAX];
+  int i, total = 0;
+
+  if(!copy_in_iovec(kiov, iov, iovcnt))
+    return -1;
+  for(i = 0; i < iovcnt; i++){
+    int n = write(fd, kiov[i].iov_base, kiov[i].iov_len);
+    if(n < 0)
+      return total > 0 ? total : -1;
+    total += n;
+    if((size_t) n < kiov[i].iov_len)
+      break;
+  }
+  return total;
+}
+
+/* OFFSET is unsigned but off_t is not, so offsets past INT_MAX
+   are refused rather than turned negative. */
+int pread (int fd, void *buffer, unsigned size, unsigned offset){
+  struct file *file = fd_file(fd);
+  if(file == NULL || file_is_pipe(file) || offset > INT_MAX)
+    return -1;
+  return file_read_at(file, buffer, size, offset);
+}
+
+int pwrite (int fd, const void *buffer, unsigned size, unsigned offset){
+  struct file *file = fd_file(fd);
+  if(file == NULL || file_is_pipe(file) || inode_is_dir(file_get_inode(file))
+     || offset > INT_MAX)
+    return -1;
+  return file_write_at(file, buffer, size, offset);
+}
+
+/* Copies up to SIZE bytes from IN_FD, starting at its current
+   position, to OUT_FD, which may be the console.  The data goes
+   from the buffer cache through one kernel page and never
+   visits user memory.  Advances both file positions and returns
+   the number of bytes copied, or -1 if either fd is bad.
+   Pipes are refused, since they could wait with filesys_lock
+   held.  Called with filesys_lock held, which is dropped while
+   each chunk goes to the console. */
+int sendfile (int out_fd, int in_fd, unsigned size){
+  struct file *in = fd_file(in_fd), *out = NULL;
+  int total = 0;
+  void *page;
+
+  if(in == NULL || file_is_pipe(in) || inode_is_dir(file_get_inode(in)))
+    return -1;
+  if(out_fd != 1){
+    out = fd_file(out_fd);
+    if(out == NULL || file_is_pipe(out) || inode_is_dir(file_get_inode(out)))
+      return -1;
+  }
+  page = palloc_get_page(0);
+  if(page == NULL)
+    return -1;
+
+  while(size > 0){
+    off_t chunk = size < PGSIZE ? size : PGSIZE;
+    off_t bytes_read = file_read(in, page, chunk);
+    off_t bytes_written;
+    if(bytes_read <= 0)
+      break;
+    if(out == NULL){
+      /* putbuf() may wait for room in the serial queue, which
+         must not happen with filesys_lock held. */
+      lock_release(&filesys_lock);
+      putbuf(page, bytes_read);
+      lock_acquire(&filesys_lock);
+      bytes_written = bytes_read;
+    }
+    else
+      bytes_written = file_write(out, page, bytes_read);
+    total += bytes_written;
+    if(bytes_written < bytes_read){
+      /* Leave IN positioned just past what was copied. */
+      file_seek(in, file_tell(in) - (bytes_read - bytes_written));
+      break;
+    }
+    size -= bytes_read;
+  }
+  palloc_free_page(page);
+  return total;
+}
+
+/* Makes the lowest free fd refer to the same open file as FD,
+   sharing its position.  Returns the new fd, or -1 on error.
+   The console descriptors 0 and 1 are not open files and cannot
+   be duplicated. */
+int dup (int fd){
+  struct file *file = fd_file(fd);
+  int new_fd;
+
+  if(file == NULL)
+    return -1;
+  new_fd = fd_alloc(&thread_current()->fdt, file_dup(file));
+  if(new_fd < 0)
+    file_close(file);
+  return new_fd;
+}
+
+/* Makes NEW_FD refer to the same open file as OLD_FD, closing
+   whatever NEW_FD had open first.  Returns NEW_FD, or -1 on
+   error.  As with dup(), neither fd may be 0 or 1. */
+int dup2 (int old_fd, int new_fd){
+  struct fd_table *fdt = &thread_current()->fdt;
+  struct file *file = fd_file(old_fd);
+
+  if(file == NULL || new_fd < FD_MIN || new_fd >= FD_MAX)
+    return -1;
+  if(new_fd == old_fd)
+    return new_fd;
+  file_close(fd_remove(fdt, new_fd));
+  if(!fd_install(fdt, new_fd, file_dup(file))){
+    file_close(file);
+    return -1;
+  }
+  return new_fd;
+}
+
+/* Copies a snapshot of the kernel's counters to ST.  The
+   snapshot is built in a heap buffer because it is too big for
+   the kernel stack.  Returns false if out of memory. */
+bool stats (struct kstats *st){
+  struct kstats *k = malloc(sizeof *k);
+
+  if(k == NULL)
+    return false;
+  memset(k, 0, sizeof *k);
+  thread_get_stats(k);
+  bc_get_stats(k);
+  dc_get_stats(k);
+  process_get_stats(k);
+  swap_get_stats(k);
+  block_get_stats(k);
+  if(!copy_out(st, k, sizeof *k)){
+    free(k);
+    exit(-1);
+  }
+  free(k);
+  return true;
+}
+
+/* Lowest address the heap may grow to: the stack may grow down
+   to 8 MB below PHYS_BASE, as in verify_stack(). */
+#define HEAP_LIMIT ((uint8_t *) PHYS_BASE - 0x800000)
+
+/* Largest a process's heap may grow, in bytes. */
+#define HEAP_MAX (32 * 1024 * 1024)
+
+/* Drops the heap page at UPAGE, if it was ever touched: its
+   frame or swap slot, and its vm_entry. */
+static void release_heap_page(void *upage){
+  struct thread *t = thread_current();
+  struct vm_entry *vme = find_vme(upage);
+  void *kaddr;
+
+  if(vme == NULL)
+    return;
+  if(vme->is_loaded){
+    kaddr = pagedir_get_page(t->pagedir, upage);
+    if(kaddr != NULL){
+      pagedir_clear_page(t->pagedir, upage);
+      free_page(kaddr);
+    }
+    else
+      swap_free(vme->swap_slot);
+  }
+  delete_vme(&t->vm, vme);
+}
+
+/* Moves the end of the heap by INCREMENT bytes and returns its
+   old end, or (void *) -1 if the heap would shrink below its
+   start, grow past HEAP_MAX, or run into the stack area or
+   another mapping.  Growing only moves the end: the page fault
+   handler gives each new page a VM_ANON entry, zeroed, when it
+   is first touched (see expand_heap()).  Pages the heap shrinks
+   away from are freed at once. */
+void *sbrk (intptr_t increment){
+  struct thread *t = thread_current();
+  uint8_t *start = t->heap_start, *old_brk = t->brk, *new_brk, *upage;
+  uint8_t *limit;
+
+  if(old_brk == NULL)
+    return (void *) -1;
+  limit = (uintptr_t) (HEAP_LIMIT - start) > HEAP_MAX ? start + HEAP_MAX : HEAP_LIMIT;
+  if(increment >= 0 ? (uintptr_t) increment > (uintptr_t) (limit - old_brk)
+     : (uintptr_t) 0 - (uintptr_t) increment > (uintptr_t) (old_brk - start))
+    return (void *) -1;
+  new_brk = old_brk + increment;
+
+  for(upage = pg_round_up(old_brk); upage < new_brk; upage += PGSIZE)
+    if(find_vme(upage) != NULL)
+      return (void *) -1;
+  for(upage = pg_round_up(new_brk); upage < old_brk; upage += PGSIZE)
+    release_heap_page(upage);
+
+  t->brk = new_brk;
+  return old_brk;
+}
+
+/* Creates a pipe and stores fds for its read and write ends in
+   FDS[0] and FDS[1].  If FLAGS includes PIPE_NONBLOCK, I/O on
+   either end fails instead of waiting.  If it includes
+   PIPE_CLOEXEC, both ends are closed on exec.  Returns false if
+   FLAGS is bad or memory or fds run out. */
+bool pipe2 (int *fds, int flags){
+  struct fd_table *fdt = &thread_current()->fdt;
+  bool nonblock = (flags & PIPE_NONBLOCK) != 0;
+  struct file *read_end, *write_end;
+  struct pipe *p;
+  int kfds[2];
+
+  if((flags & ~(PIPE_NONBLOCK | PIPE_CLOEXEC)) != 0)
+    return false;
+  p = pipe_create();
+  if(p == NULL)
+    return false;
+  read_end = file_open_pipe(p, false, nonblock);
+  write_end = file_open_pipe(p, true, nonblock);
+  if(read_end == NULL || write_end == NULL){
+    file_close(read_end);
+    file_close(write_end);
+    return false;
+  }
+
+  kfds[0] = fd_alloc(fdt, read_end);
+  kfds[1] = kfds[0] < 0 ? -1 : fd_alloc(fdt, write_end);
+  if(kfds[1] < 0){
+    if(kfds[0] >= 0)
+      fd_remove(fdt, kfds[0]);
+    file_close(read_end);
+    file_close(write_end);
+    return false;
+  }
+  if((flags & PIPE_CLOEXEC) != 0){
+    fd_set_cloexec(fdt, kfds[0], true);
+    fd_set_cloexec(fdt, kfds[1], true);
+  }
+  /* The fds are closed at exit if this fails. */
+  if(!copy_out(fds, kfds, sizeof kfds))
+    exit(-1);
+  return true;
+}
+
+/* Sets the calling process's console input mode to MODE, TTY_RAW
+   or TTY_LINE, and returns the old mode, or -1 if MODE is bad. */
+int ttymode (int mode){
+  struct thread *cur = thread_current();
+  int old_mode = cur->tty_mode;
+
+  if(mode != TTY_RAW && mode != TTY_LINE)
+    return -1;
+  cur->tty_mode = mode;
+  return old_mode;
+}
+
+/* Returns the number of bytes of console input that read() on
+   STDIN_FILENO can return without waiting, in TTY_RAW mode. */
+int ttypoll (void){
+  return input_poll();
+}
+
+/* Copies the resource use of the calling process, if WHO is
+   RUSAGE_SELF, or of its exited children and their descendants,
+   if WHO is RUSAGE_CHILDREN, into RU.  Returns false if WHO is
+   bad. */
+bool getrusage (int who, struct rusage *ru){
+  struct thread *cur = thread_current();
+  struct rusage k;
+  enum intr_level old_level;
+
+  if(who != RUSAGE_SELF && who != RUSAGE_CHILDREN)
+    return false;
+  /* The timer interrupt updates the tick counters. */
+  old_level = intr_disable();
+  k = who == RUSAGE_SELF ? cur->ru : cur->child_ru;
+  intr_set_level(old_level);
+  if(!copy_out(ru, &k, sizeof k))
+    exit(-1);
+  return true;
+}
+
+/* Marks FD to be closed on exec if FLAG is 1, or to be passed
+   on if FLAG is 0.  If FLAG is -1, only reports the setting.
+   Returns the old setting, 0 or 1, or -1 if FD is not open or
+   FLAG is bad. */
+int cloexec (int fd, int flag){
+  struct fd_table *fdt = &thread_current()->fdt;
+  int old_flag;
+
+  if(fd_file(fd) == NULL || flag < -1 || flag > 1)
+    return -1;
+  old_flag = fd_get_cloexec(fdt, fd);
+  if(flag >= 0)
+    fd_set_cloexec(fdt, fd, flag);
+  return old_flag;
+}
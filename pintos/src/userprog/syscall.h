@@ -1,7 +1,12 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 void syscall_init (void);
+bool copy_in (void *dst, const void *usrc, size_t size);
+bool copy_out (void *udst, const void *src, size_t size);
 struct lock filesys_lock;
 
 #endif /* userprog/syscall.h */
@@ -1,3 +1,6 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
 #include <list.h>
 #include "vm/page.h"
 #include "threads/palloc.h"
@@ -13,4 +16,6 @@ struct page* alloc_page(enum palloc_flags flags);
 void free_page(void *kaddr);
 void free_all(void);
 void __free_page(struct page* page);
-void try_to_free_pages (enum palloc_flags flags);
\ No newline at end of file
+void try_to_free_pages (enum palloc_flags flags);
+
+#endif /* vm/frame.h */
@@ -15,7 +15,7 @@ hash_init(vm, vm_hash_func, vm_less_func, NULL);
 
 static unsigned vm_hash_func (const struct hash_elem *e, void *aux){
 struct vm_entry *v = hash_entry(e, struct vm_entry, elem);
-return hash_int(v->vaddr);
+return hash_ptr(v->vaddr);
 }
 
 static bool vm_less_func (const struct hash_elem *a, const struct hash_elem *b, void *aux){
@@ -30,8 +30,20 @@ struct vm_entry *v = hash_entry(e, struct vm_entry, elem);
 free(v);
 }
 
+/* Returns true if VADDR is in the current process's sbrk() heap,
+   past the page it shares with the last segment.  Only VM_ANON
+   entries, made as the heap is touched, may go there. */
+bool is_heap_vaddr (const void *vaddr){
+struct thread *t = thread_current();
+return t->brk != NULL && vaddr >= pg_round_up(t->heap_start)
+       && vaddr < pg_round_up(t->brk);
+}
+
 bool insert_vme (struct hash *vm, struct vm_entry *vme){
-struct hash_elem *e = hash_insert(vm, &vme->elem);
+struct hash_elem *e;
+if(vme->type != VM_ANON && is_heap_vaddr(vme->vaddr))
+return false;
+e = hash_insert(vm, &vme->elem);
 if(e == NULL)
 return true;
 return false;
@@ -46,25 +58,15 @@ return true;
 }
 
 struct vm_entry *find_vme (void *vaddr){
-  size_t i;
   struct hash *h = &thread_current()->vm;
-  uint32_t pa = pg_round_down(vaddr);
-  for (i = 0; i < h->bucket_cnt; i++) 
-    {
-      struct list *bucket = &h->buckets[i];
-      struct list_elem *elem, *next;
-
-      for (elem = list_begin (bucket); elem != list_end (bucket); elem = list_next (elem)) 
-        {
-          
-          struct hash_elem *e = list_entry (elem, struct hash_elem, list_elem);
-          struct vm_entry *v = hash_entry (e, struct vm_entry, elem);
-          if(v->vaddr == pa)
-          return v;
-        }
-
-    }
+  struct vm_entry vme;
+  struct hash_elem *e;
+  /* Kernel threads never call vm_init(). */
+  if(h->buckets == NULL)
     return NULL;
+  vme.vaddr = pg_round_down(vaddr);
+  e = hash_find(h, &vme.elem);
+  return e != NULL ? hash_entry(e, struct vm_entry, elem) : NULL;
 }
 
 void vm_destroy (struct hash *vm){
@@ -1,7 +1,11 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
 #define VM_BIN 0
 #define VM_FILE 1
 #define VM_ANON 2
 #define VM_STACK 3
+#define VM_SHM 4
 
 #include "lib/kernel/hash.h"
 
@@ -39,6 +43,9 @@ struct page{
 bool insert_vme (struct hash *vm, struct vm_entry *vme);
 bool delete_vme (struct hash *vm, struct vm_entry *vme);
 struct vm_entry *find_vme (void *vaddr);
+bool is_heap_vaddr (const void *vaddr);
 void vm_destroy (struct hash *vm);
 void vm_init (struct hash *vm);
-bool load_file (void* kaddr, struct vm_entry *vme);
\ No newline at end of file
+bool load_file (void* kaddr, struct vm_entry *vme);
+
+#endif /* vm/page.h */
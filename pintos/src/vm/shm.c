@@ -0,0 +1,290 @@
+#include "vm/shm.h"
+#include <debug.h>
+#include <ipc.h>
+#include <list.h>
+#include <round.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+
+/* Shared memory segments.
+
+   A segment is a set of zeroed user pages named by an integer
+   key.  Every process that maps the key sees the same physical
+   pages, so data written by one is visible to the others without
+   a copy or a system call.  Each mapped page has a VM_SHM
+   vm_entry in the process's supplemental page table and is
+   installed in its page directory up front, so it never faults.
+
+   Segment pages are not on the LRU list and are never evicted:
+   the frame table tracks one owner per frame, and a shared frame
+   has many.  This pins at most SHM_MAX_PAGES pages per segment,
+   and SHM_TOTAL_PAGES pages for all segments together.  A
+   segment is freed when its last mapping goes away. */
+
+/* A shared memory segment. */
+struct shm_segment
+  {
+    int key;                    /* Name given to shm_map(). */
+    size_t page_cnt;            /* Number of pages. */
+    void **pages;               /* Kernel addresses of the pages. */
+    int map_cnt;                /* Number of mappings. */
+    struct list_elem elem;      /* Element in segments. */
+  };
+
+/* One process's mapping of a segment. */
+struct shm_mapping
+  {
+    struct shm_segment *seg;    /* Segment mapped. */
+    uint8_t *addr;              /* First user page. */
+    size_t page_cnt;            /* Number of pages mapped. */
+    struct list_elem elem;      /* Element in thread's shm_list. */
+  };
+
+/* All segments, the number of pages they hold, and a lock that
+   protects both and each segment's MAP_CNT. */
+static struct list segments;
+static size_t segment_page_cnt;
+static struct lock shm_lock;
+
+/* Initializes the shared memory segment table. */
+void
+shm_init (void) 
+{
+  list_init (&segments);
+  lock_init (&shm_lock);
+}
+
+/* Returns the segment named KEY, or a null pointer if there is
+   none. */
+static struct shm_segment *
+find_segment (int key) 
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&segments); e != list_end (&segments);
+       e = list_next (e))
+    {
+      struct shm_segment *seg = list_entry (e, struct shm_segment, elem);
+      if (seg->key == key)
+        return seg;
+    }
+  return NULL;
+}
+
+/* Frees SEG and its pages, stopping at the first missing page. */
+static void
+free_segment (struct shm_segment *seg) 
+{
+  size_t i;
+
+  for (i = 0; i < seg->page_cnt && seg->pages[i] != NULL; i++)
+    palloc_free_page (seg->pages[i]);
+  free (seg->pages);
+  free (seg);
+}
+
+/* Creates a segment named KEY of PAGE_CNT zeroed pages and adds
+   it to the table.  Returns the new segment, or a null pointer if
+   memory is exhausted. */
+static struct shm_segment *
+create_segment (int key, size_t page_cnt) 
+{
+  struct shm_segment *seg = malloc (sizeof *seg);
+  size_t i;
+
+  if (seg == NULL)
+    return NULL;
+  seg->key = key;
+  seg->page_cnt = page_cnt;
+  seg->map_cnt = 0;
+  seg->pages = calloc (page_cnt, sizeof *seg->pages);
+  if (seg->pages == NULL)
+    {
+      free (seg);
+      return NULL;
+    }
+  for (i = 0; i < page_cnt; i++)
+    {
+      seg->pages[i] = palloc_get_page (PAL_USER | PAL_ZERO);
+      if (seg->pages[i] == NULL)
+        {
+          /* Make room by evicting a process page, once. */
+          try_to_free_pages (PAL_USER);
+          seg->pages[i] = palloc_get_page (PAL_USER | PAL_ZERO);
+        }
+      if (seg->pages[i] == NULL)
+        {
+          free_segment (seg);
+          return NULL;
+        }
+    }
+  list_push_back (&segments, &seg->elem);
+  return seg;
+}
+
+/* Removes the first PAGE_CNT pages of the mapping at ADDR from
+   the current process's page directory and page table. */
+static void
+unmap_pages (uint8_t *addr, size_t page_cnt) 
+{
+  struct thread *t = thread_current ();
+  size_t i;
+
+  for (i = 0; i < page_cnt; i++)
+    {
+      struct vm_entry *vme = find_vme (addr + i * PGSIZE);
+
+      ASSERT (vme != NULL && vme->type == VM_SHM);
+      pagedir_clear_page (t->pagedir, vme->vaddr);
+      delete_vme (&t->vm, vme);
+    }
+}
+
+/* Drops a mapping of SEG, freeing it if that was the last. */
+static void
+release_segment (struct shm_segment *seg) 
+{
+  lock_acquire (&shm_lock);
+  if (--seg->map_cnt == 0)
+    {
+      list_remove (&seg->elem);
+      segment_page_cnt -= seg->page_cnt;
+    }
+  else
+    seg = NULL;
+  lock_release (&shm_lock);
+
+  if (seg != NULL)
+    free_segment (seg);
+}
+
+/* Maps SIZE bytes of the shared memory segment named KEY into the
+   current process at ADDR, which must be page-aligned, creating
+   the segment if it does not exist yet.  Sizes are rounded up to
+   whole pages.  An existing segment must be at least SIZE bytes
+   long.  Returns ADDR, or a null pointer if ADDR is bad, the
+   range overlaps memory already in use, SIZE is 0 or more than
+   SHM_MAX_PAGES pages, a new segment would take the pages in all
+   segments past SHM_TOTAL_PAGES, or memory is exhausted. */
+void *
+shm_map (int key, void *addr_, size_t size) 
+{
+  struct thread *t = thread_current ();
+  uint8_t *addr = addr_;
+  struct shm_segment *seg;
+  struct shm_mapping *m;
+  size_t page_cnt, i;
+
+  if (addr == NULL || pg_ofs (addr) != 0 || size == 0
+      || size > SHM_MAX_PAGES * PGSIZE)
+    return NULL;
+  page_cnt = DIV_ROUND_UP (size, PGSIZE);
+  if ((uintptr_t) addr + page_cnt * PGSIZE > (uintptr_t) PHYS_BASE
+      || (uintptr_t) addr + page_cnt * PGSIZE < (uintptr_t) addr)
+    return NULL;
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return NULL;
+
+  lock_acquire (&shm_lock);
+  seg = find_segment (key);
+  if (seg == NULL && page_cnt <= SHM_TOTAL_PAGES - segment_page_cnt)
+    {
+      seg = create_segment (key, page_cnt);
+      if (seg != NULL)
+        segment_page_cnt += page_cnt;
+    }
+  if (seg == NULL || seg->page_cnt < page_cnt)
+    {
+      lock_release (&shm_lock);
+      free (m);
+      return NULL;
+    }
+  seg->map_cnt++;
+  lock_release (&shm_lock);
+
+  for (i = 0; i < page_cnt; i++)
+    {
+      struct vm_entry *vme = malloc (sizeof *vme);
+      void *upage = addr + i * PGSIZE;
+
+      if (vme != NULL)
+        {
+          vme->type = VM_SHM;
+          vme->vaddr = upage;
+          vme->writable = true;
+          vme->is_loaded = true;
+          vme->file = NULL;
+        }
+      if (vme == NULL || pagedir_get_page (t->pagedir, upage) != NULL
+          || !insert_vme (&t->vm, vme))
+        {
+          free (vme);
+          break;
+        }
+      if (!pagedir_set_page (t->pagedir, upage, seg->pages[i], true))
+        {
+          delete_vme (&t->vm, vme);
+          break;
+        }
+    }
+  if (i < page_cnt)
+    {
+      unmap_pages (addr, i);
+      release_segment (seg);
+      free (m);
+      return NULL;
+    }
+
+  m->seg = seg;
+  m->addr = addr;
+  m->page_cnt = page_cnt;
+  list_push_back (&t->shm_list, &m->elem);
+  return addr;
+}
+
+/* Unmaps the shared memory mapping that starts at ADDR in the
+   current process.  Returns false if there is no such mapping. */
+bool
+shm_unmap (void *addr) 
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&t->shm_list); e != list_end (&t->shm_list);
+       e = list_next (e))
+    {
+      struct shm_mapping *m = list_entry (e, struct shm_mapping, elem);
+      if (m->addr == addr)
+        {
+          list_remove (&m->elem);
+          unmap_pages (m->addr, m->page_cnt);
+          release_segment (m->seg);
+          free (m);
+          return true;
+        }
+    }
+  return false;
+}
+
+/* Unmaps all of the current process's shared memory mappings.
+   Must be called before the process's page directory is
+   destroyed, which would otherwise free the shared pages. */
+void
+shm_unmap_all (void) 
+{
+  struct thread *t = thread_current ();
+
+  while (!list_empty (&t->shm_list))
+    {
+      struct shm_mapping *m = list_entry (list_front (&t->shm_list),
+                                          struct shm_mapping, elem);
+      shm_unmap (m->addr);
+    }
+}
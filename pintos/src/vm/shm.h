@@ -0,0 +1,12 @@
+#ifndef VM_SHM_H
+#define VM_SHM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+void shm_init (void);
+void *shm_map (int key, void *addr, size_t size);
+bool shm_unmap (void *addr);
+void shm_unmap_all (void);
+
+#endif /* vm/shm.h */
@@ -5,8 +5,11 @@
 #include "threads/vaddr.h"
 #include <bitmap.h>
 #include "devices/block.h"
+#include <kstats.h>
 
 struct bitmap *b;
+static size_t next_slot;  /* where the next free slot search starts (next fit) */
+static uint64_t in_cnt, out_cnt;  /* pages swapped in and out */
 
 void swap_init(void){
  b = bitmap_create(1024);
@@ -26,6 +29,7 @@ void swap_in(size_t used_index, void* kaddr){
    
     memcpy(kaddr, buf_, PGSIZE);
     free(buf_);
+    in_cnt++;
 
 }
 size_t swap_out(void* kaddr){
@@ -33,14 +37,26 @@ size_t swap_out(void* kaddr){
     struct block *block;
     void* addr = kaddr;
     int i;
-    sector = bitmap_scan(b, 0, 1, false);
+    sector = bitmap_scan_next_fit(b, next_slot, 1, false);
     if(sector == BITMAP_ERROR)
     return BITMAP_ERROR;
+    next_slot = (sector + 1) % bitmap_size(b);
     block = block_get_role(BLOCK_SWAP);
     bitmap_mark(b, sector);
     for(i=0;i<8;i++){
     block_write(block, sector * 8 + i, addr);
     addr += BLOCK_SECTOR_SIZE;
     }
+    out_cnt++;
     return sector;
+}
+
+/* Releases swap slot USED_INDEX without reading it back. */
+void swap_free(size_t used_index){
+    bitmap_reset(b, used_index);
+}
+
+void swap_get_stats(struct kstats *st){
+    st->swap_ins = in_cnt;
+    st->swap_outs = out_cnt;
 }
\ No newline at end of file
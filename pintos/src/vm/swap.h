@@ -1,5 +1,14 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
 #include <stdio.h>
  
 void swap_init(void);
 void swap_in(size_t used_index, void *kaddr);
-size_t swap_out(void *kaddr);
\ No newline at end of file
+size_t swap_out(void *kaddr);
+void swap_free(size_t used_index);
+
+struct kstats;
+void swap_get_stats(struct kstats *st);
+
+#endif /* vm/swap.h */